@@ -0,0 +1,524 @@
+#include "assembler.hpp"
+#include <array>
+#include <charconv>
+#include <cstdint>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+namespace pseu {
+
+    namespace {
+        using namespace std::string_view_literals;
+
+        constexpr std::array<std::string_view, 16> reg64{
+                "rax", "rcx", "rdx", "rbx", "rsp", "rbp", "rsi", "rdi",
+                "r8", "r9", "r10", "r11", "r12", "r13", "r14", "r15"
+        };
+        constexpr std::array<std::string_view, 16> reg32{
+                "eax", "ecx", "edx", "ebx", "esp", "ebp", "esi", "edi",
+                "r8d", "r9d", "r10d", "r11d", "r12d", "r13d", "r14d", "r15d"
+        };
+        constexpr std::array<std::string_view, 16> reg16{
+                "ax", "cx", "dx", "bx", "sp", "bp", "si", "di",
+                "r8w", "r9w", "r10w", "r11w", "r12w", "r13w", "r14w", "r15w"
+        };
+        constexpr std::array<std::string_view, 16> reg8{
+                "al", "cl", "dl", "bl", "spl", "bpl", "sil", "dil",
+                "r8b", "r9b", "r10b", "r11b", "r12b", "r13b", "r14b", "r15b"
+        };
+
+        /// @brief NASM mnemonic of each x86::Op; the conditional ones without their suffix.
+        constexpr std::array<std::string_view, 42> mnemonics{
+                "add", "or", "adc", "sbb", "and", "sub", "xor", "cmp",
+                "not", "neg", "mul", "div", "idiv", "inc", "dec",
+                "rol", "ror", "shl", "shr", "sar",
+                "mov", "movzx", "movsx", "lea", "test", "xchg", "imul",
+                "push", "pop", "jmp", "call", "j", "set", "cmov",
+                "ret", "syscall", "cqo", "cdq", "nop", "movsb", "rep movsb", "rep stosb"
+        };
+
+        // an instruction added to x86::Op must be added here too
+        static_assert(mnemonics.size() == static_cast<std::size_t>(x86::Op::rep_stosb) + 1);
+
+        /// @brief Condition-code suffixes accepted, aliases included.
+        constexpr std::array<std::pair<std::string_view, std::uint8_t>, 30> conditions{{
+                {"o", 0}, {"no", 1}, {"b", 2}, {"c", 2}, {"nae", 2}, {"ae", 3}, {"nb", 3}, {"nc", 3},
+                {"e", 4}, {"z", 4}, {"ne", 5}, {"nz", 5}, {"be", 6}, {"na", 6}, {"a", 7}, {"nbe", 7},
+                {"s", 8}, {"ns", 9}, {"p", 10}, {"np", 11}, {"l", 12}, {"nge", 12}, {"ge", 13}, {"nl", 13},
+                {"le", 14}, {"ng", 14}, {"g", 15}, {"nle", 15}, {"pe", 10}, {"po", 11}
+        }};
+
+        std::string_view trim(std::string_view s) {
+            while (!s.empty() && (s.front() == ' ' || s.front() == '\t' || s.front() == '\r'))
+                s.remove_prefix(1);
+            while (!s.empty() && (s.back() == ' ' || s.back() == '\t' || s.back() == '\r'))
+                s.remove_suffix(1);
+            return s;
+        }
+
+        bool is_ident_char(char c) {
+            return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9')
+                   || c == '_' || c == '.' || c == '$' || c == '@';
+        }
+
+        /// @brief Split on commas outside brackets and quotes.
+        void split_operands(std::string_view s, std::vector<std::string_view> &out) {
+            out.clear();
+            int depth = 0;
+            char quote = 0;
+            std::size_t begin = 0;
+            for (std::size_t i = 0; i < s.size(); ++i) {
+                const char c = s[i];
+                if (quote) {
+                    if (c == quote)
+                        quote = 0;
+                } else if (c == '"' || c == '\'') {
+                    quote = c;
+                } else if (c == '[') {
+                    ++depth;
+                } else if (c == ']') {
+                    --depth;
+                } else if (c == ',' && depth == 0) {
+                    out.push_back(trim(s.substr(begin, i - begin)));
+                    begin = i + 1;
+                }
+            }
+            if (!trim(s.substr(begin)).empty() || !out.empty())
+                out.push_back(trim(s.substr(begin)));
+        }
+
+        std::optional<x86::Operand> parse_reg(std::string_view s) {
+            static const auto table = [] {
+                std::unordered_map<std::string_view, x86::Operand> t;
+                for (std::uint8_t i = 0; i < 16; ++i) {
+                    const auto r = static_cast<x86::Gpr>(i);
+                    t.emplace(reg64[i], x86::reg(r, 8));
+                    t.emplace(reg32[i], x86::reg(r, 4));
+                    t.emplace(reg16[i], x86::reg(r, 2));
+                    t.emplace(reg8[i], x86::reg(r, 1));
+                }
+                return t;
+            }();
+            if (s.size() < 2 || s.size() > 4)
+                return std::nullopt;
+            const auto it = table.find(s);
+            return it == table.end() ? std::nullopt : std::optional{it->second};
+        }
+
+        /// @brief Instruction of a mnemonic, with the condition of <code>jcc</code>/<code>setcc</code>/<code>cmovcc</code>.
+        std::optional<std::pair<x86::Op, x86::Cond>> parse_mnemonic(std::string_view s) {
+            static const auto table = [] {
+                std::unordered_map<std::string_view, x86::Op> t;
+                for (std::size_t i = 0; i < mnemonics.size(); ++i) {
+                    const auto op = static_cast<x86::Op>(i);
+                    if (op != x86::Op::jcc && op != x86::Op::setcc && op != x86::Op::cmovcc)
+                        t.emplace(mnemonics[i], op);
+                }
+                t.emplace("sal", x86::Op::shl);
+                return t;
+            }();
+            if (const auto it = table.find(s); it != table.end())
+                return std::pair{it->second, x86::Cond::o};
+            for (auto [prefix, op]: {std::pair{"j"sv, x86::Op::jcc}, {"set"sv, x86::Op::setcc},
+                                     {"cmov"sv, x86::Op::cmovcc}}) {
+                if (!s.starts_with(prefix))
+                    continue;
+                for (const auto &[k, v]: conditions)
+                    if (k == s.substr(prefix.size()))
+                        return std::pair{op, static_cast<x86::Cond>(v)};
+            }
+            return std::nullopt;
+        }
+
+        /// @brief Hash allowing <code>std::string_view</code> lookups without a temporary string.
+        struct NameHash final {
+            using is_transparent = void;
+
+            std::size_t operator()(std::string_view s) const noexcept { return std::hash<std::string_view>{}(s); }
+        };
+
+        template<typename T>
+        using NameMap = std::unordered_map<std::string, T, NameHash, std::equal_to<>>;
+
+        /// @brief Text front end of x86::Encoder.
+        class Assembler final {
+        public:
+            x86::Module run(std::string_view source) {
+                std::size_t pos = 0;
+                while (pos <= source.size()) {
+                    auto end = source.find('\n', pos);
+                    if (end == std::string_view::npos)
+                        end = source.size();
+                    ++line;
+                    statement(source.substr(pos, end - pos));
+                    pos = end + 1;
+                }
+                return finish();
+            }
+
+        private:
+            x86::Encoder enc;
+            NameMap<std::uint32_t> symbols;
+            NameMap<std::int64_t> constants;
+            std::unordered_set<std::string> globals;
+            std::string scope;     // last non-local label
+            std::string qualified; // scratch for qualify()
+            std::vector<std::string_view> fields;
+            std::vector<x86::Operand> ops;
+            std::vector<std::uint8_t> bytes;
+            x86::Section section = x86::Section::text;
+            std::size_t line = 0;
+
+            [[noreturn]] void fail(const std::string &what) const {
+                throw std::runtime_error("asm line " + std::to_string(line) + ": " + what);
+            }
+
+            /// @brief Run an encoder call, reporting its error at the current line.
+            template<typename F>
+            void encoding(F &&f) {
+                try {
+                    f();
+                } catch (const std::runtime_error &e) {
+                    fail(e.what());
+                }
+            }
+
+            /// @brief Full name of a label; valid until the next call.
+            std::string_view qualify(std::string_view name) {
+                if (!name.starts_with('.'))
+                    return name;
+                qualified.assign(scope).append(name);
+                return qualified;
+            }
+
+            std::uint32_t symbol_index(std::string_view name) {
+                if (auto it = symbols.find(name); it != symbols.end())
+                    return it->second;
+                const auto index = enc.symbol(name);
+                symbols.emplace(std::string(name), index);
+                return index;
+            }
+
+            void define(std::string_view raw) {
+                if (!raw.starts_with('.'))
+                    scope = std::string(raw);
+                const auto name = qualify(raw);
+                if (constants.contains(name))
+                    fail("symbol '" + std::string(name) + "' redefined");
+                const auto index = symbol_index(name);
+                encoding([&] { enc.label(index); });
+            }
+
+            // ---- expressions ----
+
+            std::int64_t parse_number(std::string_view s) {
+                if (s.size() == 3 && s.front() == '\'' && s.back() == '\'')
+                    return static_cast<unsigned char>(s[1]);
+                std::uint64_t v = 0;
+                int base = 10;
+                if (s.size() > 2 && s[0] == '0' && (s[1] == 'x' || s[1] == 'X')) {
+                    s.remove_prefix(2);
+                    base = 16;
+                }
+                auto [p, ec] = std::from_chars(s.data(), s.data() + s.size(), v, base);
+                if (ec != std::errc{} || p != s.data() + s.size())
+                    fail("bad number '" + std::string(s) + "'");
+                return static_cast<std::int64_t>(v);
+            }
+
+            /// @brief <code>term (('+'|'-') term)*</code> over numbers, characters and symbols.
+            x86::Expr parse_expr(std::string_view s, bool allow_symbol = true) {
+                x86::Expr e;
+                bool negative = false;
+                s = trim(s);
+                if (!s.empty() && (s[0] == '-' || s[0] == '+')) {
+                    negative = s[0] == '-';
+                    s = trim(s.substr(1));
+                }
+                if (s.empty())
+                    fail("missing expression");
+                while (!s.empty()) {
+                    std::size_t n = 0;
+                    if (s[0] == '\'') {
+                        n = s.find('\'', 1);
+                        if (n == std::string_view::npos)
+                            fail("unterminated character");
+                        ++n;
+                    } else {
+                        while (n < s.size() && s[n] != '+' && s[n] != '-' && s[n] != ' ' && s[n] != '\t')
+                            ++n;
+                    }
+                    const auto term = s.substr(0, n);
+                    if (term.empty())
+                        fail("bad expression");
+
+                    if (term[0] == '\'' || (term[0] >= '0' && term[0] <= '9')) {
+                        const auto v = parse_number(term);
+                        e.value = negative ? e.value - v : e.value + v;
+                    } else {
+                        const auto name = qualify(term);
+                        if (auto c = constants.find(name); c != constants.end()) {
+                            e.value = negative ? e.value - c->second : e.value + c->second;
+                        } else {
+                            if (!allow_symbol)
+                                fail("'" + std::string(name) + "' is not a constant");
+                            if (negative || e.symbol >= 0)
+                                fail("unsupported relocation in '" + std::string(s) + "'");
+                            e.symbol = symbol_index(name);
+                        }
+                    }
+
+                    s = trim(s.substr(n));
+                    if (s.empty())
+                        break;
+                    if (s[0] != '+' && s[0] != '-')
+                        fail("bad expression near '" + std::string(s) + "'");
+                    negative = s[0] == '-';
+                    s = trim(s.substr(1));
+                }
+                return e;
+            }
+
+            // ---- operands ----
+
+            x86::Operand parse_operand(std::string_view s) {
+                x86::Operand o;
+                s = trim(s);
+                for (auto [kw, size]: {std::pair{"byte"sv, 1}, {"word"sv, 2}, {"dword"sv, 4}, {"qword"sv, 8}}) {
+                    if (s.starts_with(kw) && s.size() > kw.size() && !is_ident_char(s[kw.size()])) {
+                        o.size = static_cast<std::uint8_t>(size);
+                        s = trim(s.substr(kw.size()));
+                        break;
+                    }
+                }
+
+                if (s.starts_with('[')) {
+                    if (!s.ends_with(']'))
+                        fail("unterminated memory operand");
+                    o.kind = x86::Operand::Kind::mem;
+                    parse_address(trim(s.substr(1, s.size() - 2)), o);
+                    return o;
+                }
+
+                if (auto r = parse_reg(s))
+                    return *r;
+
+                o.kind = x86::Operand::Kind::imm;
+                o.expr = parse_expr(s);
+                return o;
+            }
+
+            void parse_address(std::string_view s, x86::Operand &o) {
+                if (s.starts_with("rel ") || s.starts_with("rel\t"))
+                    s = trim(s.substr(4));
+
+                std::string disp;
+                bool negative = false;
+                while (!s.empty()) {
+                    auto n = s.find_first_of("+-");
+                    // a leading sign belongs to the term that follows
+                    const auto term = trim(s.substr(0, n));
+                    if (!term.empty()) {
+                        const auto star = term.find('*');
+                        const auto reg = parse_reg(trim(term.substr(0, star)));
+                        if (reg && reg->size != 8)
+                            fail("address registers must be 64-bit");
+                        if (reg) {
+                            if (negative)
+                                fail("negative register in address");
+                            if (star != std::string_view::npos) {
+                                const auto scale = parse_number(trim(term.substr(star + 1)));
+                                if (scale != 1 && scale != 2 && scale != 4 && scale != 8)
+                                    fail("bad scale");
+                                if (o.index != x86::Gpr::none)
+                                    fail("two index registers");
+                                o.index = reg->reg;
+                                o.scale = static_cast<std::uint8_t>(scale);
+                            } else if (o.base == x86::Gpr::none) {
+                                o.base = reg->reg;
+                            } else if (o.index == x86::Gpr::none) {
+                                o.index = reg->reg;
+                            } else {
+                                fail("too many registers in address");
+                            }
+                        } else {
+                            if (!disp.empty() || negative)
+                                disp += negative ? '-' : '+';
+                            disp += term;
+                        }
+                    }
+                    if (n == std::string_view::npos)
+                        break;
+                    negative = s[n] == '-';
+                    s = s.substr(n + 1);
+                }
+                if (o.index == x86::Gpr::rsp)
+                    fail("rsp cannot be an index");
+                if (!disp.empty())
+                    o.expr = parse_expr(disp);
+            }
+
+            // ---- directives ----
+
+            void data(std::string_view directive, std::string_view items) {
+                if (section != x86::Section::data)
+                    fail("'" + std::string(directive) + "' outside .data");
+                const int width = directive == "db" ? 1 : directive == "dw" ? 2 : directive == "dd" ? 4 : 8;
+                bytes.clear();
+                split_operands(items, fields);
+                for (auto item: fields) {
+                    if (item.size() >= 2 && (item.front() == '"' || item.front() == '\'')
+                        && item.back() == item.front()) {
+                        if (width != 1)
+                            fail("strings are only allowed in db");
+                        for (auto c: item.substr(1, item.size() - 2))
+                            bytes.push_back(static_cast<std::uint8_t>(c));
+                        continue;
+                    }
+                    const auto v = parse_expr(item, false).value;
+                    for (int i = 0; i < width; ++i)
+                        bytes.push_back(static_cast<std::uint8_t>(static_cast<std::uint64_t>(v) >> (8 * i)));
+                }
+                enc.data(bytes);
+            }
+
+            void reserve(std::string_view directive, std::string_view count) {
+                if (section != x86::Section::bss)
+                    fail("'" + std::string(directive) + "' outside .bss");
+                const int width = directive == "resb" ? 1 : directive == "resw" ? 2 : directive == "resd" ? 4 : 8;
+                const auto n = parse_expr(count, false).value;
+                if (n < 0)
+                    fail("negative size");
+                enc.reserve(static_cast<std::uint64_t>(n) * width);
+            }
+
+            static bool is_data(std::string_view w) { return w == "db" || w == "dw" || w == "dd" || w == "dq"; }
+
+            static bool is_reserve(std::string_view w) {
+                return w == "resb" || w == "resw" || w == "resd" || w == "resq";
+            }
+
+            static std::pair<std::string_view, std::string_view> word(std::string_view s) {
+                std::size_t n = 0;
+                while (n < s.size() && s[n] != ' ' && s[n] != '\t')
+                    ++n;
+                return {s.substr(0, n), trim(s.substr(n))};
+            }
+
+            void statement(std::string_view s) {
+                // strip the comment, minding quotes
+                char quote = 0;
+                for (std::size_t i = 0; i < s.size(); ++i) {
+                    if (quote) {
+                        if (s[i] == quote)
+                            quote = 0;
+                    } else if (s[i] == '"' || s[i] == '\'') {
+                        quote = s[i];
+                    } else if (s[i] == ';') {
+                        s = s.substr(0, i);
+                        break;
+                    }
+                }
+                s = trim(s);
+                if (s.empty())
+                    return;
+
+                auto [first, rest] = word(s);
+
+                if (first.ends_with(':')) {
+                    first.remove_suffix(1);
+                    define(first);
+                    if (rest.empty())
+                        return;
+                    std::tie(first, rest) = word(rest);
+                }
+
+                if (first == "section") {
+                    if (rest == ".text")
+                        section = x86::Section::text;
+                    else if (rest == ".data")
+                        section = x86::Section::data;
+                    else if (rest == ".bss")
+                        section = x86::Section::bss;
+                    else
+                        fail("unknown section '" + std::string(rest) + "'");
+                    enc.section(section);
+                    return;
+                }
+                if (first == "global") {
+                    split_operands(rest, fields);
+                    for (auto name: fields)
+                        globals.emplace(name);
+                    return;
+                }
+                if (is_data(first))
+                    return data(first, rest);
+                if (is_reserve(first))
+                    return reserve(first, rest);
+
+                // "<name> equ|db|res* ..."
+                if (const auto [second, tail] = word(rest); !second.empty()) {
+                    if (second == "equ") {
+                        const std::string name(qualify(first));
+                        if (symbols.contains(name) || constants.contains(name))
+                            fail("symbol '" + name + "' redefined");
+                        const auto value = parse_expr(tail, false).value;
+                        constants.emplace(name, value);
+                        return;
+                    }
+                    if (is_data(second)) {
+                        define(first);
+                        return data(second, tail);
+                    }
+                    if (is_reserve(second)) {
+                        define(first);
+                        return reserve(second, tail);
+                    }
+                }
+
+                if (section != x86::Section::text)
+                    fail("instruction outside .text");
+
+                std::string_view name = first;
+                if (first == "rep") {
+                    auto [op, tail] = word(rest);
+                    name = op == "movsb" ? "rep movsb"sv : op == "stosb" ? "rep stosb"sv : "rep"sv;
+                    rest = tail;
+                }
+                const auto op = parse_mnemonic(name);
+                if (!op)
+                    fail("unsupported instruction '" + std::string(name) + "'");
+
+                ops.clear();
+                split_operands(rest, fields);
+                for (auto text: fields)
+                    ops.push_back(parse_operand(text));
+                encoding([&] { enc.instruction(op->first, ops, op->second); });
+            }
+
+            x86::Module finish() {
+                for (const auto &name: globals) {
+                    auto it = symbols.find(name);
+                    if (it == symbols.end())
+                        throw std::runtime_error("asm: global '" + name + "' is not defined");
+                    enc.global(it->second);
+                }
+                try {
+                    return enc.finish();
+                } catch (const std::runtime_error &e) {
+                    throw std::runtime_error("asm: " + std::string(e.what()));
+                }
+            }
+        };
+    }
+
+    x86::Module bench::assemble(std::string_view source) {
+        return Assembler{}.run(source);
+    }
+
+} // namespace pseu
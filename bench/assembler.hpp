@@ -0,0 +1,58 @@
+/**
+ * @file assembler.hpp
+ * @author JeongHan-Bae &lt;mastropseudo&#64;gmail.com&gt;
+ * @brief Assembler for the NASM subset of x86::NasmWriter, to check the encoder against.
+ *
+ * @license MIT
+ *
+ * @verbatim
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ * @endverbatim
+ */
+
+
+#pragma once
+
+#include <string_view>
+#include "x86.hpp"
+
+namespace pseu::bench {
+
+    /**
+     * @brief Assemble NASM source into a module.
+     *
+     * The compiler encodes through x86::Encoder directly; this parser of
+     * the text x86::NasmWriter writes checks that the two agree
+     * (<code>bench --check-encoder</code>). Its register, mnemonic and
+     * condition tables are its own, so a name the writer gets wrong does
+     * not assemble. Only what NasmWriter produces, and <code>equ</code>,
+     * is accepted: <code>section</code>, <code>global</code>,
+     * <code>db</code>, <code>resb</code>/<code>resq</code>, labels, and the
+     * instructions of x86::Op with register, immediate and
+     * <code>[base + index*scale + disp]</code> operands.
+     *
+     * @param source Assembly text.
+     * @return The assembled module.
+     *
+     * @throws std::runtime_error naming the line of the first unsupported
+     *         or malformed statement, or an undefined label.
+     */
+    x86::Module assemble(std::string_view source);
+
+} // namespace pseu::bench
@@ -0,0 +1,556 @@
+/**
+ * @file bench_main.cpp
+ * @author JeongHan-Bae &lt;mastropseudo&#64;gmail.com&gt;
+ * @brief Per-phase compile throughput benchmarks.
+ *
+ * @license MIT
+ *
+ * @verbatim
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ * @endverbatim
+ */
+
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <iostream>
+#include <limits>
+#include <new>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "assembler.hpp"
+#include "ast.hpp"
+#include "codegen.hpp"
+#include "frontend.hpp"
+#include "generator.hpp"
+#include "interp.hpp"
+#include "ir.hpp"
+#include "pipeline.hpp"
+#include "session.hpp"
+#include "x86.hpp"
+
+namespace {
+    using clock_type = std::chrono::steady_clock;
+
+    /// @brief Calls to the global operator new; the benchmark is single-threaded.
+    std::size_t allocations = 0;
+}
+
+/// @brief Counting replacement of the global allocation function (array and nothrow forms forward here).
+void *operator new(std::size_t size) {
+    ++allocations;
+    if (void *p = std::malloc(size ? size : 1))
+        return p;
+    throw std::bad_alloc();
+}
+
+void operator delete(void *p) noexcept {
+    std::free(p);
+}
+
+void operator delete(void *p, std::size_t) noexcept {
+    std::free(p);
+}
+
+namespace {
+
+    /**
+     * @brief Benchmark configuration, built from the command line.
+     */
+    struct Options {
+        std::vector<pseu::bench::Shape> shapes{std::begin(pseu::bench::all_shapes),
+                                               std::end(pseu::bench::all_shapes)};
+        pseu::bench::GenConfig gen;
+        std::size_t reps = 5;
+        bool json = false;
+        bool scaling = false;
+        bool execute = false;
+        std::size_t iterations = 10000;
+        bool ir_backends = false;
+        bool check_encoder = false;
+    };
+
+    /// @brief Best-of-N wall time of one phase, in seconds, and its heap allocations.
+    struct PhaseTime {
+        const char *name;
+        double seconds = std::numeric_limits<double>::infinity();
+        std::size_t allocations = 0;
+    };
+
+    /// @brief Measurements for one generated program.
+    struct Result {
+        pseu::bench::Shape shape;
+        std::size_t lines = 0;
+        std::size_t bytes = 0;
+        std::size_t tokens = 0;
+        std::size_t nodes = 0;
+        std::size_t instructions = 0;
+        PhaseTime phases[5]{{"lex"}, {"parse"}, {"irgen"}, {"codegen"}, {"encode"}};
+    };
+
+    template<typename F>
+    double time_once(F &&f) {
+        const auto begin = clock_type::now();
+        f();
+        return std::chrono::duration<double>(clock_type::now() - begin).count();
+    }
+
+    /// @brief Time one run of a phase, keeping the fastest time and the allocation count.
+    template<typename F>
+    void measure(PhaseTime &phase, F &&f) {
+        const auto before = allocations;
+        phase.seconds = std::min(phase.seconds, time_once(f));
+        phase.allocations = allocations - before;
+    }
+
+    std::size_t parse_count(int argc, char **argv, int &i, const char *flag) {
+        if (i + 1 >= argc)
+            throw std::runtime_error(std::string("Missing value for ") + flag);
+        return std::stoul(argv[++i]);
+    }
+
+    Options parse_args(int argc, char **argv) {
+        Options opt;
+        for (int i = 1; i < argc; ++i) {
+            const std::string arg = argv[i];
+            if (arg == "--shape") {
+                if (i + 1 >= argc)
+                    throw std::runtime_error("Missing value for --shape");
+                const std::string name = argv[++i];
+                if (name != "all") {
+                    const auto s = pseu::bench::parse_shape(name);
+                    if (!s)
+                        throw std::runtime_error("Unknown shape: " + name);
+                    opt.shapes = {*s};
+                }
+            } else if (arg == "--lines") {
+                opt.gen.lines = parse_count(argc, argv, i, "--lines");
+            } else if (arg == "--depth") {
+                opt.gen.depth = parse_count(argc, argv, i, "--depth");
+            } else if (arg == "--width") {
+                opt.gen.width = parse_count(argc, argv, i, "--width");
+            } else if (arg == "--reps") {
+                opt.reps = std::max<std::size_t>(1, parse_count(argc, argv, i, "--reps"));
+            } else if (arg == "--json") {
+                opt.json = true;
+            } else if (arg == "--scaling") {
+                opt.scaling = true;
+            } else if (arg == "--execute") {
+                opt.execute = true;
+            } else if (arg == "--iterations") {
+                opt.iterations = parse_count(argc, argv, i, "--iterations");
+            } else if (arg == "--ir-backends") {
+                opt.ir_backends = true;
+            } else if (arg == "--check-encoder") {
+                opt.check_encoder = true;
+            } else {
+                throw std::runtime_error("Unknown argument: " + arg);
+            }
+        }
+        return opt;
+    }
+
+    /**
+     * @brief Compile one generated program <code>reps</code> times, phase by phase.
+     *
+     * Each phase keeps its fastest run. Lexing is timed on its own through
+     * frontend::tokenize; the parse time includes the scanner it drives.
+     * Code generation is timed into the session's text buffer, without
+     * writing a file, so the time does not depend on the filesystem.
+     */
+    Result run(const Options &opt, pseu::bench::Shape shape) {
+        auto cfg = opt.gen;
+        cfg.shape = shape;
+        const auto src = pseu::bench::ProgramGenerator(cfg).generate();
+
+        Result r{shape};
+        r.bytes = src.size();
+        r.lines = static_cast<std::size_t>(std::count(src.begin(), src.end(), '\n'));
+
+        pseu::session::CompilationSession session;
+        for (std::size_t rep = 0; rep < opt.reps; ++rep) {
+            auto &[lex, parse, irgen, codegen, encode] = r.phases;
+
+            measure(lex, [&] { r.tokens = pseu::frontend::tokenize(src); });
+
+            pseu::pipeline::Compilation c(session);
+            pseu::ast::NodeId root{};
+            measure(parse, [&] { root = c.parse(src); });
+            r.nodes = session.ast().size();
+
+            measure(irgen, [&] { c.generate(root); });
+            r.instructions = session.ir().code.code.size();
+
+            measure(codegen, [&] { (void) c.assembly(); });
+
+            measure(encode, [&] { (void) c.encode(); });
+        }
+        return r;
+    }
+
+    void print_table(const std::vector<Result> &results) {
+        std::cout << "shape,lines,bytes,phase,ms,lines_per_sec,bytes_per_sec,allocations\n";
+        for (const auto &r: results)
+            for (const auto &p: r.phases)
+                std::cout << pseu::bench::shape_name(r.shape) << "," << r.lines << "," << r.bytes << ","
+                          << p.name << "," << p.seconds * 1e3 << ","
+                          << static_cast<double>(r.lines) / p.seconds << ","
+                          << static_cast<double>(r.bytes) / p.seconds << ","
+                          << p.allocations << "\n";
+    }
+
+    void print_json(const Options &opt, const std::vector<Result> &results) {
+        std::cout << "{\n  \"reps\": " << opt.reps << ",\n  \"results\": [";
+        for (std::size_t i = 0; i < results.size(); ++i) {
+            const auto &r = results[i];
+            std::cout << (i ? "," : "") << "\n    {\"shape\": \"" << pseu::bench::shape_name(r.shape) << "\""
+                      << ", \"lines\": " << r.lines
+                      << ", \"bytes\": " << r.bytes
+                      << ", \"tokens\": " << r.tokens
+                      << ", \"ast_nodes\": " << r.nodes
+                      << ", \"ir_instructions\": " << r.instructions
+                      << ", \"phases\": {";
+            for (std::size_t k = 0; k < std::size(r.phases); ++k) {
+                const auto &p = r.phases[k];
+                std::cout << (k ? ", " : "") << "\"" << p.name << "\": {"
+                          << "\"seconds\": " << p.seconds
+                          << ", \"lines_per_sec\": " << static_cast<double>(r.lines) / p.seconds
+                          << ", \"bytes_per_sec\": " << static_cast<double>(r.bytes) / p.seconds
+                          << ", \"allocations\": " << p.allocations
+                          << "}";
+            }
+            std::cout << "}}";
+        }
+        std::cout << "\n  ]\n}\n";
+    }
+
+    /**
+     * @brief Parses <tt>int a1, a2, ..., aN;</tt> for growing N.
+     *
+     * The identifier list is appended in place, so the per-identifier
+     * cost must stay flat as N grows; a quadratic regression shows up
+     * as a per-identifier time that scales with N.
+     */
+    void run_scaling() {
+        std::cout << "identifiers,total_ms,ns_per_identifier\n";
+        for (std::size_t n = 1000; n <= 1000000; n *= 10) {
+            std::string src = "int ";
+            for (std::size_t i = 1; i <= n; ++i) {
+                src += 'a';
+                src += std::to_string(i);
+                src += (i == n) ? ";\n" : ", ";
+            }
+            pseu::ast::AstArena arena;
+            const auto seconds = time_once([&] { pseu::frontend::parse(src, arena); });
+            std::cout << n << "," << seconds * 1e3 << "," << seconds * 1e9 / static_cast<double>(n) << "\n";
+        }
+    }
+
+    /**
+     * @brief Intern <code>values</code> into a <code>Pool</code>
+     *        <code>reps</code> times and print the fastest run.
+     *
+     * As with the compiler's thread-local pool, one pool serves every
+     * run; handles are held until the timing of a run ends and released
+     * before the next. Instructions that did not add an entry to the
+     * pool are counted as deduplication hits.
+     */
+    template<typename Pool>
+    void replay(const Options &opt, pseu::bench::Shape shape, const std::vector<pseu::ir::IRInstr> &values,
+                const char *backend) {
+        PhaseTime t{backend};
+        std::size_t stored = 0;
+        Pool pool;
+        std::vector<typename Pool::ptr> held;
+        held.reserve(values.size());
+        for (std::size_t rep = 0; rep < opt.reps; ++rep) {
+            const auto before = pool.size();
+            measure(t, [&] {
+                for (const auto &v: values)
+                    held.push_back(pool.acquire(v));
+            });
+            stored = pool.size() - before;
+            held.clear();
+        }
+        const auto n = values.size();
+        std::cout << pseu::bench::shape_name(shape) << "," << n << "," << backend << "," << t.seconds * 1e3 << ","
+                  << t.seconds * 1e9 / static_cast<double>(n) << "," << stored << "," << n - stored << ","
+                  << t.allocations << "\n";
+    }
+
+    /**
+     * @brief Compares the IR storage backends: the deduplicating
+     *        <code>flat_pool</code> and the bump InstrArena.
+     *
+     * The IR of each generated program is produced once and its
+     * instruction values are replayed into both, so only storage is
+     * measured: hashing and probing for the pool, a slot copy for the
+     * arena. The compiler uses the backend selected by
+     * <code>PSEU_IR_BACKEND</code>.
+     */
+    void run_ir_backends(const Options &opt) {
+        std::cout << "shape,instructions,backend,ms,ns_per_instruction,stored,dedup_hits,allocations\n";
+        for (auto shape: opt.shapes) {
+            auto cfg = opt.gen;
+            cfg.shape = shape;
+            const auto src = pseu::bench::ProgramGenerator(cfg).generate();
+
+            std::vector<pseu::ir::IRInstr> values;
+            {
+                pseu::session::CompilationSession session;
+                pseu::pipeline::Compilation c(session);
+                const auto &gen = c.generate(c.parse(src));
+                values.reserve(gen.code.code.size());
+                for (const auto &ins: gen.code.code) {
+                    [[maybe_unused]] auto g = ins.guard();
+                    values.push_back(*ins);
+                }
+            }
+
+            replay<pseu::ir::dedup_pool_t>(opt, shape, values, "flat_pool");
+            replay<pseu::ir::InstrArena>(opt, shape, values, "arena");
+        }
+    }
+
+    /**
+     * @brief Whether two modules hold the same program.
+     *
+     * Symbols are matched by name: the encoder lists them in the order the
+     * code generator creates them, the assembler in order of appearance.
+     */
+    bool same_module(const pseu::x86::Module &a, const pseu::x86::Module &b) {
+        if (a.text != b.text || a.data != b.data || a.bss_size != b.bss_size ||
+            a.symbols.size() != b.symbols.size() || a.relocations.size() != b.relocations.size())
+            return false;
+        for (const auto &s: a.symbols) {
+            const auto i = b.find(s.name);
+            if (i < 0)
+                return false;
+            const auto &t = b.symbols[static_cast<std::size_t>(i)];
+            if (t.section != s.section || t.offset != s.offset || t.global != s.global)
+                return false;
+        }
+        for (std::size_t i = 0; i < a.relocations.size(); ++i) {
+            const auto &r = a.relocations[i];
+            const auto &q = b.relocations[i];
+            if (r.offset != q.offset || r.kind != q.kind || r.addend != q.addend ||
+                a.symbols[r.symbol].name != b.symbols[q.symbol].name)
+                return false;
+        }
+        return true;
+    }
+
+    /**
+     * @brief Checks that CodeGenerator::encode() and the assembly of
+     *        CodeGenerator::generate() agree.
+     *
+     * Every shape is compiled at -O0 and -O1, for a process and for a
+     * hosted runtime.
+     *
+     * @return Whether every pair matched.
+     */
+    bool run_check_encoder(const Options &opt) {
+        using pseu::codegen::Runtime;
+
+        std::cout << "shape,opt,runtime,text_bytes,match\n";
+        bool ok = true;
+        for (auto shape: opt.shapes) {
+            auto cfg = opt.gen;
+            cfg.shape = shape;
+            const auto src = pseu::bench::ProgramGenerator(cfg).generate();
+
+            pseu::session::CompilationSession session;
+            for (int level = 0; level <= 1; ++level) {
+                for (auto runtime: {Runtime::Process, Runtime::Hosted}) {
+                    pseu::pipeline::Compilation c(session, {.opt_level = level, .runtime = runtime});
+                    c.generate(c.parse(src));
+                    const auto encoded = c.encode();
+                    const auto assembled = pseu::bench::assemble(c.assembly());
+                    const bool match = same_module(encoded, assembled);
+                    ok &= match;
+                    std::cout << pseu::bench::shape_name(shape) << ",O" << level << ","
+                              << (runtime == Runtime::Process ? "process" : "hosted") << ","
+                              << encoded.text.size() << "," << (match ? "yes" : "no") << "\n";
+                }
+            }
+        }
+        return ok;
+    }
+
+    /// @brief Nested loop with arithmetic and one print per outer iteration.
+    std::string loop_kernel(std::size_t iterations) {
+        return "int i = 0;\nint j = 0;\nint s = 0;\n"
+               "while (i < " + std::to_string(iterations) + ") {\n"
+               "j = 0;\n"
+               "while (j < 100) {\n"
+               "s = s + i * j - j / 3;\n"
+               "j = j + 1;\n"
+               "}\n"
+               "if (s > 1000000) {\n"
+               "s = s - 1000000;\n"
+               "}\n"
+               "print(s);\n"
+               "i = i + 1;\n"
+               "}\n";
+    }
+
+    /**
+     * @brief Runs a loop kernel with the interpreter and as a program built
+     *        with <code>nasm</code> and <code>ld</code>, from source to exit.
+     *
+     * Output goes to <code>/dev/null</code>. Both engines execute the same
+     * IR, so the instruction count of the interpreter is used for both; the
+     * native run time includes process start-up. The native row is
+     * reported as unavailable when <code>nasm</code> or <code>ld</code> fails.
+     */
+    void run_execute(const Options &opt) {
+        const auto src = loop_kernel(opt.iterations);
+        const auto tmp = std::filesystem::temp_directory_path();
+        const auto asm_path = (tmp / "pseu-exec.asm").string();
+        const auto obj_path = (tmp / "pseu-exec.o").string();
+        const auto exe_path = (tmp / "pseu-exec").string();
+
+        std::cout << "engine,end_to_end_ms,run_ms,instructions,instructions_per_sec\n";
+        std::uint64_t steps = 0;
+        const auto report = [&](const char *engine, double total, double run) {
+            std::cout << engine << "," << total * 1e3 << "," << run * 1e3 << "," << steps << ","
+                      << static_cast<double>(steps) / run << "\n";
+        };
+
+        std::FILE *sink = std::fopen("/dev/null", "w");
+        if (!sink)
+            throw std::runtime_error("Cannot open /dev/null");
+
+        // interpreter: parse, IR, decode, run
+        double total = std::numeric_limits<double>::infinity();
+        double run = total;
+        for (std::size_t rep = 0; rep < opt.reps; ++rep) {
+            double r = 0;
+            total = std::min(total, time_once([&] {
+                pseu::session::CompilationSession session;
+                pseu::pipeline::Compilation c(session);
+                const pseu::interp::Program program(c.generate(c.parse(src)));
+                r = time_once([&] { steps = program.run(sink); });
+            }));
+            run = std::min(run, r);
+        }
+        std::fclose(sink);
+        report("interpret", total, run);
+
+        // native: parse, IR, assembly text, nasm, ld, run
+        const auto build = "nasm -felf64 " + asm_path + " -o " + obj_path + " && ld " + obj_path + " -o " + exe_path;
+        const auto exec = exe_path + " > /dev/null";
+        total = run = std::numeric_limits<double>::infinity();
+        bool built = true;
+        for (std::size_t rep = 0; built && rep < opt.reps; ++rep) {
+            double r = 0;
+            const double t = time_once([&] {
+                pseu::session::CompilationSession session;
+                pseu::pipeline::Compilation c(session);
+                c.generate(c.parse(src));
+                c.write(pseu::pipeline::Emit::Asm, asm_path);
+                built = std::system(build.c_str()) == 0;
+                if (built)
+                    r = time_once([&] { built = std::system(exec.c_str()) == 0; });
+            });
+            total = std::min(total, t);
+            run = std::min(run, r);
+        }
+        if (built)
+            report("nasm+ld", total, run);
+        else
+            std::cout << "nasm+ld,unavailable\n";
+
+        for (const auto &p: {asm_path, obj_path, exe_path})
+            std::filesystem::remove(p);
+    }
+}
+
+/**
+ * @brief Entry point of the <code>bench</code> target.
+ *
+ * Usage:
+ * @code
+ * bench [--shape all|straight|nested|expressions|declarations|strings]
+ *       [--lines N] [--depth N] [--width N] [--reps N] [--json] [--scaling]
+ *       [--execute [--iterations N]] [--ir-backends] [--check-encoder]
+ * @endcode
+ */
+int main(int argc, char **argv) {
+    Options opt;
+    try {
+        opt = parse_args(argc, argv);
+    } catch (const std::exception &e) {
+        std::cerr << "Argument error: " << e.what() << "\n";
+        return 1;
+    }
+
+    if (opt.scaling) {
+        run_scaling();
+        return 0;
+    }
+
+    if (opt.ir_backends) {
+        try {
+            run_ir_backends(opt);
+        } catch (const std::exception &e) {
+            std::cerr << e.what() << "\n";
+            return 1;
+        }
+        return 0;
+    }
+
+    if (opt.check_encoder) {
+        try {
+            return run_check_encoder(opt) ? 0 : 1;
+        } catch (const std::exception &e) {
+            std::cerr << e.what() << "\n";
+            return 1;
+        }
+    }
+
+    if (opt.execute) {
+        try {
+            run_execute(opt);
+        } catch (const std::exception &e) {
+            std::cerr << e.what() << "\n";
+            return 1;
+        }
+        return 0;
+    }
+
+    std::vector<Result> results;
+    try {
+        for (auto shape: opt.shapes)
+            results.push_back(run(opt, shape));
+    } catch (const std::exception &e) {
+        std::cerr << e.what() << "\n";
+        return 1;
+    }
+    if (opt.json)
+        print_json(opt, results);
+    else
+        print_table(results);
+}
@@ -0,0 +1,219 @@
+/**
+ * @file generator.hpp
+ * @author JeongHan-Bae &lt;mastropseudo&#64;gmail.com&gt;
+ * @brief Synthetic program generator for the compile-throughput benchmarks.
+ *
+ * @license MIT
+ *
+ * @verbatim
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ * @endverbatim
+ */
+
+
+#pragma once
+
+#include <cstddef>
+#include <optional>
+#include <string>
+#include <string_view>
+
+namespace pseu::bench {
+
+    /**
+     * @brief Shape of a generated program.
+     *
+     * Each shape stresses a different part of the pipeline.
+     */
+    enum class Shape {
+        Straight,     ///< Long straight-line code: assignments, arithmetic and prints.
+        Nested,       ///< Deep if / else / while nesting.
+        Expressions,  ///< Long left-associative expression chains.
+        Declarations, ///< Many declarations, including long identifier lists.
+        Strings       ///< Many distinct string literals and string variables.
+    };
+
+    inline constexpr Shape all_shapes[] = {
+            Shape::Straight, Shape::Nested, Shape::Expressions, Shape::Declarations, Shape::Strings
+    };
+
+    inline constexpr std::string_view shape_name(Shape s) {
+        switch (s) {
+            case Shape::Straight:
+                return "straight";
+            case Shape::Nested:
+                return "nested";
+            case Shape::Expressions:
+                return "expressions";
+            case Shape::Declarations:
+                return "declarations";
+            case Shape::Strings:
+                return "strings";
+        }
+        return "?";
+    }
+
+    inline std::optional<Shape> parse_shape(std::string_view name) {
+        for (auto s: all_shapes)
+            if (shape_name(s) == name)
+                return s;
+        return std::nullopt;
+    }
+
+    /**
+     * @brief Size and shape parameters of a generated program.
+     */
+    struct GenConfig {
+        Shape shape = Shape::Straight;
+
+        /// @brief Approximate number of source lines to emit.
+        std::size_t lines = 10000;
+
+        /// @brief Nesting depth of each block (Nested).
+        std::size_t depth = 32;
+
+        /// @brief Operands per expression (Expressions) or identifiers per list (Declarations).
+        std::size_t width = 32;
+    };
+
+    /**
+     * @brief Deterministic generator of valid PseudoCompiler programs.
+     *
+     * Output depends only on the configuration, so runs are comparable
+     * across commits.
+     */
+    class ProgramGenerator final {
+    public:
+        explicit ProgramGenerator(const GenConfig &cfg) : cfg_(cfg) {}
+
+        [[nodiscard]] std::string generate() {
+            out_.clear();
+            lines_ = 0;
+            switch (cfg_.shape) {
+                case Shape::Straight:
+                    straight();
+                    break;
+                case Shape::Nested:
+                    nested();
+                    break;
+                case Shape::Expressions:
+                    expressions();
+                    break;
+                case Shape::Declarations:
+                    declarations();
+                    break;
+                case Shape::Strings:
+                    strings();
+                    break;
+            }
+            return std::move(out_);
+        }
+
+    private:
+        void line(std::string_view text) {
+            out_.append(text);
+            out_ += '\n';
+            ++lines_;
+        }
+
+        static std::string var(char prefix, std::size_t i) {
+            return prefix + std::to_string(i);
+        }
+
+        void straight() {
+            line("int acc = 0;");
+            for (std::size_t i = 0; lines_ < cfg_.lines; ++i) {
+                const auto v = var('v', i);
+                line("int " + v + " = " + std::to_string(i % 97) + ";");
+                line("acc = acc + " + v + " * 3 - " + std::to_string(i % 13) + ";");
+                if (i % 8 == 7)
+                    line("print(acc);");
+            }
+        }
+
+        void nested() {
+            line("int n = 0;");
+            const auto depth = cfg_.depth ? cfg_.depth : 1;
+            while (lines_ < cfg_.lines) {
+                for (std::size_t d = 0; d < depth; ++d) {
+                    if (d % 2 == 0)
+                        line("if (n < " + std::to_string(d + 1) + ") {");
+                    else
+                        line("while (n < " + std::to_string(d + 1) + ") {");
+                    line("n = n + 1;");
+                }
+                line("print(n);");
+                for (std::size_t d = depth; d-- > 0;)
+                    line(d % 2 == 0 ? "} else { n = n - 1; }" : "}");
+            }
+        }
+
+        void expressions() {
+            line("int a = 1;");
+            line("int b = 2;");
+            line("int c = 3;");
+            static constexpr std::string_view ops[] = {" + ", " * ", " - ", " / "};
+            static constexpr std::string_view operands[] = {"a", "b", "c", "7", "(a + b)"};
+            const auto width = cfg_.width ? cfg_.width : 1;
+            for (std::size_t i = 0; lines_ < cfg_.lines; ++i) {
+                std::string expr(operands[i % 5]);
+                for (std::size_t k = 1; k < width; ++k) {
+                    expr += ops[(i + k) % 4];
+                    expr += operands[(i + k) % 5];
+                }
+                line("c = " + expr + ";");
+            }
+            line("print(c);");
+        }
+
+        void declarations() {
+            const auto width = cfg_.width ? cfg_.width : 1;
+            for (std::size_t i = 0; lines_ < cfg_.lines; ++i) {
+                if (i % 4 == 3) {
+                    std::string list = "int ";
+                    for (std::size_t k = 0; k < width; ++k) {
+                        if (k)
+                            list += ", ";
+                        list += var('l', i * width + k);
+                    }
+                    line(list + ";");
+                } else if (i % 4 == 2) {
+                    line("string " + var('s', i) + ";");
+                } else {
+                    line("int " + var('d', i) + " = " + std::to_string(i) + ";");
+                }
+            }
+        }
+
+        void strings() {
+            for (std::size_t i = 0; lines_ < cfg_.lines; ++i) {
+                const auto v = var('s', i);
+                line("string " + v + " = \"literal number " + std::to_string(i) + "\";");
+                line("prints(" + v + ");");
+                if (i % 4 == 3)
+                    line("prints(\"inline literal " + std::to_string(i) + "\");");
+            }
+        }
+
+        GenConfig cfg_;
+        std::string out_;
+        std::size_t lines_ = 0;
+    };
+
+} // namespace pseu::bench
@@ -28,14 +28,40 @@
 
 #pragma once
 
-#include <memory>
+#include <cstddef>
+#include <cstdint>
+#include <span>
 #include <string>
+#include <type_traits>
 #include <vector>
 #include <variant>
 #include "tokens.hpp"
 
 namespace pseu::ast {
 
+    /**
+     * @brief Index of a node inside an AstArena.
+     *
+     * A strong 32-bit handle: nodes reference their children by index
+     * instead of by pointer, so the tree has no per-node ownership and
+     * no reference counting. <code>NodeId::null</code> marks an absent
+     * child (e.g. a missing else branch).
+     */
+    enum class NodeId : std::uint32_t {
+        null = 0xFFFFFFFFu
+    };
+
+    /**
+     * @brief Contiguous slice of an AstArena side table.
+     *
+     * Used for variable-length children (statement lists, declared
+     * identifiers) so that every node type stays trivially destructible.
+     */
+    struct Range final {
+        std::uint32_t first{0};
+        std::uint32_t count{0};
+    };
+
     enum class PrintType : std::uint8_t {
         Int = 0,
         Str = 1
@@ -48,7 +74,7 @@ namespace pseu::ast {
     struct StringLiteralNode;
     struct IdentifierNode;
     struct BinOpNode;
-    struct Statement;
+    struct StatementList;
     struct Condition;
     struct IfStatement;
     struct WhileStatement;
@@ -68,7 +94,7 @@ namespace pseu::ast {
             StringLiteralNode,
             IdentifierNode,
             BinOpNode,
-            Statement,
+            StatementList,
             Condition,
             IfStatement,
             WhileStatement,
@@ -85,10 +111,10 @@ namespace pseu::ast {
     struct NumberNode final {
         lexer::Token tok;
 
-        explicit NumberNode(lexer::Token t) : tok(std::move(t)) {}
+        explicit NumberNode(lexer::Token t) : tok(t) {}
 
-        /// @brief Retrieve the literal value as string.
-        [[nodiscard]] std::string getValue() const { return tok.value; }
+        /// @brief Retrieve the literal value, converted at lex time.
+        [[nodiscard]] std::int64_t getNumber() const { return tok.number; }
     };
 
     /**
@@ -99,10 +125,10 @@ namespace pseu::ast {
     struct IdentifierNode final {
         lexer::Token tok;
 
-        explicit IdentifierNode(lexer::Token t) : tok(std::move(t)) {}
+        explicit IdentifierNode(lexer::Token t) : tok(t) {}
 
-        /// @brief Retrieve the identifier name.
-        [[nodiscard]] std::string getValue() const { return tok.value; }
+        /// @brief Retrieve the interned (mangled) identifier name.
+        [[nodiscard]] sym::SymbolId getValue() const { return tok.value; }
     };
 
     /**
@@ -113,10 +139,10 @@ namespace pseu::ast {
     struct StringLiteralNode final {
         lexer::Token tok;
 
-        explicit StringLiteralNode(lexer::Token t) : tok(std::move(t)) {}
+        explicit StringLiteralNode(lexer::Token t) : tok(t) {}
 
-        /// @brief Retrieve the string literal value.
-        [[nodiscard]] std::string getValue() const { return tok.value; }
+        /// @brief Retrieve the interned string literal contents.
+        [[nodiscard]] sym::SymbolId getValue() const { return tok.value; }
     };
 
     /**
@@ -126,20 +152,22 @@ namespace pseu::ast {
      * multiplication, or comparison.
      */
     struct BinOpNode final {
-        std::shared_ptr<ASTNode> left;
+        NodeId left{NodeId::null};
         lexer::Token op_tok;
-        std::shared_ptr<ASTNode> right;
+        NodeId right{NodeId::null};
     };
 
     /**
      * @brief Statement sequence node.
      *
-     * Represents a linked list of statements, constructed
-     * by the parser as a binary tree.
+     * Holds the statements of a program or block contiguously,
+     * in source order, as a slice of AstArena::children(). The parser
+     * collects each list in place and commits it once the enclosing
+     * block is complete, so traversal is iterative regardless of the
+     * statement count.
      */
-    struct Statement final {
-        std::shared_ptr<ASTNode> left;
-        std::shared_ptr<ASTNode> right; // may be null
+    struct StatementList final {
+        Range statements;
     };
 
     /**
@@ -148,16 +176,16 @@ namespace pseu::ast {
      * Represents a comparison used in control-flow constructs.
      */
     struct Condition final {
-        std::shared_ptr<ASTNode> left_expression;
+        NodeId left_expression;
         lexer::Token comparison;
-        std::shared_ptr<ASTNode> right_expression;
+        NodeId right_expression;
 
-        Condition(std::shared_ptr<ASTNode> left,
+        Condition(NodeId left,
                   lexer::Token op,
-                  std::shared_ptr<ASTNode> right)
-                : left_expression(std::move(left)),
-                  comparison(std::move(op)),
-                  right_expression(std::move(right)) {}
+                  NodeId right)
+                : left_expression(left),
+                  comparison(op),
+                  right_expression(right) {}
     };
 
     /**
@@ -166,9 +194,9 @@ namespace pseu::ast {
      * Represents conditional branching with optional else clause.
      */
     struct IfStatement final {
-        std::shared_ptr<ASTNode> if_condition;
-        std::shared_ptr<ASTNode> if_body;
-        std::shared_ptr<ASTNode> else_body;   // may be null
+        NodeId if_condition{NodeId::null};
+        NodeId if_body{NodeId::null};
+        NodeId else_body{NodeId::null};   // may be null
     };
 
     /**
@@ -177,8 +205,8 @@ namespace pseu::ast {
      * Represents a loop with a condition and body.
      */
     struct WhileStatement final {
-        std::shared_ptr<ASTNode> condition;
-        std::shared_ptr<ASTNode> body;
+        NodeId condition{NodeId::null};
+        NodeId body{NodeId::null};
     };
 
     /**
@@ -189,7 +217,7 @@ namespace pseu::ast {
      */
     struct PrintStatement final {
         PrintType type;
-        std::variant<std::shared_ptr<ASTNode>, std::string> value;
+        std::variant<NodeId, sym::SymbolId> value; // expression or literal text
     };
 
     /**
@@ -199,7 +227,7 @@ namespace pseu::ast {
      */
     struct Assignment final {
         lexer::Token identifier;                    // e.g., T_VAR
-        std::shared_ptr<ASTNode> expression;        // e.g., BinOpNode / NumberNode
+        NodeId expression{NodeId::null};            // e.g., BinOpNode / NumberNode
     };
 
     /**
@@ -210,9 +238,124 @@ namespace pseu::ast {
      */
     struct Declaration final {
         lexer::Token declaration_type;              // int or string
-        std::vector<lexer::Token> identifiers;      // list of var IDs
-        std::shared_ptr<ASTNode> init_expr;         // only for int x = expr;
-        Declaration() : init_expr(nullptr) {}
+        Range identifiers;                          // var IDs, slice of AstArena::tokens()
+        NodeId init_expr{NodeId::null};             // only for int x = expr;
+    };
+
+    static_assert(std::is_trivially_destructible_v<ASTNode>,
+                  "AST nodes must stay trivially destructible for O(1) arena release");
+
+    /**
+     * @brief Bump-allocated storage for one AST.
+     *
+     * All nodes of a compilation live contiguously in a single vector
+     * and reference each other through NodeId. Variable-length children
+     * are stored in two side tables (statement ids and declared tokens)
+     * and referenced by Range.
+     *
+     * Because every node type is trivially destructible, releasing the
+     * whole tree is a constant-time <code>clear()</code> that keeps the
+     * capacity for the next compilation.
+     *
+     * Statement lists are built through a LIFO stack of open lists:
+     * the grammar opens a list when a block starts, appends completed
+     * statements to it and closes it when the block ends. Nested blocks
+     * always close before their parent continues, so each list is
+     * committed contiguously regardless of nesting.
+     */
+    class AstArena final {
+    public:
+        /// @brief Append a node and return its index.
+        template<typename Node>
+        NodeId make(Node &&node) {
+            nodes_.emplace_back(std::forward<Node>(node));
+            return static_cast<NodeId>(nodes_.size() - 1);
+        }
+
+        [[nodiscard]] ASTNode &operator[](NodeId id) { return nodes_[static_cast<std::uint32_t>(id)]; }
+
+        [[nodiscard]] const ASTNode &operator[](NodeId id) const { return nodes_[static_cast<std::uint32_t>(id)]; }
+
+        /// @brief Typed access to a node known to hold <code>T</code>.
+        template<typename T>
+        [[nodiscard]] T &get(NodeId id) { return std::get<T>((*this)[id]); }
+
+        template<typename T>
+        [[nodiscard]] const T &get(NodeId id) const { return std::get<T>((*this)[id]); }
+
+        /// @brief Statement ids referenced by a StatementList.
+        [[nodiscard]] std::span<const NodeId> children(Range r) const {
+            return {children_.data() + r.first, r.count};
+        }
+
+        /// @brief Tokens referenced by a Declaration.
+        [[nodiscard]] std::span<const lexer::Token> tokens(Range r) const {
+            return {tokens_.data() + r.first, r.count};
+        }
+
+        /// @brief Copy a token list into the arena.
+        Range store_tokens(std::span<const lexer::Token> toks) {
+            Range r{static_cast<std::uint32_t>(tokens_.size()), static_cast<std::uint32_t>(toks.size())};
+            tokens_.insert(tokens_.end(), toks.begin(), toks.end());
+            return r;
+        }
+
+        /// @brief Open a new statement list; returns its depth handle.
+        std::size_t open_list() {
+            if (depth_ == open_.size())
+                open_.emplace_back();
+            else
+                open_[depth_].clear();
+            return depth_++;
+        }
+
+        /// @brief Append a completed statement to an open list.
+        void append(std::size_t list, NodeId stmt) { open_[list].push_back(stmt); }
+
+        /// @brief Commit the innermost open list as a StatementList node.
+        NodeId close_list(std::size_t list) {
+            const auto &items = open_[list];
+            depth_ = list;
+            Range r{static_cast<std::uint32_t>(children_.size()), static_cast<std::uint32_t>(items.size())};
+            children_.insert(children_.end(), items.begin(), items.end());
+            return make(StatementList{r});
+        }
+
+        /// @brief Number of nodes.
+        [[nodiscard]] std::size_t size() const noexcept { return nodes_.size(); }
+
+        /// @brief Release every node in O(1), keeping capacity for reuse.
+        void clear() noexcept {
+            nodes_.clear();
+            children_.clear();
+            tokens_.clear();
+            depth_ = 0;
+        }
+
+        /// @brief Bytes reserved by the node and side tables.
+        [[nodiscard]] std::size_t capacity_bytes() const noexcept {
+            std::size_t n = nodes_.capacity() * sizeof(ASTNode) + children_.capacity() * sizeof(NodeId) +
+                            tokens_.capacity() * sizeof(lexer::Token);
+            for (const auto &list: open_)
+                n += list.capacity() * sizeof(NodeId);
+            return n;
+        }
+
+        /// @brief Return the capacity beyond the current contents.
+        void shrink_to_fit() {
+            nodes_.shrink_to_fit();
+            children_.shrink_to_fit();
+            tokens_.shrink_to_fit();
+            open_.resize(depth_);
+            open_.shrink_to_fit();
+        }
+
+    private:
+        std::vector<ASTNode> nodes_;
+        std::vector<NodeId> children_;
+        std::vector<lexer::Token> tokens_;
+        std::vector<std::vector<NodeId>> open_;
+        std::size_t depth_{0};
     };
 
 } // namespace pseu::ast
@@ -0,0 +1,126 @@
+/**
+ * @file cache.hpp
+ * @author JeongHan-Bae &lt;mastropseudo&#64;gmail.com&gt;
+ * @brief Content-addressed on-disk cache of compiler outputs.
+ *
+ * @license MIT
+ *
+ * @verbatim
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ * @endverbatim
+ */
+
+
+
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <mutex>
+#include <string>
+#include <string_view>
+
+/// @brief Compiler version, part of every cache key (set by CMake).
+#ifndef PSEU_VERSION
+#define PSEU_VERSION "dev"
+#endif
+
+namespace pseu::cache {
+
+    /// @brief Counters of one Cache since it was opened.
+    struct Stats final {
+        std::uint64_t hits = 0;
+        std::uint64_t misses = 0;
+        std::uint64_t evictions = 0;
+    };
+
+    /**
+     * @brief Directory of compiler outputs keyed by a hash of their inputs.
+     *
+     * An entry is the output file (assembly, object or executable) of one
+     * compilation, named by the 16 hex digits of its key. Entries are
+     * written to a temporary file and renamed into place, so concurrent
+     * compilers sharing the directory never observe a partial entry.
+     *
+     * The size of the directory is capped. The directory is scanned once
+     * when the Cache is opened and the total is then tracked in memory, so
+     * a store costs two stats; only when a store pushes the total over the
+     * cap is the directory rescanned, and the least recently used entries
+     * (oldest modification time, refreshed on every hit) are removed until
+     * it is at 90% of the cap, so that a full cache is rescanned once per
+     * tenth of its size stored rather than on every store. The rescan also
+     * picks up entries stored by other processes or by other Cache objects
+     * on the same directory since the last one.
+     *
+     * A Cache may be shared by threads (the workers of <code>-j</code>), so
+     * that they count one total against the cap and one set of stats; the
+     * total, the stats and eviction are kept under a mutex, and the file
+     * copies run outside it.
+     */
+    class Cache final {
+    public:
+        /**
+         * @param dir       Cache directory, created if missing.
+         * @param max_bytes Size cap of all entries.
+         * @throws std::filesystem::filesystem_error if the directory cannot be created.
+         *
+         * Scans the directory once for the size of the existing entries.
+         */
+        Cache(std::filesystem::path dir, std::uint64_t max_bytes);
+
+        /**
+         * @brief Key of a compilation: FNV-1a of the source bytes, mixed
+         *        with the compiler version and the output-affecting flags.
+         */
+        [[nodiscard]] static std::uint64_t key(std::string_view source, std::string_view flags) noexcept;
+
+        /**
+         * @brief Copy the entry for <code>key</code> to <code>target</code>.
+         *
+         * @return Whether the entry existed; counts a hit or a miss.
+         */
+        bool fetch(std::uint64_t key, const std::filesystem::path &target);
+
+        /**
+         * @brief Store a copy of <code>output</code> as the entry for <code>key</code>,
+         *        then evict down to 90% of the size cap if the store exceeded it.
+         *
+         * Failures are not errors: the compilation already succeeded, and
+         * the entry is simply missing next time.
+         */
+        void store(std::uint64_t key, const std::filesystem::path &output) noexcept;
+
+        /// @brief Snapshot of the counters.
+        [[nodiscard]] Stats stats() const;
+
+    private:
+        [[nodiscard]] std::filesystem::path entry(std::uint64_t key) const;
+
+        /// @brief Rescan the directory and, if it is over the cap, remove the least
+        ///        recently used entries until it is at 90% of the cap.
+        void evict();
+
+        std::filesystem::path dir_;
+        std::uint64_t max_bytes_;
+        std::uint64_t total_ = 0; ///< size of all entries, as of the last scan plus our stores and replacements
+        Stats stats_;
+        mutable std::mutex mutex_; ///< guards total_ and stats_
+    };
+
+} // namespace pseu::cache
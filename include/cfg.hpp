@@ -0,0 +1,166 @@
+/**
+ * @file cfg.hpp
+ * @author JeongHan-Bae &lt;mastropseudo&#64;gmail.com&gt;
+ * @brief Control-flow graph over the linear IR.
+ *
+ * @license MIT
+ *
+ * @verbatim
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ * @endverbatim
+ */
+
+
+#pragma once
+
+#include <cstdint>
+#include <span>
+#include <vector>
+#include "ir.hpp"
+
+namespace pseu::cfg {
+
+    /// @brief Index of a basic block in CFG::blocks().
+    using BlockId = std::uint32_t;
+
+    /// @brief Marker for "no block" (e.g. the immediate dominator of the entry).
+    inline constexpr BlockId no_block = 0xFFFFFFFFu;
+
+    /// @brief Marker for "not inside any loop".
+    inline constexpr std::uint32_t no_loop = 0xFFFFFFFFu;
+
+    /**
+     * @brief Maximal straight-line run of IR instructions.
+     *
+     * A block may only be entered at its first instruction (optionally a
+     * label) and only leaves through its last one (a jump, a conditional
+     * jump, or falling through to the next block).
+     */
+    struct BasicBlock final {
+        std::vector<ir::ir_pool_t::ptr> code;
+
+        /// @brief Label defined by the first instruction, or 0 if none.
+        ir::LabelId label{0};
+
+        std::vector<BlockId> preds;
+        std::vector<BlockId> succs;
+
+        /// @brief Block reached when the last instruction does not jump, or no_block.
+        BlockId fallthrough{no_block};
+
+        /// @brief Immediate dominator; no_block for the entry and for unreachable blocks.
+        BlockId idom{no_block};
+
+        /// @brief Innermost loop containing the block, or no_loop.
+        std::uint32_t loop{no_loop};
+
+        /// @brief Number of natural loops containing the block.
+        std::uint32_t loop_depth{0};
+
+        bool reachable{false};
+    };
+
+    /**
+     * @brief Natural loop, identified by its header.
+     *
+     * Back edges sharing a header are merged into a single loop.
+     */
+    struct Loop final {
+        BlockId header;
+
+        /// @brief Blocks of the loop, header included, in ascending order.
+        std::vector<BlockId> blocks;
+
+        /// @brief Index of the innermost enclosing loop, or no_loop.
+        std::uint32_t parent{no_loop};
+
+        /// @brief Nesting depth; outermost loops have depth 1.
+        std::uint32_t depth{1};
+    };
+
+    /**
+     * @brief Control-flow graph of one IR stream.
+     *
+     * Construction splits the stream into basic blocks at
+     * <code>LabelCode</code>, <code>JumpCode</code> and
+     * <code>CompareCodeIR</code> boundaries, resolves label ids to
+     * block indices once, and computes predecessors, successors,
+     * dominators (Cooper–Harvey–Kennedy) and natural loops.
+     *
+     * Block 0 is the entry. Instructions are shared with the IR pool;
+     * the graph never modifies them.
+     */
+    class CFG final {
+    public:
+        /**
+         * @param code Linear IR, e.g. <code>GeneratedIR::code</code>.
+         *
+         * @throws std::runtime_error if a jump targets an undefined label.
+         */
+        explicit CFG(const ir::InterCodeArray &code);
+
+        [[nodiscard]] const std::vector<BasicBlock> &blocks() const noexcept { return blocks_; }
+
+        [[nodiscard]] const BasicBlock &operator[](BlockId b) const { return blocks_[b]; }
+
+        [[nodiscard]] const std::vector<Loop> &loops() const noexcept { return loops_; }
+
+        [[nodiscard]] std::size_t size() const noexcept { return blocks_.size(); }
+
+        /// @brief Block defining <code>label</code>, or no_block.
+        [[nodiscard]] BlockId block_of(ir::LabelId label) const noexcept;
+
+        /// @brief Reachable blocks in reverse postorder from the entry.
+        [[nodiscard]] const std::vector<BlockId> &reverse_postorder() const noexcept { return rpo_; }
+
+        /// @brief Whether <code>a</code> dominates <code>b</code> (reflexive).
+        [[nodiscard]] bool dominates(BlockId a, BlockId b) const noexcept;
+
+        /**
+         * @brief Re-linearize the graph in block order.
+         *
+         * Reproduces the original instruction stream.
+         */
+        [[nodiscard]] ir::InterCodeArray linearize() const;
+
+        /**
+         * @brief Re-linearize the graph in the given block order.
+         *
+         * Blocks not listed are dropped. Where a fallthrough successor
+         * no longer follows its block, an explicit jump is inserted
+         * (labelling the successor with a fresh label if needed).
+         */
+        [[nodiscard]] ir::InterCodeArray linearize(std::span<const BlockId> order) const;
+
+    private:
+        void split(const ir::InterCodeArray &code);
+
+        void link();
+
+        void compute_dominators();
+
+        void find_loops();
+
+        std::vector<BasicBlock> blocks_;
+        std::vector<Loop> loops_;
+        std::vector<BlockId> rpo_;
+        std::vector<BlockId> label_block_; // indexed by LabelId
+    };
+
+} // namespace pseu::cfg
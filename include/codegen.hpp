@@ -1,137 +1,256 @@
-/**
- * @file codegen.hpp
- * @author JeongHan-Bae &lt;mastropseudo&#64;gmail.com&gt;
- * @brief NASM code generation backend for PseudoCompiler IR.
- *
- * @license MIT
- *
- * @verbatim
- * Permission is hereby granted, free of charge, to any person obtaining a copy
- * of this software and associated documentation files (the "Software"), to deal
- * in the Software without restriction, including without limitation the rights
- * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
- * copies of the Software, and to permit persons to whom the Software is
- * furnished to do so, subject to the following conditions:
- *
- * The above copyright notice and this permission notice shall be included in
- * all copies or substantial portions of the Software.
- *
- * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
- * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
- * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
- * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
- * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
- * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
- * SOFTWARE.
- * @endverbatim
- */
-
-#pragma once
-
-#include "ir.hpp"
-#include <vector>
-#include <string>
-#include <string_view>
-#include <unordered_map>
-#include <jh/pod>
-
-namespace pseu::codegen {
-
-    /**
-     * @brief NASM assembly generator from IR.
-     *
-     * This class consumes a linear IR instruction sequence and emits
-     * x86-64 NASM-compatible assembly code.
-     *
-     * Responsibilities include:
-     * <ul>
-     *   <li>Lowering IR instructions to concrete assembly sequences</li>
-     *   <li>Managing variable storage and temporaries</li>
-     *   <li>Emitting helper routines (e.g., print functions) on demand</li>
-     * </ul>
-     *
-     * The generator operates on pure-value IR instructions and performs
-     * static dispatch via <code>std::visit</code>, without RTTI or virtual
-     * dispatch.
-     */
-    class CodeGenerator final {
-    public:
-        /**
-         * @brief Construct a code generator.
-         *
-         * @param arr         Linear IR instruction array.
-         * @param identifiers Map of variable names to declared types.
-         * @param constants   Map of string constants to literal values.
-         * @param tempmap     Optional mapping for temporaries.
-         */
-        CodeGenerator(const ir::InterCodeArray &arr,
-                      const std::unordered_map<std::string, std::string> &identifiers,
-                      const std::unordered_map<std::string, std::string> &constants,
-                      const std::unordered_map<std::string, std::string> &tempmap = {});
-        /**
-         * @brief Emit assembly output to a file.
-         *
-         * @param path Output file path.
-         */
-        void writeAsm(const std::string &path);
-
-    private:
-        /// @brief Append raw text to the output buffer.
-        void pr(std::string_view s);
-
-        /// @brief Emit global/static variable definitions.
-        void gen_variables();
-
-        /// @brief Emit program entry prologue.
-        void gen_start();
-
-        /// @brief Emit program epilogue.
-        void gen_end();
-
-        /// @brief Generate assembly for the full IR stream.
-        void gen_code();
-
-        /// @brief Lower an assignment instruction.
-        void gen_assignment(const ir::AssignmentCode &a);
-
-        /// @brief Lower an unconditional jump instruction.
-        void gen_jump(const ir::JumpCode &j);
-
-        /// @brief Lower a label definition.
-        void gen_label(const ir::LabelCode &l);
-
-        /// @brief Lower a conditional comparison instruction.
-        void gen_compare(const ir::CompareCodeIR &c);
-
-        /// @brief Lower a print instruction.
-        void gen_print(const ir::PrintCodeIR &p);
-
-        /// @brief Emit helper routine for integer printing.
-        void gen_print_num_function();
-
-        /// @brief Emit helper routine for string printing.
-        void gen_print_string_function();
-
-        /**
-         * @brief Resolve a variable or temporary into a concrete symbol.
-         *
-         * @param a       Variable name.
-         * @param tempmap Temporary substitution map.
-         * @return Resolved symbol name.
-         */
-        static std::string handleVar(const std::string &a, const std::unordered_map<std::string, std::string> &tempmap);
-
-        /// @brief variant of pr with <code>jh::pod::string_view</code> (result of table-lookup), no new line
-        void emit_sv(jh::pod::string_view sv);
-
-    private:
-        const ir::InterCodeArray &arr;
-        std::unordered_map<std::string, std::string> ids;
-        std::unordered_map<std::string, std::string> consts;
-        std::unordered_map<std::string, std::string> tempmap;
-        std::vector<char> out;
-        bool need_print_num = false;
-        bool need_print_string = false;
-    };
-
-} // namespace pseu::codegen
+/**
+ * @file codegen.hpp
+ * @author JeongHan-Bae &lt;mastropseudo&#64;gmail.com&gt;
+ * @brief x86-64 code generation backend for PseudoCompiler IR: NASM text or machine code.
+ *
+ * @license MIT
+ *
+ * @verbatim
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ * @endverbatim
+ */
+
+#pragma once
+
+#include "ir.hpp"
+#include "session.hpp"
+#include "regalloc.hpp"
+#include "x86.hpp"
+#include <cstdint>
+#include <vector>
+#include <string>
+#include <string_view>
+
+namespace pseu::codegen {
+
+    /// @brief How generated code is entered and left.
+    enum class Runtime : std::uint8_t {
+        Process, ///< <code>_start</code> is the process entry point and ends with the exit syscall.
+        Hosted   ///< <code>_start</code> is called as a function (JIT) and returns, preserving callee-saved registers.
+    };
+
+    /**
+     * @brief x86-64 code generator from IR.
+     *
+     * This class consumes a linear IR instruction sequence and emits
+     * x86-64 code, as NASM-compatible assembly (generate()) or directly as
+     * machine code (encode()).
+     *
+     * Responsibilities include:
+     * <ul>
+     *   <li>Lowering IR instructions to concrete assembly sequences</li>
+     *   <li>Managing variable storage and temporaries</li>
+     *   <li>Emitting helper routines (e.g., print functions) on demand</li>
+     * </ul>
+     *
+     * The generator operates on pure-value IR instructions and performs
+     * static dispatch via <code>std::visit</code>, without RTTI or virtual
+     * dispatch.
+     */
+    class CodeGenerator final {
+    public:
+        /**
+         * @brief Construct a code generator.
+         *
+         * @param ir    IR of the compilation unit: instructions, variable
+         *              table, string constants and temporary count. It must
+         *              outlive the generator.
+         * @param alloc Register assignment (<code>-O1</code> and above), or
+         *              <code>nullptr</code> to keep every value in memory.
+         * @param runtime Entry and exit convention of <code>_start</code>.
+         */
+        explicit CodeGenerator(const ir::GeneratedIR &ir, const regalloc::Allocation *alloc = nullptr,
+                               Runtime runtime = Runtime::Process);
+
+        /**
+         * @brief Construct a code generator for the IR of a session.
+         *
+         * The text is generated into <code>session.text()</code>, whose
+         * capacity is kept for the next compilation of the session.
+         */
+        explicit CodeGenerator(session::CompilationSession &session, const regalloc::Allocation *alloc = nullptr,
+                               Runtime runtime = Runtime::Process);
+
+        CodeGenerator(const CodeGenerator &) = delete;
+
+        CodeGenerator &operator=(const CodeGenerator &) = delete;
+
+        /**
+         * @brief Generate the assembly text without writing it.
+         *
+         * @return View of the generator's buffer, valid until the next call.
+         */
+        [[nodiscard]] std::string_view generate();
+
+        /**
+         * @brief Encode the program straight to machine code.
+         *
+         * The lowering is the one generate() writes as text, run through
+         * <code>x86::Encoder</code> instead of <code>x86::NasmWriter</code>;
+         * no assembly text is produced or parsed.
+         *
+         * @return Sections, symbols and relocations, ready for
+         *         <code>pseu::elf</code> or <code>pseu::jit</code>.
+         */
+        [[nodiscard]] x86::Module encode();
+
+    private:
+        /// @brief Symbols of the program, by what they name.
+        struct Symbols final {
+            std::vector<std::uint32_t> vars;    // by slot; memory-resident variables only
+            std::vector<std::uint32_t> temps;   // by number (entry 0 unused)
+            std::vector<std::uint32_t> strings; // by number (entry 0 unused)
+            std::vector<std::uint32_t> lengths; // "S<n>_len" constants, by string number
+            std::vector<std::uint32_t> labels;  // by label id
+            std::uint32_t out_buf = 0, out_pos = 0, digit_pairs = 0;
+            std::uint32_t flush_out = 0, print_num = 0, print_string = 0;
+        };
+
+        /**
+         * @brief Upper bound of the generated text size, reserved once per
+         *        generate() so that the text buffer never grows.
+         */
+        [[nodiscard]] std::size_t estimate_size() const noexcept;
+
+        /// @brief Find the helpers the program needs.
+        void scan();
+
+        /**
+         * @brief Lower the whole program.
+         *
+         * Every lowering below is written once against the shared interface
+         * of <code>x86::Encoder</code> and <code>x86::NasmWriter</code>, so
+         * the bytes and the text always describe the same program.
+         */
+        template<typename Emitter>
+        void lower(Emitter &e);
+
+        /// @brief Create the symbols of variables, temporaries, strings, labels and helpers.
+        template<typename Emitter>
+        void declare(Emitter &e);
+
+        /// @brief Emit global/static variable definitions.
+        template<typename Emitter>
+        void gen_variables(Emitter &e);
+
+        /// @brief Emit string constants and program entry prologue.
+        template<typename Emitter>
+        void gen_start(Emitter &e);
+
+        /// @brief Emit program epilogue.
+        template<typename Emitter>
+        void gen_end(Emitter &e);
+
+        /// @brief Generate code for the full IR stream.
+        template<typename Emitter>
+        void gen_code(Emitter &e);
+
+        /// @brief Lower an assignment instruction.
+        template<typename Emitter>
+        void gen_assignment(Emitter &e, const ir::AssignmentCode &a);
+
+        /// @brief Lower a conditional comparison instruction.
+        template<typename Emitter>
+        void gen_compare(Emitter &e, const ir::CompareCodeIR &c);
+
+        /// @brief Lower a print instruction.
+        template<typename Emitter>
+        void gen_print(Emitter &e, const ir::PrintCodeIR &p);
+
+        /// @brief Lower a copy into a string variable: pointer and length.
+        template<typename Emitter>
+        void gen_string_assignment(Emitter &e, const ir::AssignmentCode &a);
+
+        /// @brief Register-allocated lowering of an assignment.
+        template<typename Emitter>
+        void gen_assignment_allocated(Emitter &e, const ir::AssignmentCode &a);
+
+        /// @brief Register-allocated lowering of a conditional comparison.
+        template<typename Emitter>
+        void gen_compare_allocated(Emitter &e, const ir::CompareCodeIR &c);
+
+        /**
+         * @brief Load an immediate too wide for a sign-extended 32-bit
+         *        field into <code>rbx</code>.
+         *
+         * @return Whether <code>rbx</code> now stands in for the operand.
+         */
+        template<typename Emitter>
+        bool load_wide(Emitter &e, const ir::Operand &o);
+
+        /**
+         * @brief Emit <code>flush_out</code>, which writes the pending
+         *        contents of the runtime output buffer to stdout.
+         *
+         * The print helpers only append to <code>outBuf</code>; the buffer
+         * is flushed when it cannot take the next value and once before
+         * the exit syscall.
+         */
+        template<typename Emitter>
+        void gen_flush_function(Emitter &e);
+
+        /// @brief Emit helper routine for integer printing (buffered).
+        template<typename Emitter>
+        void gen_print_num_function(Emitter &e);
+
+        /// @brief Emit helper routine for string printing (buffered).
+        template<typename Emitter>
+        void gen_print_string_function(Emitter &e);
+
+        /// @brief Register holding an operand, or Reg::none.
+        [[nodiscard]] regalloc::Reg loc(const ir::Operand &o) const noexcept;
+
+        /**
+         * @brief Machine operand of an IR operand.
+         *
+         * Immediates stay immediates, string constants become their
+         * address, and variables and temporaries their register or their
+         * <code>.bss</code> slot. The kind is taken from the operand tag;
+         * no text is inspected.
+         */
+        [[nodiscard]] x86::Operand operand(const ir::Operand &o) const noexcept;
+
+        /**
+         * @brief Length of a string operand: <code>S&lt;n&gt;_len</code> for a
+         *        constant, the second quadword of the pair for a variable.
+         */
+        [[nodiscard]] x86::Operand length(const ir::Operand &o) const noexcept;
+
+        /**
+         * @brief Whether an operand is a string: a constant, or a variable
+         *        not declared <code>int</code>.
+         *
+         * String variables are (pointer, length) pairs in <code>.bss</code>
+         * and are never register-allocated.
+         */
+        [[nodiscard]] bool is_string(const ir::Operand &o) const noexcept;
+
+    private:
+        const ir::GeneratedIR &ir;
+        const regalloc::Allocation *alloc;
+        Runtime runtime;
+        std::vector<char> buffer; // text, unless a session lends its buffer
+        std::vector<char> &out;
+        Symbols syms;
+        std::vector<std::uint8_t> bytes; // scratch for string constants
+        bool need_print_num = false;
+        bool need_print_string = false;
+    };
+
+} // namespace pseu::codegen
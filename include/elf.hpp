@@ -0,0 +1,77 @@
+/**
+ * @file elf.hpp
+ * @author JeongHan-Bae &lt;mastropseudo&#64;gmail.com&gt;
+ * @brief ELF64 relocatable object and static executable writers.
+ *
+ * @license MIT
+ *
+ * @verbatim
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ * @endverbatim
+ */
+
+
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "x86.hpp"
+
+namespace pseu::elf {
+
+    /// @brief Virtual address of the first byte of <code>.text</code> in executables.
+    inline constexpr std::uint64_t text_address = 0x401000;
+
+    /**
+     * @brief Write a relocatable ELF64 object (<code>ET_REL</code>).
+     *
+     * The object has <code>.text</code>, <code>.data</code>,
+     * <code>.bss</code>, a symbol table with every label, and
+     * <code>.rela.text</code>; it links with <code>ld</code> like the
+     * output of <code>nasm -f elf64</code>.
+     *
+     * @return Contents of the object file.
+     */
+    std::vector<std::uint8_t> object(const x86::Module &m);
+
+    /**
+     * @brief Link a module into a static ELF64 executable (<code>ET_EXEC</code>).
+     *
+     * <code>.text</code> is loaded read-execute at text_address;
+     * <code>.data</code> and <code>.bss</code> follow in one read-write
+     * segment. Relocations are applied in place and the entry point is
+     * <code>_start</code>.
+     *
+     * @return Contents of the executable file.
+     * @throws std::runtime_error if <code>_start</code> is missing or an
+     *         address does not fit its field.
+     */
+    std::vector<std::uint8_t> executable(const x86::Module &m);
+
+    /**
+     * @brief Write the bytes of object() or executable() to a file.
+     *
+     * @param executable Add the execute permission bits.
+     * @throws std::runtime_error if the file cannot be written.
+     */
+    void save(const std::string &path, const std::vector<std::uint8_t> &bytes, bool executable = false);
+
+} // namespace pseu::elf
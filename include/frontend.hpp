@@ -0,0 +1,122 @@
+/**
+ * @file frontend.hpp
+ * @author JeongHan-Bae &lt;mastropseudo&#64;gmail.com&gt;
+ * @brief Reentrant parsing entry points for the PseudoCompiler frontend.
+ *
+ * @license MIT
+ *
+ * @verbatim
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ * @endverbatim
+ */
+
+
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+#include "ast.hpp"
+
+namespace pseu::frontend {
+
+    /**
+     * @brief Per-parse state shared by the scanner and the parser.
+     *
+     * ParseContext replaces the former process globals
+     * (<code>g_ast_root</code>, <code>yylineno</code> and the exception
+     * thrown from <code>yyerror</code>). One context is created per
+     * parse and handed to both the reentrant Flex scanner (as its
+     * <code>yyextra</code>) and the Bison parser, so independent
+     * parses never share mutable state.
+     */
+    struct ParseContext final {
+        explicit ParseContext(ast::AstArena &arena) : arena(arena) {}
+
+        /// @brief Arena receiving every node built by the parser.
+        ast::AstArena &arena;
+
+        /// @brief Root of the completed AST, set by the <code>program</code> rule.
+        ast::NodeId root{ast::NodeId::null};
+
+        /// @brief Current 1-based source line, maintained by the scanner.
+        int line{1};
+
+        /// @brief First diagnostic reported by the scanner or the parser.
+        std::string error;
+
+        /// @brief Record a diagnostic; only the first one is kept.
+        void fail(std::string_view msg) {
+            if (error.empty())
+                error = std::string(msg) + " at line " + std::to_string(line);
+        }
+    };
+
+    /**
+     * @brief Parse a complete program.
+     *
+     * Each call owns its own scanner and parser state, so concurrent
+     * calls from different threads are safe as long as they use
+     * distinct arenas. Nodes are appended to <code>arena</code>; the
+     * caller decides when to release them (<code>AstArena::clear</code>).
+     *
+     * @param source     Program text; it does not need to be NUL-terminated.
+     * @param arena      Destination arena.
+     * @param first_line Line number of the first source line, when
+     *                   <code>source</code> is the tail of a larger file.
+     * @return Root StatementList of the program.
+     *
+     * @throws std::runtime_error on lexical or syntax errors, or if the
+     *         source is 2 GiB or larger.
+     */
+    ast::NodeId parse(std::string_view source, ast::AstArena &arena, int first_line = 1);
+
+    /**
+     * @brief Parse a program in place, without copying the source.
+     *
+     * The region is handed directly to <code>yy_scan_buffer</code>: it must
+     * be writable, end with two <code>'&bsol;0'</code> bytes and stay alive
+     * for the duration of the call.
+     *
+     * @param base        Start of the padded source region.
+     * @param padded_size Region size, including the two trailing NULs.
+     * @param arena       Destination arena.
+     * @param first_line  Line number of the first source line.
+     * @return Root StatementList of the program.
+     *
+     * @throws std::runtime_error on lexical or syntax errors, or if the
+     *         region is not NUL-padded or is 2 GiB or larger.
+     */
+    ast::NodeId parse_in_place(char *base, std::size_t padded_size, ast::AstArena &arena, int first_line = 1);
+
+    /**
+     * @brief Run the scanner alone over a program.
+     *
+     * No AST is built. This isolates lexing cost from parsing cost
+     * (used by the benchmarks).
+     *
+     * @param source Program text; it does not need to be NUL-terminated.
+     * @return Number of tokens, excluding end of input.
+     *
+     * @throws std::runtime_error on lexical errors, or if the source is
+     *         2 GiB or larger.
+     */
+    std::size_t tokenize(std::string_view source);
+
+} // namespace pseu::frontend
@@ -0,0 +1,124 @@
+/**
+ * @file incremental.hpp
+ * @author JeongHan-Bae &lt;mastropseudo&#64;gmail.com&gt;
+ * @brief Statement-granular incremental recompilation (--incremental).
+ *
+ * @license MIT
+ *
+ * @verbatim
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ * @endverbatim
+ */
+
+
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include <vector>
+#include "ast.hpp"
+#include "ir.hpp"
+#include "symbols.hpp"
+
+namespace pseu::incremental {
+
+    /// @brief One top-level statement of a source text.
+    struct Span final {
+        std::uint32_t end = 0;  ///< offset one past the last character of the statement
+        std::uint32_t line = 1; ///< line of that last character
+        std::uint64_t hash = 0; ///< FNV-1a of the text since the end of the previous statement
+    };
+
+    /**
+     * @brief Split a program into its top-level statements, without parsing it.
+     *
+     * A top-level statement ends at a <code>;</code> outside braces, or at
+     * the <code>}</code> that closes its outermost block unless
+     * <code>else</code> follows. String literals and <code>#</code>
+     * comments are skipped with the scanner's rules. Leading whitespace
+     * and comments belong to the statement that follows; text after the
+     * last statement belongs to none.
+     *
+     * For a program that parses, the spans are exactly its top-level
+     * statements; for one that does not, they are only a guess, which is
+     * harmless because nothing is reused from a failed compilation.
+     */
+    std::vector<Span> split(std::string_view source);
+
+    /// @brief Statements of the last Session::compile.
+    struct Stats final {
+        std::size_t statements = 0; ///< top-level statements
+        std::size_t reused = 0;     ///< leading statements whose IR was kept
+    };
+
+    /**
+     * @brief Recompiles a changing source, reusing the IR of the
+     *        statements before the first edit.
+     *
+     * The session keeps the resumable IR generator of the previous
+     * compilation and the Span of each of its top-level statements. The
+     * new source is split and its spans compared with the previous ones;
+     * the generator is rewound to the last matching statement (restoring
+     * the temporary, label and string counters from its checkpoint) and
+     * only the rest of the source is parsed and generated. The resulting
+     * IR is identical to that of a full compilation.
+     *
+     * IR handles are kept between compilations, so a session must stay on
+     * one thread, like the IR pool, and is only used with the pool
+     * backend: they would keep an ir::InstrArena from ever rewinding. So are the symbols they refer to: the
+     * session interns into its own table, which is cleared whenever no
+     * statement is reused, and the caller reads the returned IR under a
+     * sym::TableScope of symbols().
+     */
+    class Session final {
+    public:
+        /**
+         * @brief Generate the IR of a program.
+         *
+         * @param source      Program text.
+         * @param padded      Writable copy of <code>source</code> followed by
+         *                    two NULs, parsed in place (<code>--mmap</code>),
+         *                    or <code>nullptr</code> to parse from a copy.
+         * @param padded_size Size of <code>padded</code>, NULs included.
+         *
+         * @throws std::runtime_error on lexical, syntax or IR errors; the
+         *         session then starts over at the next compilation if the
+         *         error came from IR generation.
+         */
+        ir::GeneratedIR compile(std::string_view source, char *padded = nullptr, std::size_t padded_size = 0);
+
+        [[nodiscard]] const Stats &stats() const noexcept { return stats_; }
+
+        /// @brief Symbol table of the IR returned by compile().
+        [[nodiscard]] sym::SymbolTable &symbols() noexcept { return symbols_; }
+
+        /// @brief Forget the previous compilation.
+        void reset();
+
+    private:
+        sym::SymbolTable symbols_;
+        ir::IntermediateCodeGen gen_;
+        std::vector<Span> spans_; // of the source gen_ was built from, one per appended statement
+        ast::AstArena arena_;     // AST of the regenerated statements only
+        Stats stats_;
+    };
+
+} // namespace pseu::incremental
@@ -0,0 +1,108 @@
+/**
+ * @file interp.hpp
+ * @author JeongHan-Bae &lt;mastropseudo&#64;gmail.com&gt;
+ * @brief Bytecode interpreter for PseudoCompiler IR.
+ *
+ * @license MIT
+ *
+ * @verbatim
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ * @endverbatim
+ */
+
+
+
+#pragma once
+
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+#include "ir.hpp"
+
+namespace pseu::interp {
+
+    /// @brief Bytecode operation. Jumps and prints use fixed operand fields, see Instr.
+    enum class Op : std::uint8_t {
+        Mov, Add, Sub, Mul, Div,
+        Jmp, Jeq, Jne, Jlt, Jle, Jgt, Jge,
+        PrintInt, PrintStr,
+        Halt
+    };
+
+    /**
+     * @brief One bytecode instruction: operation and three frame slots.
+     *
+     * <ul>
+     *   <li>Mov: <code>a = b</code>; arithmetic: <code>a = b op c</code></li>
+     *   <li>Jmp: continue at <code>c</code>; Jcc: if <code>a cmp b</code> continue at <code>c</code></li>
+     *   <li>PrintInt: print slot <code>a</code>; PrintStr: print the text whose handle is in slot <code>a</code></li>
+     * </ul>
+     */
+    struct Instr final {
+        Op op;
+        std::uint32_t a = 0;
+        std::uint32_t b = 0;
+        std::uint32_t c = 0;
+    };
+
+    /**
+     * @brief IR pre-decoded for direct execution, without code generation.
+     *
+     * Decoding resolves labels to instruction indices and every operand to a
+     * slot of a flat <code>int64_t</code> frame: variables, temporaries,
+     * then one slot per distinct immediate, preloaded with its value.
+     *
+     * Strings follow the generated code, where a string variable is a
+     * (pointer, length) pair: here a (value, text) pair of slots. A string
+     * constant's value is its handle <code>n</code> (for S<i>n</i>) instead
+     * of an address, so only programs that print addresses as integers
+     * behave differently from the native build.
+     *
+     * Integer arithmetic wraps like the machine instructions; division by
+     * zero and <code>INT64_MIN / -1</code>, which trap in the native build,
+     * throw std::runtime_error.
+     */
+    class Program final {
+    public:
+        /// @throws std::runtime_error if a jump targets an undefined label.
+        explicit Program(const ir::GeneratedIR &ir);
+
+        /**
+         * @brief Execute from the first instruction to the end.
+         *
+         * Output is buffered and written to <code>out</code> in 64 KiB chunks
+         * and once at the end.
+         *
+         * @return Number of bytecode instructions executed.
+         * @throws std::runtime_error on a division trap.
+         */
+        std::uint64_t run(std::FILE *out = stdout) const;
+
+        [[nodiscard]] const std::vector<Instr> &code() const noexcept { return code_; }
+
+        [[nodiscard]] std::size_t frame_size() const noexcept { return frame_.size(); }
+
+    private:
+        std::vector<Instr> code_;
+        std::vector<std::int64_t> frame_;  ///< initial frame: zeros and preloaded immediates
+        std::vector<std::string> texts_;   ///< printable text by handle, 0 = nothing
+    };
+
+} // namespace pseu::interp
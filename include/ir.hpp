@@ -28,15 +28,30 @@
 
 #pragma once
 
+#include <cstddef>
+#include <cstdint>
 #include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
 #include <vector>
 #include <unordered_map>
 #include <memory>
 #include <variant>
 #include "ast.hpp"
+#include "symbols.hpp"
 #include <jh/meta>
 #include <jh/pool>
 
+/// @brief Non-zero to store IR in InstrArena instead of the deduplicating flat_pool (CMake <code>PSEU_IR_BACKEND=arena</code>).
+#ifndef PSEU_IR_ARENA
+#define PSEU_IR_ARENA 0
+#endif
+
+namespace pseu::session {
+    class CompilationSession;
+}
+
 namespace pseu::ir {
 
     struct AssignmentCode;
@@ -55,6 +70,69 @@ namespace pseu::ir {
         return (h ^ v) * 1099511628211ull;
     }
 
+    /**
+     * @brief Kind of an IR operand.
+     *
+     * The kind is decided once, when the IR is generated, so later
+     * passes never re-inspect operand text.
+     */
+    enum class OperandKind : std::uint8_t {
+        None, ///< No operand (e.g. the right side of a plain copy).
+        Var,  ///< Program variable; the value is its slot in GeneratedIR::variables.
+        Temp, ///< Compiler temporary; the value is its number (T1, T2, ...).
+        Imm,  ///< Integer immediate; the value is the number itself.
+        Str   ///< String constant; the value is its number (S1, S2, ...).
+    };
+
+    /**
+     * @brief Tagged 16-byte IR operand.
+     */
+    struct Operand final {
+        OperandKind kind{OperandKind::None};
+        std::int64_t value{0};
+
+        static constexpr Operand var(std::uint32_t slot) noexcept { return {OperandKind::Var, slot}; }
+
+        static constexpr Operand temp(std::uint32_t n) noexcept { return {OperandKind::Temp, n}; }
+
+        static constexpr Operand imm(std::int64_t v) noexcept { return {OperandKind::Imm, v}; }
+
+        static constexpr Operand str(std::uint32_t n) noexcept { return {OperandKind::Str, n}; }
+
+        /// @brief Slot or number of a Var, Temp or Str operand.
+        [[nodiscard]] constexpr std::uint32_t index() const noexcept { return static_cast<std::uint32_t>(value); }
+
+        bool operator==(const Operand &) const = default;
+    };
+
+    static_assert(sizeof(Operand) == 16);
+
+    /// @brief Mix an operand into a running hash.
+    constexpr inline std::uint64_t hash_mix(std::uint64_t h,
+                                            Operand const &o) noexcept {
+        h = hash_mix(h, static_cast<std::uint64_t>(o.kind));
+        return hash_mix(h, static_cast<std::uint64_t>(o.value));
+    }
+
+    /// @brief Arithmetic operator of an assignment (<code>None</code> for a plain copy).
+    enum class BinOp : std::uint8_t {
+        None, Add, Sub, Mul, Div
+    };
+
+    /// @brief Relational operator of a conditional jump.
+    enum class CmpOp : std::uint8_t {
+        Eq, Ne, Lt, Le, Gt, Ge
+    };
+
+    /// @brief Label number (L1, L2, ...).
+    using LabelId = std::uint32_t;
+
+    /// @brief Source spelling of an operator, e.g. <code>"+"</code>.
+    std::string_view spelling(BinOp op) noexcept;
+
+    /// @brief Source spelling of a comparison, e.g. <code>"<="</code>.
+    std::string_view spelling(CmpOp op) noexcept;
+
     /**
      * @brief Variant covering all IR instruction forms.
      *
@@ -85,10 +163,10 @@ namespace pseu::ir {
      * </pre>
      */
     struct AssignmentCode final {
-        std::string var;
-        std::string left;
-        std::string op;    // empty if none
-        std::string right; // may be empty
+        Operand var;
+        Operand left;
+        BinOp op;      // BinOp::None if none
+        Operand right; // OperandKind::None if none
 
         bool operator==(const AssignmentCode &) const = default;
     };
@@ -99,10 +177,10 @@ namespace pseu::ir {
         std::uint64_t operator()(AssignmentCode const &a) const noexcept {
             std::uint64_t h = 14695981039346656037ull; // FNV offset
 
-            h = hash_mix(h, jh::meta::fnv1a64(a.var.data(), a.var.size()));
-            h = hash_mix(h, jh::meta::fnv1a64(a.left.data(), a.left.size()));
-            h = hash_mix(h, jh::meta::fnv1a64(a.op.data(), a.op.size()));
-            h = hash_mix(h, jh::meta::fnv1a64(a.right.data(), a.right.size()));
+            h = hash_mix(h, a.var);
+            h = hash_mix(h, a.left);
+            h = hash_mix(h, static_cast<std::uint8_t>(a.op));
+            h = hash_mix(h, a.right);
 
             return h;
         }
@@ -112,7 +190,7 @@ namespace pseu::ir {
      * @brief Unconditional jump instruction.
      */
     struct JumpCode final {
-        std::string dist;
+        LabelId dist;
 
         bool operator==(const JumpCode &) const = default;
     };
@@ -123,7 +201,7 @@ namespace pseu::ir {
         std::uint64_t operator()(JumpCode const &a) const noexcept {
             std::uint64_t h = 14695981039346656037ull; // FNV offset
 
-            h = hash_mix(h, jh::meta::fnv1a64(a.dist.data(), a.dist.size()));
+            h = hash_mix(h, a.dist);
 
             return h;
         }
@@ -133,7 +211,7 @@ namespace pseu::ir {
      * @brief Label definition instruction.
      */
     struct LabelCode final {
-        std::string label;
+        LabelId label;
 
         bool operator==(const LabelCode &) const = default;
     };
@@ -144,7 +222,7 @@ namespace pseu::ir {
         std::uint64_t operator()(LabelCode const &a) const noexcept {
             std::uint64_t h = 14695981039346656037ull; // FNV offset
 
-            h = hash_mix(h, jh::meta::fnv1a64(a.label.data(), a.label.size()));
+            h = hash_mix(h, a.label);
 
             return h;
         }
@@ -159,10 +237,10 @@ namespace pseu::ir {
      * </pre>
      */
     struct CompareCodeIR final {
-        std::string left;
-        std::string operation;
-        std::string right;
-        std::string jump;
+        Operand left;
+        CmpOp operation;
+        Operand right;
+        LabelId jump;
 
         bool operator==(const CompareCodeIR &) const = default;
     };
@@ -173,10 +251,10 @@ namespace pseu::ir {
         std::uint64_t operator()(CompareCodeIR const &a) const noexcept {
             std::uint64_t h = 14695981039346656037ull; // FNV offset
 
-            h = hash_mix(h, jh::meta::fnv1a64(a.left.data(), a.left.size()));
-            h = hash_mix(h, jh::meta::fnv1a64(a.operation.data(), a.operation.size()));
-            h = hash_mix(h, jh::meta::fnv1a64(a.right.data(), a.right.size()));
-            h = hash_mix(h, jh::meta::fnv1a64(a.jump.data(), a.jump.size()));
+            h = hash_mix(h, a.left);
+            h = hash_mix(h, static_cast<std::uint8_t>(a.operation));
+            h = hash_mix(h, a.right);
+            h = hash_mix(h, a.jump);
 
             return h;
         }
@@ -189,7 +267,7 @@ namespace pseu::ir {
      */
     struct PrintCodeIR final {
         ast::PrintType type;
-        std::string value;
+        Operand value;
 
         bool operator==(const PrintCodeIR &) const = default;
     };
@@ -201,7 +279,7 @@ namespace pseu::ir {
             std::uint64_t h = 14695981039346656037ull; // FNV offset
 
             h = hash_mix(h, static_cast<std::uint8_t>(a.type));
-            h = hash_mix(h, jh::meta::fnv1a64(a.value.data(), a.value.size()));
+            h = hash_mix(h, a.value);
 
             return h;
         }
@@ -255,12 +333,162 @@ namespace pseu::ir {
      * This pool provides arena allocation, deduplication,
      * and pointer stability for IR instructions.
      */
-    using ir_pool_t = jh::conc::flat_pool<
+    using dedup_pool_t = jh::conc::flat_pool<
             IRInstr,
             jh::typed::monostate,
             IRInstrHash
     >;
 
+    /**
+     * @brief Bump arena for IR instructions, without deduplication.
+     *
+     * Provides the part of the <code>flat_pool</code> interface the
+     * compiler uses (<code>acquire</code>, <code>ptr</code>,
+     * <code>size</code>, <code>capacity</code>, <code>resize_pool</code>)
+     * so it can stand in for dedup_pool_t. Instructions are placed in
+     * fixed-size chunks and never move; nothing is hashed or compared.
+     *
+     * Handles count themselves: when the last one is released the arena
+     * rewinds and the next compilation reuses the chunks. Like the IR
+     * pool itself, an arena and its handles belong to one thread.
+     */
+    class InstrArena final {
+    public:
+        /// @brief Instructions per chunk.
+        static constexpr std::size_t chunk_size = 4096;
+
+        /// @brief Counted handle to an instruction of the arena.
+        class ptr final {
+        public:
+            /// @brief Returned by guard(): chunks never move, so there is nothing to lock.
+            struct no_guard final {
+            };
+
+            ptr() noexcept = default;
+
+            ptr(const ptr &o) noexcept: arena_(o.arena_), p_(o.p_) {
+                if (arena_)
+                    ++arena_->live_;
+            }
+
+            ptr(ptr &&o) noexcept: arena_(std::exchange(o.arena_, nullptr)), p_(o.p_) {}
+
+            ptr &operator=(ptr o) noexcept {
+                std::swap(arena_, o.arena_);
+                std::swap(p_, o.p_);
+                return *this;
+            }
+
+            ~ptr() {
+                if (arena_ && --arena_->live_ == 0)
+                    arena_->used_ = 0;
+            }
+
+            const IRInstr &operator*() const noexcept { return *p_; }
+
+            const IRInstr *operator->() const noexcept { return p_; }
+
+            [[nodiscard]] no_guard guard() const noexcept { return {}; }
+
+        private:
+            friend class InstrArena;
+
+            ptr(InstrArena *arena, const IRInstr *p) noexcept: arena_(arena), p_(p) { ++arena_->live_; }
+
+            InstrArena *arena_ = nullptr;
+            const IRInstr *p_ = nullptr;
+        };
+
+        /// @brief Place an instruction in the next free slot.
+        ptr acquire(IRInstr instr);
+
+        /// @brief Instructions placed since the arena last rewound.
+        [[nodiscard]] std::size_t size() const noexcept { return used_; }
+
+        /// @brief Slots in the allocated chunks.
+        [[nodiscard]] std::size_t capacity() const noexcept { return chunks_.size() * chunk_size; }
+
+        /// @brief Release the chunks beyond the one in use (all of them when no handle is live).
+        void resize_pool();
+
+    private:
+        static_assert(std::is_trivially_destructible_v<IRInstr>, "rewinding must not skip destructors");
+
+        /// @brief Uninitialized storage of one instruction.
+        struct Slot final {
+            alignas(IRInstr) std::byte bytes[sizeof(IRInstr)];
+        };
+
+        std::vector<std::unique_ptr<Slot[]>> chunks_;
+        std::size_t used_ = 0;
+        std::size_t live_ = 0;
+    };
+
+    /// @brief IR storage backend, chosen at build time (PSEU_IR_ARENA).
+#if PSEU_IR_ARENA
+    using ir_pool_t = InstrArena;
+    inline constexpr std::string_view pool_backend = "arena";
+#else
+    using ir_pool_t = dedup_pool_t;
+    inline constexpr std::string_view pool_backend = "flat_pool";
+#endif
+
+    /**
+     * @brief Intern an instruction in the IR pool in use on the calling
+     *        thread: that of the innermost PoolScope, or else the
+     *        thread's own pool.
+     *
+     * Every IR producer (the generator and later passes) goes through
+     * this pool, so structurally equal instructions of a compilation share
+     * storage. Instructions must not outlive their pool, nor cross threads.
+     */
+    ir_pool_t::ptr intern(IRInstr instr);
+
+    /**
+     * @brief Makes intern() use <code>pool</code> on the calling thread
+     *        for the lifetime of the scope.
+     *
+     * This is how a compilation interns into the pool of its
+     * session::CompilationSession instead of the thread's own. Scopes
+     * nest; each restores the pool in use before it.
+     */
+    class PoolScope final {
+    public:
+        explicit PoolScope(ir_pool_t &pool) noexcept;
+
+        ~PoolScope();
+
+        PoolScope(const PoolScope &) = delete;
+
+        PoolScope &operator=(const PoolScope &) = delete;
+
+    private:
+        ir_pool_t *previous_;
+    };
+
+    /// @brief Storage statistics of the IR pool in use on the calling thread (<code>--ir-stats</code>).
+    struct PoolStats final {
+        std::size_t capacity = 0;      ///< slots reserved by the pool
+        std::size_t live = 0;          ///< instructions held
+        std::uint64_t interned = 0;    ///< intern() calls while counting
+        std::uint64_t dedup_hits = 0;  ///< calls answered with an instruction already in the pool
+        double hash_seconds = 0;       ///< IRInstrHash over the interned instructions, timed apart from the pool
+        double intern_seconds = 0;     ///< acquire(), its own hashing and probing included
+    };
+
+    /**
+     * @brief Start (clearing the counters) or stop counting intern() calls
+     *        of the calling thread.
+     *
+     * While counting, every call is timed and its instruction is hashed
+     * once more to measure hashing alone, so the counted compilation is
+     * slower than an uncounted one.
+     */
+    void count_pool(bool on) noexcept;
+
+    /// @brief Counters of count_pool() and the current capacity and size of the pool in use.
+    [[nodiscard]] PoolStats pool_stats() noexcept;
+
     /// @brief Linear sequence of IR instructions.
     struct InterCodeArray final {
         std::vector<ir_pool_t::ptr> code;
@@ -268,27 +496,91 @@ namespace pseu::ir {
         void append(const ir_pool_t::ptr &n) { code.push_back(n); }
     };
 
+    /// @brief Program variable referenced by <code>Operand::var</code>.
+    struct Variable final {
+        sym::SymbolId name; // mangled name, e.g. "Vx"
+        sym::SymbolId type; // known::kw_int, known::kw_string, or known::empty if never declared
+    };
+
     /// @brief Complete IR output of a compilation unit.
     struct GeneratedIR final {
         InterCodeArray code;
-        std::unordered_map<std::string, std::string> identifiers;
-        std::unordered_map<std::string, std::string> constants;
+        std::vector<Variable> variables;     // indexed by variable slot
+        std::vector<sym::SymbolId> constants; // literal text of S1, S2, ...
+        std::uint32_t temps{0};              // temporaries T1 .. T<temps>
     };
 
+    /**
+     * @brief Textual form of an operand, as printed in IR dumps.
+     *
+     * Variables print their mangled name, immediates their value, and
+     * temporaries and string constants their generated name.
+     */
+    std::string to_string(const Operand &o, const GeneratedIR &ir);
+
+    /// @brief Textual form of an instruction, as printed in IR dumps (no new line).
+    std::string to_string(const IRInstr &instr, const GeneratedIR &ir);
+
     /**
      * @brief IR generator from AST.
      *
      * Converts AST nodes into a flat, deduplicated IR stream
      * using static visitation-based dispatch.
+     *
+     * A default-constructed generator is resumable: append() generates
+     * the top-level statements of a program one at a time and records a
+     * checkpoint after each, and rewind() returns to any of them, so that
+     * only the statements after an edit are generated again
+     * (<code>--incremental</code>).
      */
     class IntermediateCodeGen final {
     public:
-        explicit IntermediateCodeGen(const std::shared_ptr<ast::ASTNode> &root);
+        /**
+         * @param tree Arena holding the parsed program.
+         * @param root Root StatementList returned by the parser.
+         */
+        IntermediateCodeGen(const ast::AstArena &tree, ast::NodeId root);
+
+        /**
+         * @brief Generate the program parsed into <code>session.ast()</code>
+         *        into <code>session.ir()</code>.
+         *
+         * Instructions are interned in the session's pool and the vectors
+         * of <code>session.ir()</code> are reused, so a warm session
+         * allocates little. get() is empty afterwards.
+         *
+         * @param root Root StatementList returned by the parser.
+         */
+        IntermediateCodeGen(session::CompilationSession &session, ast::NodeId root);
+
+        /// @brief Empty resumable generator.
+        IntermediateCodeGen() = default;
 
         GeneratedIR get();
 
+        /**
+         * @brief Generate the top-level statements of <code>root</code>
+         *        after those already generated.
+         *
+         * The arena is only read during the call.
+         */
+        void append(const ast::AstArena &tree, ast::NodeId root);
+
+        /**
+         * @brief Drop everything generated after the first
+         *        <code>statements</code> appended top-level statements.
+         *
+         * Instructions, variables, their types, string constants and the
+         * temporary and label counters are restored to the checkpoint, so
+         * appending the same statements again produces the same IR.
+         */
+        void rewind(std::size_t statements);
+
+        /// @brief Number of top-level statements appended.
+        [[nodiscard]] std::size_t statements() const noexcept { return checkpoints.size(); }
+
     private:
-        std::string exec_expr(const std::shared_ptr<ast::ASTNode> &n);
+        Operand exec_expr(ast::NodeId n);
 
         void exec_assignment(const ast::Assignment *a);
 
@@ -296,37 +588,41 @@ namespace pseu::ir {
 
         void exec_while(const ast::WhileStatement *w);
 
-        std::string exec_condition(const ast::Condition *c);
+        LabelId exec_condition(const ast::Condition *c);
 
         void exec_print(const ast::PrintStatement *p);
 
         void exec_declaration(const ast::Declaration *d);
 
-        void exec_statement(const std::shared_ptr<ast::ASTNode> &n);
+        void exec_statement(ast::NodeId n);
+
+        Operand nextTemp();
 
-        std::string nextTemp();
+        LabelId nextLabel();
 
-        std::string nextLabel();
+        [[maybe_unused]] [[nodiscard]] LabelId currentLabel() const;
 
-        [[maybe_unused]] [[nodiscard]] std::string currentLabel() const;
+        /// @brief Register a string constant with the given literal text.
+        Operand addString(sym::SymbolId text);
 
-        std::string nextStringSym();
+        /// @brief Slot of a variable, allocated on first reference.
+        std::uint32_t slotOf(sym::SymbolId name);
 
         template<typename T>
-        std::string exec_expr_node(const T &);
+        Operand exec_expr_node(const T &);
 
-        [[maybe_unused]] std::string exec_expr_node(const ast::IdentifierNode &id);
+        [[maybe_unused]] Operand exec_expr_node(const ast::IdentifierNode &id);
 
-        [[maybe_unused]] std::string exec_expr_node(const ast::NumberNode &num);
+        [[maybe_unused]] Operand exec_expr_node(const ast::NumberNode &num);
 
-        [[maybe_unused]] std::string exec_expr_node(const ast::StringLiteralNode &str);
+        [[maybe_unused]] Operand exec_expr_node(const ast::StringLiteralNode &str);
 
-        [[maybe_unused]] std::string exec_expr_node(const ast::BinOpNode &bin);
+        [[maybe_unused]] Operand exec_expr_node(const ast::BinOpNode &bin);
 
         template<typename T>
         void exec_statement_node(const T &);
 
-        [[maybe_unused]] void exec_statement_node(const ast::Statement &st);
+        [[maybe_unused]] void exec_statement_node(const ast::StatementList &st);
 
         [[maybe_unused]] void exec_statement_node(const ast::IfStatement &is);
 
@@ -338,14 +634,32 @@ namespace pseu::ir {
 
         [[maybe_unused]] void exec_statement_node(const ast::Assignment &asg);
 
+        /// @brief Set the type of a variable, logging the previous one when resumable.
+        void setType(std::uint32_t slot, sym::SymbolId type);
+
+        /// @brief Generator state after a top-level statement.
+        struct Checkpoint final {
+            std::size_t code = 0;
+            std::size_t variables = 0;
+            std::size_t constants = 0;
+            std::size_t retyped = 0;
+            std::uint32_t tCounter = 1;
+            LabelId lCounter = 1;
+        };
+
     private:
-        std::shared_ptr<ast::ASTNode> root;
+        const ast::AstArena *tree = nullptr;
         InterCodeArray arr;
-        std::unordered_map<std::string, std::string> identifiers;
-        std::unordered_map<std::string, std::string> constants;
-        int tCounter{1};
-        int lCounter{1};
-        int sCounter{1};
+        std::vector<Variable> variables;
+        std::unordered_map<sym::SymbolId, std::uint32_t> slots;
+        std::vector<sym::SymbolId> constants;
+        std::uint32_t tCounter{1};
+        LabelId lCounter{1};
+
+        // resumable generation (append / rewind)
+        bool resumable = false;
+        std::vector<Checkpoint> checkpoints;                          // one per appended statement
+        std::vector<std::pair<std::uint32_t, sym::SymbolId>> retyped; // (slot, previous type), undo log
     };
 
 } // namespace pseu::ir
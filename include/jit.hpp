@@ -0,0 +1,76 @@
+/**
+ * @file jit.hpp
+ * @author JeongHan-Bae &lt;mastropseudo&#64;gmail.com&gt;
+ * @brief In-process execution of assembled programs.
+ *
+ * @license MIT
+ *
+ * @verbatim
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ * @endverbatim
+ */
+
+
+
+#pragma once
+
+#include <cstddef>
+#include "x86.hpp"
+
+namespace pseu::jit {
+
+    /**
+     * @brief Assembled program loaded into executable memory of this process.
+     *
+     * <code>.text</code>, <code>.data</code> and <code>.bss</code> share one
+     * anonymous mapping, created read-write, relocated in place, after which
+     * the text pages are switched to read-execute. The mapping is placed in
+     * the low 2 GiB (<code>MAP_32BIT</code>) because the encoder uses
+     * sign-extended 32-bit absolute addresses, as in a non-PIE executable.
+     *
+     * The code must be generated with <code>codegen::Runtime::Hosted</code>
+     * so that <code>_start</code> returns instead of exiting the process.
+     * Supported on x86-64 Linux only.
+     */
+    class Program final {
+    public:
+        /// @throws std::runtime_error if the platform is unsupported or mapping fails.
+        explicit Program(const x86::Module &m);
+
+        Program(const Program &) = delete;
+
+        Program &operator=(const Program &) = delete;
+
+        ~Program();
+
+        /**
+         * @brief Call <code>_start</code>.
+         *
+         * The program writes straight to file descriptor 1; flush any
+         * buffered C++ output first to keep the order.
+         */
+        void run() const;
+
+    private:
+        void *base_ = nullptr;
+        std::size_t size_ = 0;
+        void (*entry_)() = nullptr;
+    };
+
+} // namespace pseu::jit
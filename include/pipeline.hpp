@@ -0,0 +1,148 @@
+/**
+ * @file pipeline.hpp
+ * @author JeongHan-Bae &lt;mastropseudo&#64;gmail.com&gt;
+ * @brief The compile pipeline shared by the compiler, the compile server and the bench.
+ *
+ * @license MIT
+ *
+ * @verbatim
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ * @endverbatim
+ */
+
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "ast.hpp"
+#include "cfg.hpp"
+#include "codegen.hpp"
+#include "ir.hpp"
+#include "regalloc.hpp"
+#include "report.hpp"
+#include "session.hpp"
+#include "symbols.hpp"
+#include "x86.hpp"
+
+namespace pseu::pipeline {
+
+    /// @brief Output file of a compilation, as <code>--emit</code>.
+    enum class Emit : std::uint8_t {
+        Asm, ///< NASM text (default)
+        Obj, ///< ELF64 relocatable object, for <code>ld</code>
+        Exe  ///< Static ELF64 executable
+    };
+
+    /// @brief What a compilation does between the IR and the code generator.
+    struct Options final {
+        int opt_level = 0;                                     ///< 1 and above: allocate registers
+        codegen::Runtime runtime = codegen::Runtime::Process;  ///< entry convention of the generated code
+        bool cfg = false;                                      ///< build the CFG below <code>-O1</code> too
+    };
+
+    /**
+     * @brief One compilation in a session::CompilationSession:
+     *        parse → irgen → cfg → regalloc → codegen → link.
+     *
+     * The constructor resets the session and binds its IR pool and symbol
+     * table to the thread until the compilation is destroyed. The stages
+     * are called in order; each is measured under its
+     * <code>--time-report</code> phase name when a report is given.
+     * analyze() runs at the first code generation if the caller did not
+     * run it before.
+     *
+     * Everything the compilation produces lives in the session and is
+     * valid until the session is reset.
+     */
+    class Compilation final {
+    public:
+        /**
+         * @param session Storage the compilation is done in; reset first.
+         * @param options Optimization level and runtime.
+         * @param report  Per-phase measurements, or <code>nullptr</code>.
+         * @param symbols Table to intern into instead of the session's
+         *                (<code>--incremental</code>), or <code>nullptr</code>.
+         */
+        explicit Compilation(session::CompilationSession &session, const Options &options = {},
+                             report::TimeReport *report = nullptr, sym::SymbolTable *symbols = nullptr);
+
+        Compilation(const Compilation &) = delete;
+
+        Compilation &operator=(const Compilation &) = delete;
+
+        /// @brief Parse <code>source</code> into the session's AST. @throws std::runtime_error on a syntax error.
+        ast::NodeId parse(std::string_view source);
+
+        /// @brief parse() over a buffer padded as frontend::parse_in_place requires.
+        ast::NodeId parse_in_place(char *base, std::size_t padded_size);
+
+        /// @brief Generate the IR of the tree at <code>root</code> into the session.
+        const ir::GeneratedIR &generate(ast::NodeId root);
+
+        /// @brief IR of the compilation, for a caller that produces it itself (<code>--incremental</code>).
+        [[nodiscard]] ir::GeneratedIR &ir() noexcept { return session_.ir(); }
+
+        /**
+         * @brief Build the CFG and allocate registers, as the options ask.
+         *
+         * @return The CFG, or <code>nullptr</code> when none was needed.
+         * @throws std::runtime_error if a jump targets an undefined label.
+         */
+        const cfg::CFG *analyze();
+
+        /// @brief Assembly text, in the session's text buffer.
+        std::string_view assembly();
+
+        /// @brief Machine code, for pseu::elf or pseu::jit.
+        x86::Module encode();
+
+        /**
+         * @brief Produce the contents of the output file.
+         *
+         * @param bytes Replaced with the file; its capacity is reused when large enough.
+         */
+        void output(Emit emit, std::vector<std::uint8_t> &bytes);
+
+        /**
+         * @brief Produce the output file and write it to <code>path</code>.
+         *
+         * @throws std::runtime_error if the file cannot be opened or written in full.
+         */
+        void write(Emit emit, const std::string &path);
+
+    private:
+        codegen::CodeGenerator &generator();
+
+        session::CompilationSession &session_;
+        Options options_;
+        report::TimeReport *report_;
+        ir::PoolScope pool_;
+        sym::TableScope symbols_;
+        bool analyzed_ = false;
+        std::optional<cfg::CFG> graph_;
+        std::optional<regalloc::Allocation> allocation_;
+        std::optional<codegen::CodeGenerator> codegen_;
+    };
+
+} // namespace pseu::pipeline
@@ -0,0 +1,98 @@
+/**
+ * @file regalloc.hpp
+ * @author JeongHan-Bae &lt;mastropseudo&#64;gmail.com&gt;
+ * @brief Linear-scan register allocation for the NASM backend.
+ *
+ * @license MIT
+ *
+ * @verbatim
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ * @endverbatim
+ */
+
+
+#pragma once
+
+#include <cstdint>
+#include <string_view>
+#include <vector>
+#include "cfg.hpp"
+#include "ir.hpp"
+
+namespace pseu::regalloc {
+
+    /**
+     * @brief x86-64 general-purpose register.
+     *
+     * <code>rax</code> and <code>rbx</code> are reserved as scratch by the
+     * code generator and are never allocated.
+     */
+    enum class Reg : std::uint8_t {
+        rax, rcx, rdx, rbx, rsi, rdi, r8, r9, r10, r11, r12, r13, r14, r15,
+        none = 0xFF ///< Value lives in memory (<code>.bss</code>).
+    };
+
+    /// @brief NASM name of a register, e.g. <code>"r12"</code>.
+    std::string_view name(Reg r) noexcept;
+
+    /**
+     * @brief Register assignment of one compilation unit.
+     *
+     * Every variable slot and temporary maps to a register or to
+     * Reg::none (memory). A value keeps a single location for the
+     * whole program.
+     */
+    struct Allocation final {
+        std::vector<Reg> vars;  // indexed by variable slot
+        std::vector<Reg> temps; // indexed by temporary number (entry 0 unused)
+
+        /// @brief Registers of values read before any write; cleared at entry like <code>.bss</code>.
+        std::vector<Reg> zeroed;
+
+        /// @brief Location of a Var or Temp operand; Reg::none for anything else.
+        [[nodiscard]] Reg location(const ir::Operand &o) const noexcept;
+    };
+
+    /**
+     * @brief Allocate registers with linear scan over live intervals.
+     *
+     * Liveness is solved on the control-flow graph, and each value gets
+     * the hull of its live positions as its interval (Poletto & Sarkar).
+     * Intervals are scanned in start order. Under pressure, the interval
+     * ending last is spilled to memory.
+     *
+     * Register constraints:
+     * <ul>
+     *   <li>Allocatable: rcx, rdx, rsi, rdi, r8–r15.</li>
+     *   <li>Values live across a print call avoid the registers the
+     *       print helpers and <code>syscall</code> clobber (rcx, rdx, rsi,
+     *       rdi, r11).</li>
+     *   <li>Values live at a division avoid rdx, which <code>cqo</code>
+     *       / <code>idiv</code> overwrite.</li>
+     * </ul>
+     *
+     * Only <code>int</code> variables and temporaries are candidates;
+     * string and undeclared variables stay in memory.
+     *
+     * @param ir    IR of the compilation unit.
+     * @param graph CFG built from <code>ir.code</code>.
+     */
+    Allocation allocate(const ir::GeneratedIR &ir, const cfg::CFG &graph);
+
+} // namespace pseu::regalloc
@@ -0,0 +1,134 @@
+/**
+ * @file report.hpp
+ * @author JeongHan-Bae &lt;mastropseudo&#64;gmail.com&gt;
+ * @brief Per-phase timing and memory report (--time-report).
+ *
+ * @license MIT
+ *
+ * @verbatim
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ * @endverbatim
+ */
+
+
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <ostream>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace pseu::report {
+
+    /**
+     * @brief Heap allocation counters.
+     *
+     * The library only reads them; an executable that wants allocation
+     * figures replaces the global <code>operator new</code> and adds to
+     * them while <code>enabled</code> is set.
+     */
+    struct Allocations final {
+        std::atomic<bool> enabled{false};
+        std::atomic<std::uint64_t> count{0};
+        std::atomic<std::uint64_t> bytes{0};
+    };
+
+    /// @brief The process-wide allocation counters.
+    Allocations &allocations() noexcept;
+
+    /// @brief Peak resident set size of the process so far, in KiB (0 if unknown).
+    std::uint64_t peak_rss_kib() noexcept;
+
+    /// @brief Measurements of one phase.
+    struct Phase final {
+        std::string_view name;
+        std::string_view unit;        ///< what <code>items</code> counts, e.g. "tokens"
+        double seconds = 0;
+        std::uint64_t allocations = 0;
+        std::uint64_t allocated_bytes = 0;
+        std::uint64_t peak_rss_kib = 0; ///< process peak at the end of the phase
+        std::uint64_t items = 0;
+    };
+
+    /**
+     * @brief Phase-by-phase report of one compilation.
+     *
+     * Phases are timed with <code>std::chrono::steady_clock</code>.
+     * Allocation figures are zero unless the executable counts them (see
+     * Allocations); counting is switched on while a report exists.
+     */
+    class TimeReport final {
+    public:
+        TimeReport() noexcept;
+
+        TimeReport(const TimeReport &) = delete;
+
+        TimeReport &operator=(const TimeReport &) = delete;
+
+        ~TimeReport();
+
+        /**
+         * @brief Run one phase and record it.
+         *
+         * @param f Phase body; returns the number of <code>unit</code> items it produced.
+         */
+        template<typename F>
+        void measure(std::string_view name, std::string_view unit, F &&f) {
+            auto &a = allocations();
+            const auto count = a.count.load(std::memory_order_relaxed);
+            const auto bytes = a.bytes.load(std::memory_order_relaxed);
+            const auto begin = std::chrono::steady_clock::now();
+
+            const auto items = static_cast<std::uint64_t>(std::forward<F>(f)());
+
+            Phase p{name, unit};
+            p.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+            p.allocations = a.count.load(std::memory_order_relaxed) - count;
+            p.allocated_bytes = a.bytes.load(std::memory_order_relaxed) - bytes;
+            p.peak_rss_kib = peak_rss_kib();
+            p.items = items;
+            phases_.push_back(p);
+        }
+
+        [[nodiscard]] const std::vector<Phase> &phases() const noexcept { return phases_; }
+
+        /// @brief Aligned table, one line per phase and a total.
+        void write_text(std::ostream &os) const;
+
+        /// @brief One JSON object: <code>{"phases": [...], "total_seconds": ...}</code>.
+        void write_json(std::ostream &os) const;
+
+    private:
+        std::vector<Phase> phases_;
+    };
+
+    /// @brief TimeReport::measure when a report is requested, otherwise just the phase body.
+    template<typename F>
+    void timed(TimeReport *report, std::string_view name, std::string_view unit, F &&f) {
+        if (report)
+            report->measure(name, unit, std::forward<F>(f));
+        else
+            (void) std::forward<F>(f)();
+    }
+
+} // namespace pseu::report
@@ -0,0 +1,85 @@
+/**
+ * @file server.hpp
+ * @author JeongHan-Bae &lt;mastropseudo&#64;gmail.com&gt;
+ * @brief Resident compile server and its client over a Unix domain socket.
+ *
+ * @license MIT
+ *
+ * @verbatim
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ * @endverbatim
+ */
+
+
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace pseu::server {
+
+    /// @brief Output requested from the server, as <code>--emit</code>.
+    enum class Format : std::uint8_t {
+        Asm, Obj, Exe
+    };
+
+    /// @brief Outcome of one compile request.
+    struct Response final {
+        bool ok = false;
+        std::vector<char> payload; ///< output file contents, or the diagnostic when not ok
+    };
+
+    /**
+     * @brief Serve compile requests on a Unix domain socket until the process is stopped.
+     *
+     * A socket left at <code>path</code> by a server that is gone is
+     * replaced; any other file, or a socket a server still answers on, is
+     * an error and is left alone. Each of the
+     * <code>workers</code> threads accepts connections and serves their
+     * requests one after another in its own session::CompilationSession,
+     * so its IR pool and buffers stay warm; the session is reset as soon
+     * as a response is sent, and buffers or a session grown by a large
+     * request are trimmed before the next one. A connection that sends
+     * nothing for 5 seconds, or stalls mid-message, is closed, so idle or
+     * slow clients cannot hold every worker.
+     *
+     * Wire format (host byte order, one or more requests per connection):
+     * <ul>
+     *   <li>request: 16-byte header (<code>"PSEU"</code>, -O level, Format,
+     *       2 reserved bytes, 64-bit source length), then the source</li>
+     *   <li>response: 16-byte header (status 0 = ok, 7 reserved bytes,
+     *       64-bit payload length), then the payload</li>
+     * </ul>
+     *
+     * @throws std::runtime_error if <code>path</code> is taken, or the socket cannot be set up.
+     */
+    [[noreturn]] void serve(const std::string &path, unsigned workers);
+
+    /**
+     * @brief Send one compile request to a server.
+     *
+     * @throws std::runtime_error if the server cannot be reached or the
+     *         connection breaks; compile errors come back in the Response.
+     */
+    Response request(const std::string &path, std::string_view source, int opt_level, Format format);
+
+} // namespace pseu::server
@@ -0,0 +1,118 @@
+/**
+ * @file session.hpp
+ * @author JeongHan-Bae &lt;mastropseudo&#64;gmail.com&gt;
+ * @brief Compilation state reused across the compilations of a long-running process.
+ *
+ * @license MIT
+ *
+ * @verbatim
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ * @endverbatim
+ */
+
+
+#pragma once
+
+#include <cstddef>
+#include <vector>
+#include "ast.hpp"
+#include "ir.hpp"
+#include "symbols.hpp"
+
+namespace pseu::session {
+
+    /**
+     * @brief Storage reused by the compilations of one thread.
+     *
+     * A session owns what a compilation fills: the AST arena, a symbol
+     * table, an IR pool, the vectors of the generated IR and the assembly
+     * text buffer. The interactive loop, <code>--watch</code>, each batch
+     * worker and each server thread keep one session and compile in it
+     * again and again:
+     * <ul>
+     *   <li>reset() empties it and keeps every capacity, so a warm
+     *       session compiles without growing anything;</li>
+     *   <li>shrink_to() returns the capacity above a budget, so one large
+     *       program does not pin its peak footprint for the lifetime of
+     *       the process.</li>
+     * </ul>
+     * The budget covers everything a compilation grows, symbols included,
+     * except what an incremental::Session keeps on purpose.
+     *
+     * pipeline::Compilation runs a compilation in a session: it parses
+     * into ast(), passes the session to ir::IntermediateCodeGen and
+     * codegen::CodeGenerator, and binds a sym::TableScope of symbols() and
+     * an ir::PoolScope of pool() for the passes that intern on their own. Like the IR pool, a session is used by one
+     * thread at a time, and its IR must not outlive it.
+     */
+    class CompilationSession final {
+    public:
+        CompilationSession() = default;
+
+        CompilationSession(const CompilationSession &) = delete;
+
+        CompilationSession &operator=(const CompilationSession &) = delete;
+
+        /// @brief AST of the current compilation.
+        [[nodiscard]] ast::AstArena &ast() noexcept { return ast_; }
+
+        /// @brief Symbol table of the session, to bind with sym::TableScope.
+        [[nodiscard]] sym::SymbolTable &symbols() noexcept { return symbols_; }
+
+        /// @brief IR pool of the session, to bind with ir::PoolScope.
+        [[nodiscard]] ir::ir_pool_t &pool() noexcept { return pool_; }
+
+        /// @brief IR of the current compilation.
+        [[nodiscard]] ir::GeneratedIR &ir() noexcept { return ir_; }
+
+        /// @brief Assembly text buffer lent to codegen::CodeGenerator.
+        [[nodiscard]] std::vector<char> &text() noexcept { return text_; }
+
+        /**
+         * @brief Forget the current compilation, keeping all capacity.
+         *
+         * No memory is returned. The cost is linear in the size of the
+         * IR: each instruction handle is released on its own, returning
+         * its slot to the pool, and the symbols past the known ones are
+         * dropped from the index. Only the AST arena and the text are
+         * cleared in constant time.
+         */
+        void reset() noexcept;
+
+        /**
+         * @brief Memory budget: if more than <code>bytes</code> are
+         *        reserved, return all free capacity.
+         *
+         * The current contents stay valid; after reset() the session
+         * keeps next to nothing, and the next compilation grows it again.
+         */
+        void shrink_to(std::size_t bytes);
+
+        /// @brief Approximate bytes reserved by the session.
+        [[nodiscard]] std::size_t retained_bytes() const noexcept;
+
+    private:
+        ir::ir_pool_t pool_; // first: destroyed after the IR handles
+        sym::SymbolTable symbols_;
+        ast::AstArena ast_;
+        ir::GeneratedIR ir_;
+        std::vector<char> text_;
+    };
+
+} // namespace pseu::session
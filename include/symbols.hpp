@@ -0,0 +1,205 @@
+/**
+ * @file symbols.hpp
+ * @author JeongHan-Bae &lt;mastropseudo&#64;gmail.com&gt;
+ * @brief Process-wide interned symbol table shared by all compilation phases.
+ *
+ * @license MIT
+ *
+ * @verbatim
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ * @endverbatim
+ */
+
+
+#pragma once
+
+#include <array>
+#include <bit>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <shared_mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+#include <jh/meta>
+
+namespace pseu::sym {
+
+    /**
+     * @brief Compact handle to an interned string.
+     *
+     * Identifiers, string literals and operators are interned once and
+     * then passed around as 32-bit ids. Equal ids denote equal text,
+     * so comparison and hashing never touch the characters.
+     */
+    using SymbolId = std::uint32_t;
+
+    /**
+     * @brief Symbols pre-interned at fixed ids.
+     *
+     * The parser and the IR generator refer to operators and type
+     * keywords through these constants without any lookup.
+     * <code>empty</code> doubles as the "no symbol" marker
+     * (e.g. an assignment without operator).
+     */
+    namespace known {
+        inline constexpr SymbolId empty = 0;
+        inline constexpr SymbolId plus = 1;
+        inline constexpr SymbolId minus = 2;
+        inline constexpr SymbolId star = 3;
+        inline constexpr SymbolId slash = 4;
+        inline constexpr SymbolId kw_int = 5;
+        inline constexpr SymbolId kw_string = 6;
+        inline constexpr SymbolId eq = 7;
+        inline constexpr SymbolId ne = 8;
+        inline constexpr SymbolId lt = 9;
+        inline constexpr SymbolId le = 10;
+        inline constexpr SymbolId gt = 11;
+        inline constexpr SymbolId ge = 12;
+
+        inline constexpr std::array<std::string_view, 13> spellings{
+                "", "+", "-", "*", "/", "int", "string",
+                "==", "!=", "<", "<=", ">", ">="
+        };
+    } // namespace known
+
+    /**
+     * @brief Thread-safe string interner.
+     *
+     * Text is stored once in address-stable storage; ids index a dense
+     * table of views into it. Lookups take a shared lock and only the
+     * first occurrence of a string takes the exclusive lock, so
+     * concurrent parses mostly proceed in parallel.
+     *
+     * The id table is made of chunks of doubling size that never move,
+     * so view() reads it without locking: an id is only known to a thread
+     * after the intern() call that published its entry. An empty table
+     * is small, as every session has one.
+     *
+     * A table only grows until clear(). Long-running drivers therefore
+     * intern into the table of a session::CompilationSession, bound with
+     * TableScope, which is cleared with the rest of the session.
+     */
+    class SymbolTable final {
+    public:
+        SymbolTable();
+
+        SymbolTable(const SymbolTable &) = delete;
+
+        SymbolTable &operator=(const SymbolTable &) = delete;
+
+        /// @brief Intern <code>text</code>, returning its id.
+        SymbolId intern(std::string_view text);
+
+        /**
+         * @brief Intern <code>prefix + text</code> without a temporary string.
+         *
+         * Used for mangled names such as <code>"V" + identifier</code>.
+         */
+        SymbolId intern_prefixed(char prefix, std::string_view text);
+
+        /// @brief Text of an interned symbol; valid until clear().
+        [[nodiscard]] std::string_view view(SymbolId id) const;
+
+        /// @brief Number of distinct symbols.
+        [[nodiscard]] std::size_t size() const;
+
+        /**
+         * @brief Forget every symbol but the known ones, keeping the capacity.
+         *
+         * Every other id is invalidated; no thread may use the table meanwhile.
+         */
+        void clear();
+
+        /// @brief Return the capacity not needed by the current symbols.
+        void shrink_to_fit();
+
+        /// @brief Approximate bytes reserved by the table.
+        [[nodiscard]] std::size_t capacity_bytes() const;
+
+    private:
+        struct Hash {
+            std::size_t operator()(std::string_view s) const noexcept {
+                return static_cast<std::size_t>(jh::meta::fnv1a64(s.data(), s.size()));
+            }
+        };
+
+        SymbolId insert_locked(std::string_view text);
+
+        // chunk c holds first_chunk << c views; 33 - first_bits chunks cover every 32-bit id
+        static constexpr unsigned first_bits = 6;
+        static constexpr std::size_t first_chunk = std::size_t{1} << first_bits;
+        static constexpr unsigned chunk_count = 33 - first_bits;
+
+        struct Slot {
+            unsigned chunk;
+            std::size_t index;
+        };
+
+        /// @brief Chunk of <code>id</code> and its index in it.
+        static Slot slot(SymbolId id) noexcept {
+            const auto n = std::uint64_t{id} + first_chunk;
+            const auto chunk = static_cast<unsigned>(std::bit_width(n)) - 1 - first_bits;
+            return {chunk, static_cast<std::size_t>(n - (std::uint64_t{first_chunk} << chunk))};
+        }
+
+        mutable std::shared_mutex mtx_;
+        std::deque<std::string> storage_;
+        std::array<std::unique_ptr<std::string_view[]>, chunk_count> by_id_;
+        std::size_t count_ = 0;
+        std::unordered_map<std::string_view, SymbolId, Hash> index_;
+    };
+
+    /**
+     * @brief The symbol table in use on the calling thread: that of the
+     *        innermost TableScope, or else the process-wide table.
+     */
+    SymbolTable &table();
+
+    /**
+     * @brief Makes table() return <code>table</code> on the calling thread
+     *        for the lifetime of the scope.
+     *
+     * This is how a compilation interns into the table of its
+     * session::CompilationSession instead of the process-wide one. Scopes
+     * nest; each restores the table in use before it.
+     */
+    class TableScope final {
+    public:
+        explicit TableScope(SymbolTable &table) noexcept;
+
+        ~TableScope();
+
+        TableScope(const TableScope &) = delete;
+
+        TableScope &operator=(const TableScope &) = delete;
+
+    private:
+        SymbolTable *previous_;
+    };
+
+    /// @brief Shorthand for <code>table().intern(text)</code>.
+    inline SymbolId intern(std::string_view text) { return table().intern(text); }
+
+    /// @brief Shorthand for <code>table().view(id)</code>.
+    inline std::string_view view(SymbolId id) { return table().view(id); }
+
+} // namespace pseu::sym
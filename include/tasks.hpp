@@ -0,0 +1,53 @@
+/**
+ * @file tasks.hpp
+ * @author JeongHan-Bae &lt;mastropseudo&#64;gmail.com&gt;
+ * @brief Work-stealing execution of independent tasks.
+ *
+ * @license MIT
+ *
+ * @verbatim
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ * @endverbatim
+ */
+
+
+
+#pragma once
+
+#include <cstddef>
+#include <functional>
+
+namespace pseu::tasks {
+
+    /**
+     * @brief Call <code>fn(index, worker)</code> for every index in
+     *        <code>[0, count)</code> on <code>workers</code> threads.
+     *
+     * Indices are dealt out in contiguous blocks, one deque per worker. A
+     * worker takes from the front of its own deque and, once it is empty,
+     * steals from the back of the others, so uneven tasks still keep every
+     * thread busy. The calling thread is worker 0; <code>worker</code> is
+     * below <code>workers</code> and may index per-thread state.
+     *
+     * Tasks do not spawn tasks, so a worker exits after it finds every
+     * deque empty. <code>fn</code> must not throw.
+     */
+    void run(std::size_t count, unsigned workers, const std::function<void(std::size_t, unsigned)> &fn);
+
+} // namespace pseu::tasks
@@ -28,9 +28,12 @@
 
 #pragma once
 
+#include <cstdint>
 #include <string>
+#include <string_view>
 #include <vector>
 #include <stdexcept>
+#include "symbols.hpp"
 
 namespace pseu::lexer {
 
@@ -67,13 +70,19 @@ namespace pseu::lexer {
     /**
      * @brief Lexical token structure.
      *
-     * Token is a simple value type carrying the token kind,
-     * its textual representation, and source line information.
+     * Token is a trivially copyable value type carrying the token kind,
+     * its interned text, and source line information. Integer literals
+     * are converted to their value once, at lex time, instead: their
+     * text is not interned.
      */
     struct Token final {
         TokenType type{TokenType::End};
-        std::string value;
+        sym::SymbolId value{sym::known::empty}; // known::empty for IntLit
+        std::int64_t number{0};                 // IntLit only
         int line{0};
+
+        /// @brief Textual representation of the token.
+        [[nodiscard]] std::string_view text() const { return sym::view(value); }
     };
 
 } // namespace pseu::lexer
@@ -0,0 +1,99 @@
+/**
+ * @file watch.hpp
+ * @author JeongHan-Bae &lt;mastropseudo&#64;gmail.com&gt;
+ * @brief File change notification for watch mode (<code>--watch</code>).
+ *
+ * @license MIT
+ *
+ * @verbatim
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ * @endverbatim
+ */
+
+
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <string>
+#include <vector>
+
+namespace pseu::watch {
+
+    /// @brief Why Watcher::wait returned.
+    struct Wake final {
+        std::vector<std::size_t> changed; ///< indices of the watched files that were written, in order
+        bool input = false;               ///< the input descriptor became readable
+    };
+
+    /**
+     * @brief Waits for writes to a set of files (inotify, Linux).
+     *
+     * The directory of each file is watched rather than the file itself,
+     * so that editors which save by writing a new file and renaming it
+     * over the old one are seen, and the watch survives the rename. A
+     * file counts as written when a writer closes it or a file is moved
+     * to its name.
+     */
+    class Watcher final {
+    public:
+        /**
+         * @param paths Absolute paths of the files to watch; they need not
+         *              exist yet, their directories must.
+         *
+         * @throws std::runtime_error if inotify is unavailable or a
+         *         directory cannot be watched.
+         */
+        explicit Watcher(std::vector<std::string> paths);
+
+        ~Watcher();
+
+        Watcher(const Watcher &) = delete;
+
+        Watcher &operator=(const Watcher &) = delete;
+
+        /**
+         * @brief Block until a watched file is written or the input
+         *        descriptor is readable.
+         *
+         * After the first write, further events are collected until none
+         * arrives for <code>debounce</code>, so that a burst of saves
+         * (or one save in several steps) gives a single wake.
+         *
+         * @param debounce Quiet period that ends a burst.
+         * @param input_fd Descriptor also waited on (stdin), or -1.
+         *
+         * @throws std::runtime_error if reading the notifications fails.
+         */
+        Wake wait(std::chrono::milliseconds debounce, int input_fd = -1);
+
+    private:
+        struct Entry final {
+            int wd;           // watch descriptor of the directory
+            std::string name; // file name within it
+        };
+
+        /// @brief Read the pending notifications and mark the written files.
+        void drain(std::vector<bool> &written);
+
+        int fd_ = -1;
+        std::vector<Entry> entries_; // one per watched path, same order
+    };
+
+} // namespace pseu::watch
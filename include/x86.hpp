@@ -0,0 +1,351 @@
+/**
+ * @file x86.hpp
+ * @author JeongHan-Bae &lt;mastropseudo&#64;gmail.com&gt;
+ * @brief In-process x86-64 encoder and its NASM text counterpart.
+ *
+ * @license MIT
+ *
+ * @verbatim
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ * @endverbatim
+ */
+
+
+
+#pragma once
+
+#include <cstdint>
+#include <initializer_list>
+#include <optional>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace pseu::x86 {
+
+    /// @brief Output section of a symbol or of assembled bytes.
+    enum class Section : std::uint8_t {
+        text, data, bss,
+        none ///< Undefined, or an <code>equ</code> constant.
+    };
+
+    /// @brief Relocation types used by the encoder (ELF <code>R_X86_64_*</code> semantics).
+    enum class RelocKind : std::uint8_t {
+        pc32,   ///< <code>S + A - P</code>, 32-bit: RIP-relative operands and branches.
+        abs32s, ///< <code>S + A</code>, sign-extended 32-bit: addresses in immediates and SIB displacements.
+        abs64   ///< <code>S + A</code>, 64-bit.
+    };
+
+    /**
+     * @brief Label defined by the assembled program.
+     *
+     * Local labels (<code>.loop</code>) are qualified by the preceding
+     * global label, as in NASM: <code>print_num.loop</code>.
+     */
+    struct Symbol final {
+        std::string name;
+        Section section = Section::none;
+        std::uint64_t offset = 0; // within section
+        bool global = false;
+    };
+
+    /// @brief Unresolved reference into <code>.text</code>.
+    struct Relocation final {
+        std::uint64_t offset; // of the field in .text
+        std::uint32_t symbol; // index into Module::symbols
+        RelocKind kind;
+        std::int64_t addend;
+    };
+
+    /**
+     * @brief Machine code and data of one assembled program, before linking.
+     *
+     * All branches use 32-bit displacements and every instruction size is
+     * fixed when it is encoded, so one pass over the source is enough.
+     * Branches within <code>.text</code> are patched at the end; other
+     * label references stay relocations, resolved by whoever places the
+     * sections (relocate()) or written to <code>.rela.text</code>.
+     */
+    struct Module final {
+        std::vector<std::uint8_t> text;
+        std::vector<std::uint8_t> data;
+        std::uint64_t bss_size = 0;
+        std::vector<Symbol> symbols;
+        std::vector<Relocation> relocations;
+
+        /// @brief Index of a symbol by name, or <code>-1</code>.
+        [[nodiscard]] std::int64_t find(std::string_view name) const noexcept;
+    };
+
+    /// @brief General-purpose register, numbered as in ModRM and REX.
+    enum class Gpr : std::uint8_t {
+        rax, rcx, rdx, rbx, rsp, rbp, rsi, rdi, r8, r9, r10, r11, r12, r13, r14, r15,
+        none = 0xFF
+    };
+
+    /// @brief Condition code of <code>jcc</code>, <code>setcc</code> and <code>cmovcc</code>.
+    enum class Cond : std::uint8_t {
+        o, no, b, ae, e, ne, be, a, s, ns, p, np, l, ge, le, g
+    };
+
+    /**
+     * @brief Instructions the encoder supports.
+     *
+     * The eight ALU operations come first, in the order of their
+     * <code>/digit</code>. <code>jcc</code>, <code>setcc</code> and
+     * <code>cmovcc</code> take their condition separately.
+     */
+    enum class Op : std::uint8_t {
+        add, or_, adc, sbb, and_, sub, xor_, cmp,
+        not_, neg, mul, div, idiv, inc, dec,
+        rol, ror, shl, shr, sar,
+        mov, movzx, movsx, lea, test, xchg, imul,
+        push, pop, jmp, call, jcc, setcc, cmovcc,
+        ret, syscall, cqo, cdq, nop, movsb, rep_movsb, rep_stosb
+    };
+
+    /// @brief Constant plus at most one symbol.
+    struct Expr final {
+        std::int64_t value = 0;
+        std::int64_t symbol = -1; // index into Module::symbols, -1 if absolute
+    };
+
+    /**
+     * @brief Register, immediate or <code>[base + index*scale + disp]</code> operand.
+     *
+     * A memory operand whose only component is a symbol is encoded
+     * RIP-relative.
+     */
+    struct Operand final {
+        enum class Kind : std::uint8_t { reg, mem, imm } kind = Kind::imm;
+        std::uint8_t size = 0; // bytes; 0 if not given
+        Gpr reg = Gpr::none;
+        bool needs_rex = false; // spl, bpl, sil, dil
+
+        // memory: [base + index*scale + disp]
+        Gpr base = Gpr::none;
+        Gpr index = Gpr::none;
+        std::uint8_t scale = 1;
+
+        Expr expr; // displacement or immediate
+    };
+
+    /// @brief Register operand of <code>size</code> bytes.
+    [[nodiscard]] constexpr Operand reg(Gpr r, std::uint8_t size = 8) noexcept {
+        Operand o;
+        o.kind = Operand::Kind::reg;
+        o.size = size;
+        o.reg = r;
+        o.needs_rex = size == 1 && r >= Gpr::rsp && r <= Gpr::rdi;
+        return o;
+    }
+
+    /// @brief <code>[base + index*scale + disp]</code>.
+    [[nodiscard]] constexpr Operand mem(std::uint8_t size, Gpr base, std::int64_t disp = 0,
+                                        Gpr index = Gpr::none, std::uint8_t scale = 1) noexcept {
+        Operand o;
+        o.kind = Operand::Kind::mem;
+        o.size = size;
+        o.base = base;
+        o.index = index;
+        o.scale = scale;
+        o.expr.value = disp;
+        return o;
+    }
+
+    /// @brief <code>[symbol + index*scale + disp]</code>; RIP-relative without an index.
+    [[nodiscard]] constexpr Operand mem(std::uint8_t size, std::uint32_t symbol, std::int64_t disp = 0,
+                                        Gpr index = Gpr::none, std::uint8_t scale = 1) noexcept {
+        auto o = mem(size, Gpr::none, disp, index, scale);
+        o.expr.symbol = symbol;
+        return o;
+    }
+
+    /// @brief Immediate.
+    [[nodiscard]] constexpr Operand imm(std::int64_t value) noexcept {
+        return Operand{Operand::Kind::imm, 0, Gpr::none, false, Gpr::none, Gpr::none, 1, Expr{value}};
+    }
+
+    /// @brief Address of a symbol as an immediate or a branch target.
+    [[nodiscard]] constexpr Operand address(std::uint32_t symbol) noexcept {
+        return Operand{Operand::Kind::imm, 0, Gpr::none, false, Gpr::none, Gpr::none, 1, Expr{0, symbol}};
+    }
+
+    /// @brief Value of a symbol defined with <code>constant()</code>, as an immediate.
+    [[nodiscard]] constexpr Operand value(std::uint32_t symbol) noexcept {
+        return address(symbol);
+    }
+
+    /**
+     * @brief Emitter producing machine code and data directly.
+     *
+     * Encoder and NasmWriter share one interface, so a lowering written
+     * as a template over its emitter yields the same program as bytes or
+     * as NASM text: symbols are created up front and referred to by
+     * index, <code>section()</code> selects where labels,
+     * <code>data()</code>, <code>reserve()</code> and instructions go.
+     */
+    class Encoder final {
+    public:
+        /// @brief Create an undefined symbol.
+        std::uint32_t symbol(std::string_view name);
+
+        /// @brief Select the section that follows.
+        void section(Section s) noexcept { section_ = s; }
+
+        /**
+         * @brief Define a symbol at the current position.
+         *
+         * @throws std::runtime_error if it is already defined.
+         */
+        void label(std::uint32_t symbol);
+
+        /// @brief Export a symbol.
+        void global(std::uint32_t symbol) noexcept { m_.symbols[symbol].global = true; }
+
+        /**
+         * @brief Define a symbol as a constant, as <code>equ</code>.
+         *
+         * Operands naming it take its value, so it must be defined before
+         * the first instruction that does; it is not a symbol of the module.
+         *
+         * @throws std::runtime_error if it is already defined.
+         */
+        void constant(std::uint32_t symbol, std::int64_t value);
+
+        /// @brief Append bytes to <code>.data</code>.
+        void data(std::span<const std::uint8_t> bytes);
+
+        /// @brief Reserve bytes in <code>.bss</code>.
+        void reserve(std::uint64_t bytes);
+
+        /**
+         * @brief Encode one instruction into <code>.text</code>.
+         *
+         * @param cc Condition of <code>jcc</code>, <code>setcc</code> and
+         *           <code>cmovcc</code>; ignored otherwise.
+         *
+         * @throws std::runtime_error for an operand combination the
+         *         instruction does not have.
+         */
+        void instruction(Op op, std::span<const Operand> ops, Cond cc = Cond::o);
+
+        void instruction(Op op, std::initializer_list<Operand> ops, Cond cc = Cond::o) {
+            instruction(op, std::span{ops.begin(), ops.size()}, cc);
+        }
+
+        /// @brief Offset of the next byte in the current section.
+        [[nodiscard]] std::uint64_t here() const noexcept;
+
+        /**
+         * @brief Patch branches within <code>.text</code> and take the module.
+         *
+         * @throws std::runtime_error naming an undefined symbol.
+         */
+        [[nodiscard]] Module finish();
+
+    private:
+        void byte(std::uint8_t b) { m_.text.push_back(b); }
+        void bytes(std::uint64_t v, int n);
+        void field(const Expr &e, int n, RelocKind kind, std::int64_t addend_bias = 0);
+        void encode(std::initializer_list<std::uint8_t> opcode, std::uint8_t size, std::uint8_t reg,
+                    const Operand &rm, int imm_bytes = 0, bool force_rex = false);
+        void immediate(const Expr &e, int n, bool widened = false);
+        void branch(std::initializer_list<std::uint8_t> opcode, const Operand &target);
+        [[nodiscard]] std::uint8_t operand_size(Op op, const Operand &a, const Operand &b) const;
+        void expect(Op op, std::span<const Operand> ops, std::size_t n) const;
+        [[nodiscard]] bool is_constant(const Expr &e) const noexcept;
+
+        Module m_;
+        std::vector<std::optional<std::int64_t>> constants_; // by symbol
+        Section section_ = Section::text;
+    };
+
+    /**
+     * @brief Emitter writing NASM source, with the interface of Encoder.
+     *
+     * Labels local to the last global label are written in the short
+     * <code>.name</code> form.
+     */
+    class NasmWriter final {
+    public:
+        /// @param out Text buffer appended to.
+        explicit NasmWriter(std::vector<char> &out) noexcept : out_(out) {}
+
+        std::uint32_t symbol(std::string_view name);
+
+        void section(Section s);
+
+        void label(std::uint32_t symbol);
+
+        void global(std::uint32_t symbol);
+
+        void constant(std::uint32_t symbol, std::int64_t value);
+
+        void data(std::span<const std::uint8_t> bytes);
+
+        void reserve(std::uint64_t bytes);
+
+        void instruction(Op op, std::span<const Operand> ops, Cond cc = Cond::o);
+
+        void instruction(Op op, std::initializer_list<Operand> ops, Cond cc = Cond::o) {
+            instruction(op, std::span{ops.begin(), ops.size()}, cc);
+        }
+
+    private:
+        void put(std::string_view s) { out_.insert(out_.end(), s.begin(), s.end()); }
+        void number(std::int64_t v);
+        void name(std::uint32_t symbol);
+        void operand(const Operand &o, bool sized);
+        void pending_label();
+        void flush_label();
+
+        std::vector<char> &out_;
+        std::string names_;                  // symbol names, back to back
+        std::vector<std::uint32_t> offsets_; // start of each name; one more than there are symbols
+        std::uint32_t scope_ = no_scope;     // last global label
+        std::int64_t pending_ = -1;          // .data/.bss label written with its directive
+        Section section_ = Section::none;
+
+        static constexpr std::uint32_t no_scope = 0xFFFFFFFF;
+    };
+
+    /// @brief Load addresses of a module's sections.
+    struct Layout final {
+        std::uint64_t text = 0;
+        std::uint64_t data = 0;
+        std::uint64_t bss = 0;
+
+        /// @brief Address of a defined symbol.
+        [[nodiscard]] std::uint64_t address(const Symbol &s) const noexcept;
+    };
+
+    /**
+     * @brief Resolve the relocations of a module placed at the given addresses.
+     *
+     * @param m      Assembled module.
+     * @param layout Where each section is loaded.
+     * @param text   Copy of <code>m.text</code> to patch, loaded at <code>layout.text</code>.
+     *
+     * @throws std::runtime_error if a value does not fit its 32-bit field.
+     */
+    void relocate(const Module &m, const Layout &layout, std::span<std::uint8_t> text);
+
+} // namespace pseu::x86
@@ -0,0 +1,155 @@
+#include "cache.hpp"
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <vector>
+#include <jh/meta>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <unistd.h>
+#endif
+
+namespace pseu {
+
+    namespace fs = std::filesystem;
+
+    namespace {
+        std::uint64_t mix(std::uint64_t h, std::uint64_t v) noexcept {
+            return (h ^ v) * 1099511628211ull;
+        }
+
+        /// @brief Unique suffix for temporary entries, across processes and threads.
+        std::string temp_suffix() {
+            static std::atomic<std::uint64_t> next{0};
+#if defined(__unix__) || defined(__APPLE__)
+            const auto pid = static_cast<std::uint64_t>(::getpid());
+#else
+            const std::uint64_t pid = 0;
+#endif
+            return ".tmp." + std::to_string(pid) + "." + std::to_string(next++);
+        }
+
+        struct Entry {
+            fs::path path;
+            fs::file_time_type used;
+            std::uint64_t size;
+        };
+
+        /// @brief Entries in <code>dir</code>, skipping temporaries of concurrent stores.
+        std::vector<Entry> scan(const fs::path &dir) {
+            std::vector<Entry> entries;
+            std::error_code ec;
+            for (const auto &e: fs::directory_iterator(dir, ec)) {
+                // temporaries of concurrent stores are not entries yet
+                if (!e.is_regular_file(ec) || e.path().filename().string().size() != 16)
+                    continue;
+                const auto size = e.file_size(ec);
+                const auto used = e.last_write_time(ec);
+                if (ec)
+                    continue;
+                entries.push_back({e.path(), used, size});
+            }
+            return entries;
+        }
+    }
+
+    cache::Cache::Cache(fs::path dir, std::uint64_t max_bytes)
+            : dir_(std::move(dir)), max_bytes_(max_bytes) {
+        fs::create_directories(dir_);
+        for (const auto &e: scan(dir_))
+            total_ += e.size;
+    }
+
+    std::uint64_t cache::Cache::key(std::string_view source, std::string_view flags) noexcept {
+        constexpr std::string_view version = PSEU_VERSION;
+        auto h = jh::meta::fnv1a64(source.data(), source.size());
+        h = mix(h, jh::meta::fnv1a64(version.data(), version.size()));
+        return mix(h, jh::meta::fnv1a64(flags.data(), flags.size()));
+    }
+
+    fs::path cache::Cache::entry(std::uint64_t key) const {
+        static constexpr char hex[] = "0123456789abcdef";
+        std::array<char, 16> name{};
+        for (int i = 15; i >= 0; --i, key >>= 4)
+            name[i] = hex[key & 0xF];
+        return dir_ / std::string_view(name.data(), name.size());
+    }
+
+    bool cache::Cache::fetch(std::uint64_t key, const fs::path &target) {
+        const auto path = entry(key);
+        std::error_code ec;
+        if (!fs::copy_file(path, target, fs::copy_options::overwrite_existing, ec)) {
+            const std::lock_guard lock(mutex_);
+            ++stats_.misses;
+            return false;
+        }
+        // most recently used
+        fs::last_write_time(path, fs::file_time_type::clock::now(), ec);
+        const std::lock_guard lock(mutex_);
+        ++stats_.hits;
+        return true;
+    }
+
+    cache::Stats cache::Cache::stats() const {
+        const std::lock_guard lock(mutex_);
+        return stats_;
+    }
+
+    void cache::Cache::store(std::uint64_t key, const fs::path &output) noexcept {
+        try {
+            const auto path = entry(key);
+            auto temp = path;
+            temp += temp_suffix();
+
+            std::error_code ec;
+            const auto size = fs::file_size(output, ec);
+            if (ec)
+                return;
+            // an entry for the same key is replaced, not added to
+            std::error_code missing;
+            auto replaced = fs::file_size(path, missing);
+            if (missing)
+                replaced = 0;
+            if (!fs::copy_file(output, temp, fs::copy_options::overwrite_existing, ec)) {
+                fs::remove(temp, ec);
+                return;
+            }
+            fs::rename(temp, path, ec);
+            if (ec) {
+                fs::remove(temp, ec);
+                return;
+            }
+            const std::lock_guard lock(mutex_);
+            total_ = total_ - std::min(total_, replaced) + size;
+            if (total_ > max_bytes_)
+                evict();
+        } catch (...) {
+            // allocation failure while building paths: skip caching
+        }
+    }
+
+    void cache::Cache::evict() {
+        auto entries = scan(dir_);
+        total_ = 0;
+        for (const auto &e: entries)
+            total_ += e.size;
+        if (total_ <= max_bytes_)
+            return;
+
+        // leave room for the next stores, so that a full cache is not
+        // rescanned on every one of them
+        const auto low_water = max_bytes_ - max_bytes_ / 10;
+        std::sort(entries.begin(), entries.end(),
+                  [](const Entry &a, const Entry &b) { return a.used < b.used; });
+        std::error_code ec;
+        for (const auto &e: entries) {
+            if (total_ <= low_water)
+                break;
+            if (fs::remove(e.path, ec)) {
+                total_ -= e.size;
+                ++stats_.evictions;
+            }
+        }
+    }
+
+} // namespace pseu
@@ -0,0 +1,248 @@
+#include "cfg.hpp"
+#include <algorithm>
+#include <stdexcept>
+#include <string>
+
+namespace pseu {
+
+    /// @brief Label targeted by a block's last instruction, or 0 if it does not jump.
+    static ir::LabelId jump_target(const cfg::BasicBlock &b, bool &conditional) {
+        conditional = false;
+        if (b.code.empty())
+            return 0;
+        auto last = b.code.back();
+        [[maybe_unused]] auto g = last.guard();
+        if (auto *j = std::get_if<ir::JumpCode>(&*last))
+            return j->dist;
+        if (auto *c = std::get_if<ir::CompareCodeIR>(&*last)) {
+            conditional = true;
+            return c->jump;
+        }
+        return 0;
+    }
+
+    cfg::CFG::CFG(const ir::InterCodeArray &code) {
+        split(code);
+        link();
+        compute_dominators();
+        find_loops();
+    }
+
+    void cfg::CFG::split(const ir::InterCodeArray &code) {
+        bool open = false;
+        for (const auto &ins: code.code) {
+            [[maybe_unused]] auto g = ins.guard();
+            const auto *label = std::get_if<ir::LabelCode>(&*ins);
+
+            // a label starts a new block, unless the current one is still empty
+            if (!open || (label && !blocks_.back().code.empty())) {
+                blocks_.emplace_back();
+                open = true;
+            }
+
+            auto &b = blocks_.back();
+            if (label && b.code.empty()) {
+                b.label = label->label;
+                if (label_block_.size() <= label->label)
+                    label_block_.resize(label->label + 1, no_block);
+                label_block_[label->label] = static_cast<BlockId>(blocks_.size() - 1);
+            }
+            b.code.push_back(ins);
+
+            // a jump ends the block
+            if (std::holds_alternative<ir::JumpCode>(*ins) || std::holds_alternative<ir::CompareCodeIR>(*ins))
+                open = false;
+        }
+
+        // an empty program still has an entry block
+        if (blocks_.empty())
+            blocks_.emplace_back();
+    }
+
+    void cfg::CFG::link() {
+        const auto n = static_cast<BlockId>(blocks_.size());
+        for (BlockId b = 0; b < n; ++b) {
+            auto &blk = blocks_[b];
+            bool conditional = false;
+            const auto target = jump_target(blk, conditional);
+
+            if (target) {
+                const auto t = block_of(target);
+                if (t == no_block)
+                    throw std::runtime_error("Jump to undefined label L" + std::to_string(target));
+                blk.succs.push_back(t);
+            }
+            if ((!target || conditional) && b + 1 < n)
+                blk.fallthrough = b + 1;
+            if (blk.fallthrough != no_block && std::find(blk.succs.begin(), blk.succs.end(), blk.fallthrough) == blk.succs.end())
+                blk.succs.push_back(blk.fallthrough);
+
+            for (auto s: blk.succs)
+                blocks_[s].preds.push_back(b);
+        }
+    }
+
+    void cfg::CFG::compute_dominators() {
+        // iterative depth-first search for the postorder
+        std::vector<BlockId> post;
+        std::vector<std::pair<BlockId, std::size_t>> stack{{0, 0}};
+        blocks_[0].reachable = true;
+        while (!stack.empty()) {
+            auto &[b, next] = stack.back();
+            if (next < blocks_[b].succs.size()) {
+                const auto s = blocks_[b].succs[next++];
+                if (!blocks_[s].reachable) {
+                    blocks_[s].reachable = true;
+                    stack.emplace_back(s, 0);
+                }
+            } else {
+                post.push_back(b);
+                stack.pop_back();
+            }
+        }
+        rpo_.assign(post.rbegin(), post.rend());
+
+        std::vector<std::uint32_t> order(blocks_.size(), 0);
+        for (std::uint32_t i = 0; i < rpo_.size(); ++i)
+            order[rpo_[i]] = i;
+
+        // Cooper, Harvey & Kennedy, "A Simple, Fast Dominance Algorithm"
+        std::vector<BlockId> idom(blocks_.size(), no_block);
+        idom[0] = 0;
+        const auto intersect = [&](BlockId a, BlockId b) {
+            while (a != b) {
+                while (order[a] > order[b])
+                    a = idom[a];
+                while (order[b] > order[a])
+                    b = idom[b];
+            }
+            return a;
+        };
+
+        for (bool changed = true; changed;) {
+            changed = false;
+            for (std::size_t i = 1; i < rpo_.size(); ++i) {
+                const auto b = rpo_[i];
+                BlockId new_idom = no_block;
+                for (auto p: blocks_[b].preds) {
+                    if (idom[p] == no_block)
+                        continue;
+                    new_idom = new_idom == no_block ? p : intersect(p, new_idom);
+                }
+                if (idom[b] != new_idom) {
+                    idom[b] = new_idom;
+                    changed = true;
+                }
+            }
+        }
+
+        for (BlockId b = 1; b < blocks_.size(); ++b)
+            blocks_[b].idom = idom[b];
+    }
+
+    void cfg::CFG::find_loops() {
+        // one natural loop per header, merging all of its back edges
+        std::vector<std::uint32_t> loop_of_header(blocks_.size(), no_loop);
+        for (auto t: rpo_) {
+            for (auto h: blocks_[t].succs) {
+                if (!dominates(h, t))
+                    continue;
+
+                if (loop_of_header[h] == no_loop) {
+                    loop_of_header[h] = static_cast<std::uint32_t>(loops_.size());
+                    loops_.push_back(Loop{h, {h}});
+                }
+                auto &body = loops_[loop_of_header[h]].blocks;
+
+                // walk predecessors backwards from the latch until the header
+                std::vector<BlockId> work;
+                if (std::find(body.begin(), body.end(), t) == body.end()) {
+                    body.push_back(t);
+                    work.push_back(t);
+                }
+                while (!work.empty()) {
+                    const auto b = work.back();
+                    work.pop_back();
+                    for (auto p: blocks_[b].preds) {
+                        if (blocks_[p].reachable && std::find(body.begin(), body.end(), p) == body.end()) {
+                            body.push_back(p);
+                            work.push_back(p);
+                        }
+                    }
+                }
+            }
+        }
+
+        for (auto &l: loops_)
+            std::sort(l.blocks.begin(), l.blocks.end());
+
+        // outer loops first: an enclosing loop is strictly larger than its children
+        std::vector<std::uint32_t> by_size(loops_.size());
+        for (std::uint32_t i = 0; i < by_size.size(); ++i)
+            by_size[i] = i;
+        std::stable_sort(by_size.begin(), by_size.end(), [&](auto a, auto b) {
+            return loops_[a].blocks.size() > loops_[b].blocks.size();
+        });
+
+        for (auto li: by_size) {
+            auto &l = loops_[li];
+            // blocks visited so far belong to larger (enclosing) loops, innermost last
+            const auto enclosing = blocks_[l.header].loop;
+            if (enclosing != no_loop) {
+                l.parent = enclosing;
+                l.depth = loops_[enclosing].depth + 1;
+            }
+            for (auto b: l.blocks) {
+                blocks_[b].loop = li;
+                ++blocks_[b].loop_depth;
+            }
+        }
+    }
+
+    cfg::BlockId cfg::CFG::block_of(ir::LabelId label) const noexcept {
+        return label < label_block_.size() ? label_block_[label] : no_block;
+    }
+
+    bool cfg::CFG::dominates(BlockId a, BlockId b) const noexcept {
+        if (!blocks_[b].reachable)
+            return false;
+        for (; b != no_block; b = blocks_[b].idom)
+            if (b == a)
+                return true;
+        return false;
+    }
+
+    ir::InterCodeArray cfg::CFG::linearize() const {
+        std::vector<BlockId> order(blocks_.size());
+        for (BlockId b = 0; b < order.size(); ++b)
+            order[b] = b;
+        return linearize(order);
+    }
+
+    ir::InterCodeArray cfg::CFG::linearize(std::span<const BlockId> order) const {
+        // fresh labels for fallthrough targets that must now be jumped to
+        std::vector<ir::LabelId> labels(blocks_.size());
+        auto next_label = static_cast<ir::LabelId>(std::max<std::size_t>(label_block_.size(), 1));
+        for (std::size_t i = 0; i < order.size(); ++i) {
+            const auto ft = blocks_[order[i]].fallthrough;
+            if (ft != no_block && (i + 1 == order.size() || order[i + 1] != ft) && !blocks_[ft].label && !labels[ft])
+                labels[ft] = next_label++;
+        }
+
+        ir::InterCodeArray out;
+        for (std::size_t i = 0; i < order.size(); ++i) {
+            const auto &b = blocks_[order[i]];
+            if (labels[order[i]])
+                out.append(ir::intern(ir::LabelCode{labels[order[i]]}));
+            for (const auto &ins: b.code)
+                out.append(ins);
+
+            if (b.fallthrough != no_block && (i + 1 == order.size() || order[i + 1] != b.fallthrough)) {
+                const auto &ft = blocks_[b.fallthrough];
+                out.append(ir::intern(ir::JumpCode{ft.label ? ft.label : labels[b.fallthrough]}));
+            }
+        }
+        return out;
+    }
+
+} // namespace pseu
@@ -1,357 +1,657 @@
-#include "codegen.hpp"
-#include <algorithm>
-#include <array>
-#include <cctype>
-#include <cstdint>
-#include <fstream>
-#include <jh/meta>
-
-
-namespace pseu {
-    using namespace std::literals;
-    using namespace jh::pod::literals;
-
-    namespace detail {
-        constexpr auto op_table =
-                jh::meta::make_lookup_map(
-                        std::array{
-                                std::pair{"*"_psv, "imul"_psv},
-                                std::pair{"+"_psv, "add"_psv},
-                                std::pair{"-"_psv, "sub"_psv},
-                                std::pair{"/"_psv, "idiv"_psv},
-                        },
-                        ""_psv   // default value
-                );
-    }
-
-    static jh::pod::string_view op_to_asm(std::string_view op) {
-        return detail::op_table[op];
-    }
-
-    namespace detail {
-        constexpr auto cmp_table =
-                jh::meta::make_lookup_map(
-                        std::array{
-                                std::pair{"=="_psv, "je"_psv},
-                                std::pair{"!="_psv, "jne"_psv},
-                                std::pair{"<"_psv, "jl"_psv},
-                                std::pair{"<="_psv, "jle"_psv},
-                                std::pair{">"_psv, "jg"_psv},
-                                std::pair{">="_psv, "jge"_psv},
-                        },
-                        ""_psv
-                );
-    }
-
-    static jh::pod::string_view cmp_to_jmp(std::string_view c) {
-        return detail::cmp_table[c];
-    }
-
-    codegen::CodeGenerator::CodeGenerator(const ir::InterCodeArray &arr,
-                                          const std::unordered_map<std::string, std::string> &identifiers,
-                                          const std::unordered_map<std::string, std::string> &constants,
-                                          const std::unordered_map<std::string, std::string> &tempmap)
-            : arr(arr), ids(identifiers), consts(constants), tempmap(tempmap), need_print_num(false),
-              need_print_string(false) {}
-
-    void codegen::CodeGenerator::pr(std::string_view s) {
-        out.insert(out.end(), s.begin(), s.end());
-        out.emplace_back('\n');
-    }
-
-    void codegen::CodeGenerator::emit_sv(jh::pod::string_view sv) {
-        out.insert(out.end(), sv.begin(), sv.end());
-    }
-
-    std::string codegen::CodeGenerator::handleVar(
-            const std::string &a,
-            [[maybe_unused]] const std::unordered_map<std::string, std::string> &tempmap) {
-        // immediate number
-        if (std::isdigit(a[0]) || (a[0] == '-' && std::isdigit(a[1])))
-            return a;
-
-        // x86 / x86-64 memory operand
-        return "[" + a + "]";
-    }
-
-    void codegen::CodeGenerator::gen_variables() {
-        pr("section .bss");
-
-        if (need_print_num) {
-            const auto S = R"(	digitSpace resb 100
-	digitSpacePos resb 8
-
-)"s;
-            pr(S);
-        }
-
-        for (auto &kv: ids) {
-            pr("\t" + kv.first + " resb 8");
-        }
-    }
-
-    static inline void append_u8(std::vector<char> &buf, unsigned char v) {
-        if (v >= 100) {
-            buf.emplace_back(static_cast<char>(48 + v / 100));
-            v %= 100;
-            buf.emplace_back(static_cast<char>(48 + v / 10));
-            buf.emplace_back(static_cast<char>(48 + v % 10));
-        } else if (v >= 10) {
-            buf.emplace_back(static_cast<char>(48 + v / 10));
-            buf.emplace_back(static_cast<char>(48 + v % 10));
-        } else {
-            buf.emplace_back(static_cast<char>(48 + v));
-        }
-    }
-
-    static constexpr char DB_PREFIX[] = "\tdb ";
-    static constexpr char COMMA_SPACE[] = ", ";
-    static constexpr char NL_NUL[] = "10, 0";
-
-
-    void codegen::CodeGenerator::gen_start() {
-        pr("section .data");
-
-        std::vector<char> buf;
-        buf.reserve(128);
-
-        for (auto &kv: consts) {
-            buf.clear();
-
-            // "\t<label> db "
-            buf.emplace_back('\t');
-            buf.insert(buf.end(), kv.first.begin(), kv.first.end());
-            buf.emplace_back(' ');
-            buf.insert(buf.end(), std::begin(DB_PREFIX) + 1,
-                       std::end(DB_PREFIX) - 1); // skip '\t' duplication
-
-            // string bytes
-            for (unsigned char c: kv.second) {
-                append_u8(buf, c);
-                buf.insert(buf.end(),
-                           std::begin(COMMA_SPACE),
-                           std::end(COMMA_SPACE) - 1);
-            }
-
-            // newline + NUL
-            buf.insert(buf.end(),
-                       std::begin(NL_NUL),
-                       std::end(NL_NUL) - 1);
-
-            pr(std::string_view(buf.data(), buf.size()));
-        }
-
-        const auto S = R"(section .text
-	global _start
-
-_start:
-)"s;
-
-        pr(S);
-    }
-
-    void codegen::CodeGenerator::gen_end() {
-        const auto S = R"(	mov rax, 60      ; __NR_exit
-	mov rdi, 0       ; status
-	syscall
-
-)"s;
-
-        pr(S);
-    }
-
-    void codegen::CodeGenerator::gen_assignment(const ir::AssignmentCode &a) {
-        // x = y
-        if (a.op.empty()) {
-            if (consts.count(a.left)) {
-                // string literal: take address
-                pr("\tlea rax, [rel " + a.left + "]");
-            } else {
-                pr("\tmov rax, " + handleVar(a.left, tempmap));
-            }
-            pr("\tmov " + handleVar(a.var, tempmap) + ", rax");
-
-            return;
-        }
-
-        // x = l op r
-        pr("\tmov rax, " + handleVar(a.left, tempmap));
-
-        if (a.op == "/"sv) {
-            pr("\tcqo");
-            pr("\tmov rbx, " + handleVar(a.right, tempmap));
-            pr("\tidiv rbx");
-        } else {
-            pr("\tmov rbx, " + handleVar(a.right, tempmap));
-            emit_sv("\t"_psv);
-            emit_sv(op_to_asm(a.op));
-            pr(" rax, rbx\n");
-        }
-
-        pr("\tmov " + handleVar(a.var, tempmap) + ", rax");
-    }
-
-    void codegen::CodeGenerator::gen_jump(const ir::JumpCode &j) {
-        pr("\tjmp " + j.dist);
-    }
-
-    void codegen::CodeGenerator::gen_label(const ir::LabelCode &l) {
-        pr(l.label + ":");
-    }
-
-    void codegen::CodeGenerator::gen_compare(const ir::CompareCodeIR &c) {
-        pr("\tmov rax, " + handleVar(c.left, tempmap));
-        pr("\tcmp rax, " + handleVar(c.right, tempmap));
-        emit_sv("\t"_psv);
-        emit_sv(cmp_to_jmp(c.operation));
-        pr(" " + c.jump);
-    }
-
-    void codegen::CodeGenerator::gen_print(const ir::PrintCodeIR &p) {
-        if (p.type == ast::PrintType::Int) {
-            pr("\tmov rdi, " + handleVar(p.value, tempmap));
-            pr("\tcall print_num");
-        } else {
-            if (consts.count(p.value)) {
-                // string literal: pass address directly
-                pr("\tmov rdi, " + p.value);
-            } else {
-                // string variable: load pointer
-                pr("\tmov rdi, [" + p.value + "]");
-            }
-            pr("\tcall print_string");
-        }
-    }
-
-    void codegen::CodeGenerator::gen_code() {
-        for (auto ins: arr.code) {
-            [[maybe_unused]] auto g = ins.guard();
-            std::visit([&](auto &ir) {
-                using T = std::decay_t<decltype(ir)>;
-
-                if constexpr (std::is_same_v<T, ir::AssignmentCode>) {
-                    gen_assignment(ir);
-                } else if constexpr (std::is_same_v<T, ir::JumpCode>) {
-                    gen_jump(ir);
-                } else if constexpr (std::is_same_v<T, ir::LabelCode>) {
-                    gen_label(ir);
-                } else if constexpr (std::is_same_v<T, ir::CompareCodeIR>) {
-                    gen_compare(ir);
-                } else if constexpr (std::is_same_v<T, ir::PrintCodeIR>) {
-                    gen_print(ir);
-                }
-            }, *ins);
-        }
-    }
-
-
-    void codegen::CodeGenerator::writeAsm(const std::string &path) {
-        out.clear();
-
-        // MUST reset every time
-        need_print_num = false;
-        need_print_string = false;
-
-        // Pre-scan IR to determine which helpers are needed
-        for (auto ins: arr.code) {
-            [[maybe_unused]] auto g = ins.guard();
-            std::visit([&](auto &ir) {
-                using T = std::decay_t<decltype(ir)>;
-
-                if constexpr (std::is_same_v<T, ir::PrintCodeIR>) {
-                    if (ir.type == ast::PrintType::Str)
-                        need_print_string = true;
-                    else
-                        need_print_num = true;
-                }
-            }, *ins);
-        }
-
-        gen_variables();
-        gen_start();
-        gen_code();
-        gen_end();
-
-        if (need_print_num) // NOLINT
-            gen_print_num_function();
-        if (need_print_string) // NOLINT
-            gen_print_string_function();
-
-        std::ofstream f(path, std::ios::binary);
-        f.write(out.data(), static_cast<std::int64_t>(out.size()));
-        f.close();
-    }
-
-    void codegen::CodeGenerator::gen_print_num_function() {
-        const auto S = R"(
-print_num:
-    mov rcx, digitSpace       ; buffer start
-    mov rbx, 10
-    mov rax, rdi              ; number
-
-    ; handle negative
-    cmp rax, 0
-    jge .loop
-    neg rax
-    mov byte [rcx], '-'
-    inc rcx
-
-.loop:
-    xor rdx, rdx
-    div rbx                   ; rax = rax/10, rdx = rax%10
-    add dl, '0'
-    mov [rcx], dl
-    inc rcx
-    test rax, rax
-    jnz .loop
-
-    ; rcx now points one past last char
-    ; reverse-print
-    mov rsi, rcx              ; rsi = end
-    dec rsi                   ; last digit
-    mov rdx, 1                ; write 1 byte at a time
-
-.rev_loop:
-    mov rax, 1                ; write
-    mov rdi, 1                ; stdout
-    syscall
-    dec rsi
-    cmp rsi, digitSpace
-    jl .newline
-    jmp .rev_loop
-
-.newline:
-    mov byte [digitSpacePos], 10
-    mov rax, 1
-    mov rdi, 1
-    mov rsi, digitSpacePos
-    mov rdx, 1
-    syscall
-    ret)"s;
-
-        pr(S);
-    }
-
-    void codegen::CodeGenerator::gen_print_string_function() {
-        const auto S = R"(
-print_string:
-    ; rdi = char*
-    mov rsi, rdi
-    xor rdx, rdx
-
-.len_loop:
-    cmp byte [rsi + rdx], 0
-    je .write
-    inc rdx
-    jmp .len_loop
-
-.write:
-    mov rax, 1      ; sys_write
-    mov rdi, 1      ; stdout
-    syscall
-    ret)"s;
-
-        pr(S);
-    }
-
-} // namespace pseu
+#include "codegen.hpp"
+#include <algorithm>
+#include <array>
+#include <charconv>
+#include <cstdint>
+#include <limits>
+
+
+namespace pseu {
+    using namespace std::literals;
+
+    namespace detail {
+        /// @brief Instruction of each arithmetic opcode, indexed by <code>ir::BinOp</code>.
+        constexpr std::array<x86::Op, 5> op_table{
+                x86::Op::nop, x86::Op::add, x86::Op::sub, x86::Op::imul, x86::Op::idiv
+        };
+
+        /// @brief Condition of the jump of each comparison, indexed by <code>ir::CmpOp</code>.
+        constexpr std::array<x86::Cond, 6> cmp_table{
+                x86::Cond::e, x86::Cond::ne, x86::Cond::l, x86::Cond::le, x86::Cond::g, x86::Cond::ge
+        };
+
+        /// @brief Hardware register of each <code>regalloc::Reg</code>.
+        constexpr std::array<x86::Gpr, 14> reg_table{
+                x86::Gpr::rax, x86::Gpr::rcx, x86::Gpr::rdx, x86::Gpr::rbx, x86::Gpr::rsi, x86::Gpr::rdi,
+                x86::Gpr::r8, x86::Gpr::r9, x86::Gpr::r10, x86::Gpr::r11, x86::Gpr::r12, x86::Gpr::r13,
+                x86::Gpr::r14, x86::Gpr::r15
+        };
+
+        /// @brief Size of the runtime output buffer.
+        constexpr std::int64_t out_cap = 65536;
+
+        /// @brief "00" "01" ... "99": two ASCII digits per value below 100.
+        constexpr auto digit_pairs = [] {
+            std::array<std::uint8_t, 200> d{};
+            for (int i = 0; i < 100; ++i) {
+                d[2 * i] = static_cast<std::uint8_t>('0' + i / 10);
+                d[2 * i + 1] = static_cast<std::uint8_t>('0' + i % 10);
+            }
+            return d;
+        }();
+    }
+
+    namespace {
+        using x86::Op;
+        using x86::Cond;
+        using x86::Gpr;
+
+        constexpr auto rax = x86::reg(Gpr::rax);
+        constexpr auto rbx = x86::reg(Gpr::rbx);
+        constexpr auto rcx = x86::reg(Gpr::rcx);
+        constexpr auto rdx = x86::reg(Gpr::rdx);
+        constexpr auto rsi = x86::reg(Gpr::rsi);
+        constexpr auto rdi = x86::reg(Gpr::rdi);
+        constexpr auto r11 = x86::reg(Gpr::r11);
+        constexpr auto ecx = x86::reg(Gpr::rcx, 4);
+        constexpr auto edx = x86::reg(Gpr::rdx, 4);
+        constexpr auto dx = x86::reg(Gpr::rdx, 2);
+        constexpr auto al = x86::reg(Gpr::rax, 1);
+
+        x86::Operand reg(regalloc::Reg r) noexcept {
+            return x86::reg(detail::reg_table[static_cast<std::uint8_t>(r)]);
+        }
+
+        /// @brief Create a generated symbol such as <code>L3</code> or <code>S3_len</code>.
+        template<typename Emitter>
+        std::uint32_t named(Emitter &e, char prefix, std::uint64_t n, std::string_view suffix = {}) {
+            char buf[32];
+            buf[0] = prefix;
+            auto [end, ec] = std::to_chars(buf + 1, buf + 21, n);
+            end = std::copy(suffix.begin(), suffix.end(), end);
+            return e.symbol({buf, static_cast<std::size_t>(end - buf)});
+        }
+    }
+
+    codegen::CodeGenerator::CodeGenerator(const ir::GeneratedIR &ir, const regalloc::Allocation *alloc,
+                                          Runtime runtime)
+            : ir(ir), alloc(alloc), runtime(runtime), out(buffer), need_print_num(false), need_print_string(false) {}
+
+    codegen::CodeGenerator::CodeGenerator(session::CompilationSession &session, const regalloc::Allocation *alloc,
+                                          Runtime runtime)
+            : ir(session.ir()), alloc(alloc), runtime(runtime), out(session.text()), need_print_num(false),
+              need_print_string(false) {}
+
+    regalloc::Reg codegen::CodeGenerator::loc(const ir::Operand &o) const noexcept {
+        return alloc ? alloc->location(o) : regalloc::Reg::none;
+    }
+
+    bool codegen::CodeGenerator::is_string(const ir::Operand &o) const noexcept {
+        return o.kind == ir::OperandKind::Str
+               || (o.kind == ir::OperandKind::Var && ir.variables[o.index()].type != sym::known::kw_int);
+    }
+
+    x86::Operand codegen::CodeGenerator::length(const ir::Operand &o) const noexcept {
+        if (o.kind == ir::OperandKind::Str)
+            return x86::value(syms.lengths[o.index()]);
+        // second half of the pair
+        return x86::mem(8, syms.vars[o.index()], 8);
+    }
+
+    x86::Operand codegen::CodeGenerator::operand(const ir::Operand &o) const noexcept {
+        if (const auto r = loc(o); r != regalloc::Reg::none)
+            return reg(r);
+        switch (o.kind) {
+            case ir::OperandKind::Imm:
+                return x86::imm(o.value);
+            case ir::OperandKind::Str:
+                // string constant: its label is the address
+                return x86::address(syms.strings[o.index()]);
+            case ir::OperandKind::Var:
+                return x86::mem(8, syms.vars[o.index()]);
+            case ir::OperandKind::Temp:
+                return x86::mem(8, syms.temps[o.index()]);
+            case ir::OperandKind::None:
+                break;
+        }
+        return x86::imm(0);
+    }
+
+    template<typename Emitter>
+    void codegen::CodeGenerator::declare(Emitter &e) {
+        constexpr auto none = std::numeric_limits<std::uint32_t>::max();
+
+        // register-allocated values need no storage
+        syms.vars.assign(ir.variables.size(), none);
+        for (std::uint32_t i = 0; i < ir.variables.size(); ++i)
+            if (!alloc || alloc->vars[i] == regalloc::Reg::none)
+                syms.vars[i] = e.symbol(sym::view(ir.variables[i].name));
+        syms.temps.assign(ir.temps + 1, none);
+        for (std::uint32_t t = 1; t <= ir.temps; ++t)
+            if (!alloc || alloc->temps[t] == regalloc::Reg::none)
+                syms.temps[t] = named(e, 'T', t);
+        syms.strings.assign(ir.constants.size() + 1, none);
+        syms.lengths.assign(ir.constants.size() + 1, none);
+        for (std::uint32_t i = 1; i <= ir.constants.size(); ++i) {
+            syms.strings[i] = named(e, 'S', i);
+            syms.lengths[i] = named(e, 'S', i, "_len"sv);
+        }
+
+        syms.labels.clear();
+        const auto label = [&](ir::LabelId id) {
+            if (id >= syms.labels.size())
+                syms.labels.resize(id + 1, none);
+            if (syms.labels[id] == none)
+                syms.labels[id] = named(e, 'L', id);
+        };
+        for (auto ins: ir.code.code) {
+            [[maybe_unused]] auto g = ins.guard();
+            std::visit([&](auto &ir) {
+                using T = std::decay_t<decltype(ir)>;
+
+                if constexpr (std::is_same_v<T, ir::JumpCode>)
+                    label(ir.dist);
+                else if constexpr (std::is_same_v<T, ir::LabelCode>)
+                    label(ir.label);
+                else if constexpr (std::is_same_v<T, ir::CompareCodeIR>)
+                    label(ir.jump);
+            }, *ins);
+        }
+
+        if (need_print_num || need_print_string) {
+            syms.out_buf = e.symbol("outBuf"sv);
+            syms.out_pos = e.symbol("outPos"sv);
+            syms.flush_out = e.symbol("flush_out"sv);
+        }
+        if (need_print_num) {
+            syms.digit_pairs = e.symbol("digitPairs"sv);
+            syms.print_num = e.symbol("print_num"sv);
+        }
+        if (need_print_string)
+            syms.print_string = e.symbol("print_string"sv);
+    }
+
+    template<typename Emitter>
+    void codegen::CodeGenerator::gen_variables(Emitter &e) {
+        e.section(x86::Section::bss);
+
+        // one output buffer shared by every print helper, drained by
+        // flush_out when full and once at exit
+        if (need_print_num || need_print_string) {
+            e.label(syms.out_buf);
+            e.reserve(detail::out_cap);
+            e.label(syms.out_pos);
+            e.reserve(8);
+        }
+
+        // strings are (pointer, length) pairs
+        for (std::uint32_t i = 0; i < ir.variables.size(); ++i) {
+            if (alloc && alloc->vars[i] != regalloc::Reg::none)
+                continue;
+            e.label(syms.vars[i]);
+            e.reserve(is_string(ir::Operand::var(i)) ? 16 : 8);
+        }
+        for (std::uint32_t t = 1; t <= ir.temps; ++t) {
+            if (alloc && alloc->temps[t] != regalloc::Reg::none)
+                continue;
+            e.label(syms.temps[t]);
+            e.reserve(8);
+        }
+    }
+
+    template<typename Emitter>
+    void codegen::CodeGenerator::gen_start(Emitter &e) {
+        e.section(x86::Section::data);
+
+        for (std::uint32_t i = 0; i < ir.constants.size(); ++i) {
+            const auto text = sym::view(ir.constants[i]);
+
+            // newline; the length is known, so no NUL terminator
+            bytes.assign(text.begin(), text.end());
+            bytes.push_back(10);
+            e.label(syms.strings[i + 1]);
+            e.data(bytes);
+            e.constant(syms.lengths[i + 1], static_cast<std::int64_t>(bytes.size()));
+        }
+
+        if (need_print_num) {
+            e.label(syms.digit_pairs);
+            e.data(detail::digit_pairs);
+        }
+
+        e.section(x86::Section::text);
+        const auto start = e.symbol("_start"sv);
+        e.global(start);
+        e.label(start);
+
+        // called from C++: rbx, rbp and r12-r15 belong to the caller
+        if (runtime == Runtime::Hosted)
+            for (auto r: {Gpr::rbx, Gpr::rbp, Gpr::r12, Gpr::r13, Gpr::r14, Gpr::r15})
+                e.instruction(Op::push, {x86::reg(r)});
+
+        // registers standing in for zero-initialised .bss storage
+        if (alloc)
+            for (auto r: alloc->zeroed)
+                e.instruction(Op::xor_, {reg(r), reg(r)});
+    }
+
+    template<typename Emitter>
+    void codegen::CodeGenerator::gen_end(Emitter &e) {
+        if (need_print_num || need_print_string)
+            e.instruction(Op::call, {x86::address(syms.flush_out)});
+
+        if (runtime == Runtime::Hosted) {
+            for (auto r: {Gpr::r15, Gpr::r14, Gpr::r13, Gpr::r12, Gpr::rbp, Gpr::rbx})
+                e.instruction(Op::pop, {x86::reg(r)});
+            e.instruction(Op::ret, {});
+            return;
+        }
+
+        e.instruction(Op::mov, {rax, x86::imm(60)}); // __NR_exit
+        e.instruction(Op::mov, {rdi, x86::imm(0)});  // status
+        e.instruction(Op::syscall, {});
+    }
+
+    template<typename Emitter>
+    void codegen::CodeGenerator::gen_assignment(Emitter &e, const ir::AssignmentCode &a) {
+        if (a.op == ir::BinOp::None && is_string(a.var)) {
+            gen_string_assignment(e, a);
+            return;
+        }
+        if (alloc) {
+            gen_assignment_allocated(e, a);
+            return;
+        }
+
+        // x = y
+        if (a.op == ir::BinOp::None) {
+            if (a.left.kind == ir::OperandKind::Str) {
+                // string literal: take address
+                e.instruction(Op::lea, {rax, x86::mem(8, syms.strings[a.left.index()])});
+            } else {
+                e.instruction(Op::mov, {rax, operand(a.left)});
+            }
+            e.instruction(Op::mov, {operand(a.var), rax});
+            return;
+        }
+
+        // x = l op r
+        e.instruction(Op::mov, {rax, operand(a.left)});
+        if (a.op == ir::BinOp::Div) {
+            e.instruction(Op::cqo, {});
+            e.instruction(Op::mov, {rbx, operand(a.right)});
+            e.instruction(Op::idiv, {rbx});
+        } else {
+            e.instruction(Op::mov, {rbx, operand(a.right)});
+            e.instruction(detail::op_table[static_cast<std::uint8_t>(a.op)], {rax, rbx});
+        }
+        e.instruction(Op::mov, {operand(a.var), rax});
+    }
+
+    template<typename Emitter>
+    void codegen::CodeGenerator::gen_compare(Emitter &e, const ir::CompareCodeIR &c) {
+        if (alloc) {
+            gen_compare_allocated(e, c);
+            return;
+        }
+
+        e.instruction(Op::mov, {rax, operand(c.left)});
+        const bool wide = load_wide(e, c.right);
+        e.instruction(Op::cmp, {rax, wide ? rbx : operand(c.right)});
+        e.instruction(Op::jcc, {x86::address(syms.labels[c.jump])},
+                      detail::cmp_table[static_cast<std::uint8_t>(c.operation)]);
+    }
+
+    template<typename Emitter>
+    void codegen::CodeGenerator::gen_string_assignment(Emitter &e, const ir::AssignmentCode &a) {
+        // s = "..." : address and known length
+        if (a.left.kind == ir::OperandKind::Str) {
+            e.instruction(Op::lea, {rax, x86::mem(8, syms.strings[a.left.index()])});
+            e.instruction(Op::mov, {operand(a.var), rax});
+            e.instruction(Op::mov, {length(a.var), length(a.left)});
+            return;
+        }
+
+        // s = t : copy both halves of the pair
+        e.instruction(Op::mov, {rax, operand(a.left)});
+        e.instruction(Op::mov, {operand(a.var), rax});
+        if (is_string(a.left)) {
+            e.instruction(Op::mov, {rax, length(a.left)});
+            e.instruction(Op::mov, {length(a.var), rax});
+        } else {
+            // not a string: nothing printable
+            e.instruction(Op::mov, {length(a.var), x86::imm(0)});
+        }
+    }
+
+    template<typename Emitter>
+    void codegen::CodeGenerator::gen_print(Emitter &e, const ir::PrintCodeIR &p) {
+        // prints: pointer in rsi, length in rdx, no scan at run time
+        if (p.type == ast::PrintType::Str) {
+            e.instruction(Op::mov, {rsi, operand(p.value)});
+            e.instruction(Op::mov, {rdx, is_string(p.value) ? length(p.value) : x86::imm(0)});
+            e.instruction(Op::call, {x86::address(syms.print_string)});
+            return;
+        }
+
+        // print: value in rdi
+        if (loc(p.value) != regalloc::Reg::rdi)
+            e.instruction(Op::mov, {rdi, operand(p.value)});
+        e.instruction(Op::call, {x86::address(syms.print_num)});
+    }
+
+    template<typename Emitter>
+    bool codegen::CodeGenerator::load_wide(Emitter &e, const ir::Operand &o) {
+        if (o.kind != ir::OperandKind::Imm ||
+            (o.value >= std::numeric_limits<std::int32_t>::min() && o.value <= std::numeric_limits<std::int32_t>::max()))
+            return false;
+        e.instruction(Op::mov, {rbx, operand(o)});
+        return true;
+    }
+
+    template<typename Emitter>
+    void codegen::CodeGenerator::gen_assignment_allocated(Emitter &e, const ir::AssignmentCode &a) {
+        using regalloc::Reg;
+
+        const auto dst = loc(a.var);
+        const auto store_rax = [&] { e.instruction(Op::mov, {operand(a.var), rax}); };
+
+        // x = y
+        if (a.op == ir::BinOp::None) {
+            if (a.left.kind == ir::OperandKind::Str) {
+                // string literal: take address
+                e.instruction(Op::lea, {dst != Reg::none ? reg(dst) : rax, x86::mem(8, syms.strings[a.left.index()])});
+                if (dst == Reg::none)
+                    store_rax();
+            } else if (dst != Reg::none) {
+                if (loc(a.left) != dst)
+                    e.instruction(Op::mov, {reg(dst), operand(a.left)});
+            } else if (loc(a.left) != Reg::none) {
+                e.instruction(Op::mov, {operand(a.var), operand(a.left)});
+            } else {
+                e.instruction(Op::mov, {rax, operand(a.left)});
+                store_rax();
+            }
+            return;
+        }
+
+        // x = l / r: idiv divides rdx:rax, which the allocator keeps free here
+        if (a.op == ir::BinOp::Div) {
+            e.instruction(Op::mov, {rax, operand(a.left)});
+            e.instruction(Op::cqo, {});
+            if (loc(a.right) != Reg::none) {
+                e.instruction(Op::idiv, {operand(a.right)});
+            } else {
+                e.instruction(Op::mov, {rbx, operand(a.right)});
+                e.instruction(Op::idiv, {rbx});
+            }
+            store_rax();
+            return;
+        }
+
+        // x = l op r, computed in place when x has a register that r does not use
+        const auto acc = (dst != Reg::none && dst != loc(a.right)) ? dst : Reg::rax;
+        const bool wide = load_wide(e, a.right);
+        if (loc(a.left) != acc)
+            e.instruction(Op::mov, {reg(acc), operand(a.left)});
+        e.instruction(detail::op_table[static_cast<std::uint8_t>(a.op)], {reg(acc), wide ? rbx : operand(a.right)});
+        if (acc == Reg::rax)
+            store_rax();
+    }
+
+    template<typename Emitter>
+    void codegen::CodeGenerator::gen_compare_allocated(Emitter &e, const ir::CompareCodeIR &c) {
+        const auto left = loc(c.left);
+        if (left == regalloc::Reg::none)
+            e.instruction(Op::mov, {rax, operand(c.left)});
+        const bool wide = load_wide(e, c.right);
+        e.instruction(Op::cmp, {left != regalloc::Reg::none ? reg(left) : rax, wide ? rbx : operand(c.right)});
+        e.instruction(Op::jcc, {x86::address(syms.labels[c.jump])},
+                      detail::cmp_table[static_cast<std::uint8_t>(c.operation)]);
+    }
+
+    template<typename Emitter>
+    void codegen::CodeGenerator::gen_code(Emitter &e) {
+        for (auto ins: ir.code.code) {
+            [[maybe_unused]] auto g = ins.guard();
+            std::visit([&](auto &ir) {
+                using T = std::decay_t<decltype(ir)>;
+
+                if constexpr (std::is_same_v<T, ir::AssignmentCode>) {
+                    gen_assignment(e, ir);
+                } else if constexpr (std::is_same_v<T, ir::JumpCode>) {
+                    e.instruction(Op::jmp, {x86::address(syms.labels[ir.dist])});
+                } else if constexpr (std::is_same_v<T, ir::LabelCode>) {
+                    e.label(syms.labels[ir.label]);
+                } else if constexpr (std::is_same_v<T, ir::CompareCodeIR>) {
+                    gen_compare(e, ir);
+                } else if constexpr (std::is_same_v<T, ir::PrintCodeIR>) {
+                    gen_print(e, ir);
+                }
+            }, *ins);
+        }
+    }
+
+    template<typename Emitter>
+    void codegen::CodeGenerator::lower(Emitter &e) {
+        declare(e);
+        gen_variables(e);
+        gen_start(e);
+        gen_code(e);
+        gen_end(e);
+
+        if (need_print_num || need_print_string) // NOLINT
+            gen_flush_function(e);
+        if (need_print_num) // NOLINT
+            gen_print_num_function(e);
+        if (need_print_string) // NOLINT
+            gen_print_string_function(e);
+    }
+
+    std::size_t codegen::CodeGenerator::estimate_size() const noexcept {
+        // Upper bound, so the buffer never grows while instructions are
+        // emitted. The longest lowering (a division at -O0) is five lines
+        // with three operands, each at most "qword [rel " and a name or a
+        // 20-digit number.
+        std::size_t name = 20;
+        for (const auto &v: ir.variables)
+            name = std::max(name, sym::view(v.name).size());
+
+        std::size_t size = 8192; // section headers, digitPairs, helpers
+        size += ir.code.code.size() * (96 + 3 * (name + 16));
+        size += (ir.variables.size() + ir.temps) * (name + 16);
+        for (auto c: ir.constants)
+            size += sym::view(c).size() * 6 + 96; // "255, " per byte, "\tdb " per line, labels, "_len equ"
+        return size;
+    }
+
+    void codegen::CodeGenerator::scan() {
+        // MUST reset every time
+        need_print_num = false;
+        need_print_string = false;
+
+        for (auto ins: ir.code.code) {
+            [[maybe_unused]] auto g = ins.guard();
+            std::visit([&](auto &ir) {
+                using T = std::decay_t<decltype(ir)>;
+
+                if constexpr (std::is_same_v<T, ir::PrintCodeIR>) {
+                    if (ir.type == ast::PrintType::Str)
+                        need_print_string = true;
+                    else
+                        need_print_num = true;
+                }
+            }, *ins);
+        }
+    }
+
+    std::string_view codegen::CodeGenerator::generate() {
+        out.clear();
+        out.reserve(estimate_size());
+        scan();
+
+        x86::NasmWriter writer(out);
+        lower(writer);
+        return {out.data(), out.size()};
+    }
+
+    x86::Module codegen::CodeGenerator::encode() {
+        scan();
+
+        x86::Encoder encoder;
+        lower(encoder);
+        return encoder.finish();
+    }
+
+    template<typename Emitter>
+    void codegen::CodeGenerator::gen_flush_function(Emitter &e) {
+        const auto loop = e.symbol("flush_out.loop"sv);
+        const auto done = e.symbol("flush_out.done"sv);
+        const auto out_pos = x86::mem(8, syms.out_pos);
+
+        e.label(syms.flush_out);
+        e.instruction(Op::mov, {rsi, x86::address(syms.out_buf)});
+        e.instruction(Op::mov, {rdx, out_pos});
+
+        e.label(loop);
+        e.instruction(Op::test, {rdx, rdx});
+        e.instruction(Op::jcc, {x86::address(done)}, Cond::e);
+        e.instruction(Op::mov, {rax, x86::imm(1)}); // write
+        e.instruction(Op::mov, {rdi, x86::imm(1)}); // stdout
+        e.instruction(Op::syscall, {});
+        e.instruction(Op::test, {rax, rax});
+        e.instruction(Op::jcc, {x86::address(done)}, Cond::le); // error: drop what is left
+        e.instruction(Op::add, {rsi, rax}); // partial write: continue after it
+        e.instruction(Op::sub, {rdx, rax});
+        e.instruction(Op::jmp, {x86::address(loop)});
+
+        e.label(done);
+        e.instruction(Op::mov, {out_pos, x86::imm(0)});
+        e.instruction(Op::ret, {});
+    }
+
+    template<typename Emitter>
+    void codegen::CodeGenerator::gen_print_num_function(Emitter &e) {
+        // The digit count is found first, so the number is written straight
+        // into outBuf: two digits per step from digitPairs, with n / 100
+        // computed as a multiply by the reciprocal instead of a div.
+        const auto start = e.symbol("print_num.start"sv);
+        const auto count = e.symbol("print_num.count"sv);
+        const auto count_loop = e.symbol("print_num.count_loop"sv);
+        const auto place = e.symbol("print_num.place"sv);
+        const auto pairs = e.symbol("print_num.pairs"sv);
+        const auto tail = e.symbol("print_num.tail"sv);
+        const auto one = e.symbol("print_num.one"sv);
+        const auto out_pos = x86::mem(8, syms.out_pos);
+        const auto out_buf = x86::address(syms.out_buf);
+
+        e.label(syms.print_num);
+        e.instruction(Op::cmp, {out_pos, x86::imm(detail::out_cap - 32)});
+        e.instruction(Op::jcc, {x86::address(start)}, Cond::be);
+        e.instruction(Op::push, {rdi});
+        e.instruction(Op::call, {x86::address(syms.flush_out)});
+        e.instruction(Op::pop, {rdi});
+
+        e.label(start);
+        e.instruction(Op::mov, {rsi, out_pos});
+        e.instruction(Op::add, {rsi, out_buf}); // write cursor
+        e.instruction(Op::mov, {rax, rdi});     // number
+        e.instruction(Op::test, {rdi, rdi});
+        e.instruction(Op::jcc, {x86::address(count)}, Cond::ns);
+        e.instruction(Op::mov, {x86::mem(1, Gpr::rsi), x86::imm('-')});
+        e.instruction(Op::inc, {rsi});
+        e.instruction(Op::neg, {rax}); // |INT64_MIN| = 2^63 is exact as unsigned
+
+        e.label(count);
+        e.instruction(Op::mov, {ecx, x86::imm(1)});  // digits
+        e.instruction(Op::mov, {r11, x86::imm(10)}); // 10^digits
+
+        e.label(count_loop);
+        e.instruction(Op::cmp, {rax, r11});
+        e.instruction(Op::jcc, {x86::address(place)}, Cond::b);
+        e.instruction(Op::inc, {ecx});
+        e.instruction(Op::cmp, {ecx, x86::imm(20)});
+        e.instruction(Op::jcc, {x86::address(place)}, Cond::e);
+        e.instruction(Op::lea, {r11, x86::mem(8, Gpr::r11, 0, Gpr::r11, 4)});
+        e.instruction(Op::add, {r11, r11});
+        e.instruction(Op::jmp, {x86::address(count_loop)});
+
+        e.label(place);
+        e.instruction(Op::add, {rsi, rcx}); // one past the last digit
+        e.instruction(Op::mov, {x86::mem(1, Gpr::rsi), x86::imm(10)}); // newline
+        e.instruction(Op::lea, {rdi, x86::mem(8, Gpr::rsi, 1)});
+        e.instruction(Op::sub, {rdi, out_buf});
+        e.instruction(Op::mov, {out_pos, rdi});
+
+        e.label(pairs);
+        e.instruction(Op::cmp, {rax, x86::imm(100)});
+        e.instruction(Op::jcc, {x86::address(tail)}, Cond::b);
+        e.instruction(Op::mov, {rdi, rax});
+        e.instruction(Op::shr, {rax, x86::imm(2)});
+        e.instruction(Op::mov, {rdx, x86::imm(0x28F5C28F5C28F5C3)});
+        e.instruction(Op::mul, {rdx});
+        e.instruction(Op::shr, {rdx, x86::imm(2)}); // rdx = n / 100
+        e.instruction(Op::mov, {rax, rdx});
+        e.instruction(Op::imul, {rdx, rdx, x86::imm(100)});
+        e.instruction(Op::sub, {rdi, rdx}); // rdi = n % 100
+        e.instruction(Op::movzx, {edx, x86::mem(2, syms.digit_pairs, 0, Gpr::rdi, 2)});
+        e.instruction(Op::sub, {rsi, x86::imm(2)});
+        e.instruction(Op::mov, {x86::mem(2, Gpr::rsi), dx});
+        e.instruction(Op::jmp, {x86::address(pairs)});
+
+        e.label(tail);
+        e.instruction(Op::cmp, {rax, x86::imm(10)});
+        e.instruction(Op::jcc, {x86::address(one)}, Cond::b);
+        e.instruction(Op::movzx, {edx, x86::mem(2, syms.digit_pairs, 0, Gpr::rax, 2)});
+        e.instruction(Op::mov, {x86::mem(2, Gpr::rsi, -2), dx});
+        e.instruction(Op::ret, {});
+
+        e.label(one);
+        e.instruction(Op::add, {al, x86::imm('0')});
+        e.instruction(Op::mov, {x86::mem(1, Gpr::rsi, -1), al});
+        e.instruction(Op::ret, {});
+    }
+
+    template<typename Emitter>
+    void codegen::CodeGenerator::gen_print_string_function(Emitter &e) {
+        // rsi = char*, rdx = length. Strings longer than the free space
+        // are copied in chunks, flushing in between.
+        const auto copy = e.symbol("print_string.copy"sv);
+        const auto chunk = e.symbol("print_string.chunk"sv);
+        const auto done = e.symbol("print_string.done"sv);
+        const auto out_pos = x86::mem(8, syms.out_pos);
+
+        e.label(syms.print_string);
+        e.instruction(Op::mov, {rcx, rdx});
+
+        e.label(copy);
+        e.instruction(Op::test, {rcx, rcx}); // rcx = bytes left
+        e.instruction(Op::jcc, {x86::address(done)}, Cond::e);
+        e.instruction(Op::mov, {rdx, x86::imm(detail::out_cap)});
+        e.instruction(Op::sub, {rdx, out_pos}); // room
+        e.instruction(Op::jcc, {x86::address(chunk)}, Cond::ne);
+        e.instruction(Op::push, {rsi});
+        e.instruction(Op::push, {rcx});
+        e.instruction(Op::call, {x86::address(syms.flush_out)});
+        e.instruction(Op::pop, {rcx});
+        e.instruction(Op::pop, {rsi});
+        e.instruction(Op::jmp, {x86::address(copy)});
+
+        e.label(chunk);
+        e.instruction(Op::cmp, {rdx, rcx});
+        e.instruction(Op::cmovcc, {rdx, rcx}, Cond::a); // rdx = min(room, left)
+        e.instruction(Op::sub, {rcx, rdx});
+        e.instruction(Op::mov, {rdi, out_pos});
+        e.instruction(Op::lea, {rax, x86::mem(8, Gpr::rdi, 0, Gpr::rdx)});
+        e.instruction(Op::mov, {out_pos, rax});
+        e.instruction(Op::add, {rdi, x86::address(syms.out_buf)});
+        e.instruction(Op::xchg, {rcx, rdx});
+        e.instruction(Op::rep_movsb, {});
+        e.instruction(Op::mov, {rcx, rdx});
+        e.instruction(Op::jmp, {x86::address(copy)});
+
+        e.label(done);
+        e.instruction(Op::ret, {});
+    }
+
+} // namespace pseu
@@ -0,0 +1,268 @@
+#include "elf.hpp"
+#include <filesystem>
+#include <fstream>
+#include <stdexcept>
+
+namespace pseu {
+
+    namespace {
+        // ELF64 constants (System V gABI, x86-64 psABI)
+        constexpr std::uint16_t et_rel = 1;
+        constexpr std::uint16_t et_exec = 2;
+        constexpr std::uint16_t em_x86_64 = 62;
+        constexpr std::uint32_t pt_load = 1;
+        constexpr std::uint32_t pf_x = 1, pf_w = 2, pf_r = 4;
+        constexpr std::uint32_t sht_progbits = 1, sht_symtab = 2, sht_strtab = 3, sht_rela = 4, sht_nobits = 8;
+        constexpr std::uint64_t shf_write = 1, shf_alloc = 2, shf_execinstr = 4, shf_info_link = 0x40;
+        constexpr std::uint8_t stb_local = 0, stb_global = 1;
+        constexpr std::uint32_t r_x86_64_64 = 1, r_x86_64_pc32 = 2, r_x86_64_32s = 11;
+
+        constexpr std::uint64_t ehdr_size = 64, phdr_size = 56, shdr_size = 64, sym_size = 24, rela_size = 24;
+        constexpr std::uint64_t page = 0x1000;
+        constexpr std::uint64_t image_base = elf::text_address - page;
+
+        constexpr std::uint64_t align_up(std::uint64_t v, std::uint64_t a) { return (v + a - 1) / a * a; }
+
+        /// @brief Little-endian byte sink for headers and tables.
+        class Writer final {
+        public:
+            std::vector<std::uint8_t> bytes;
+
+            void u8(std::uint8_t v) { bytes.push_back(v); }
+
+            void u16(std::uint16_t v) { put(v, 2); }
+
+            void u32(std::uint32_t v) { put(v, 4); }
+
+            void u64(std::uint64_t v) { put(v, 8); }
+
+            void raw(const std::vector<std::uint8_t> &v) { bytes.insert(bytes.end(), v.begin(), v.end()); }
+
+            void pad_to(std::uint64_t offset) { bytes.resize(offset, 0); }
+
+            [[nodiscard]] std::uint64_t size() const noexcept { return bytes.size(); }
+
+        private:
+            void put(std::uint64_t v, int n) {
+                for (int i = 0; i < n; ++i)
+                    bytes.push_back(static_cast<std::uint8_t>(v >> (8 * i)));
+            }
+        };
+
+        void header(Writer &w, std::uint16_t type, std::uint64_t entry, std::uint16_t phnum,
+                    std::uint64_t shoff, std::uint16_t shnum, std::uint16_t shstrndx) {
+            constexpr std::uint8_t ident[] = {0x7F, 'E', 'L', 'F', 2 /* 64-bit */, 1 /* LSB */, 1 /* version */};
+            for (auto b: ident)
+                w.u8(b);
+            w.pad_to(16);
+            w.u16(type);
+            w.u16(em_x86_64);
+            w.u32(1);
+            w.u64(entry);
+            w.u64(phnum ? ehdr_size : 0);
+            w.u64(shoff);
+            w.u32(0);
+            w.u16(ehdr_size);
+            w.u16(phnum ? phdr_size : 0);
+            w.u16(phnum);
+            w.u16(shnum ? shdr_size : 0);
+            w.u16(shnum);
+            w.u16(shstrndx);
+        }
+
+        void section_header(Writer &w, std::uint32_t name, std::uint32_t type, std::uint64_t flags,
+                            std::uint64_t offset, std::uint64_t size, std::uint32_t link, std::uint32_t info,
+                            std::uint64_t align, std::uint64_t entsize) {
+            w.u32(name);
+            w.u32(type);
+            w.u64(flags);
+            w.u64(0); // sh_addr: unplaced
+            w.u64(offset);
+            w.u64(size);
+            w.u32(link);
+            w.u32(info);
+            w.u64(align);
+            w.u64(entsize);
+        }
+
+        std::uint32_t reloc_type(x86::RelocKind k) {
+            switch (k) {
+                case x86::RelocKind::pc32:
+                    return r_x86_64_pc32;
+                case x86::RelocKind::abs32s:
+                    return r_x86_64_32s;
+                case x86::RelocKind::abs64:
+                    return r_x86_64_64;
+            }
+            return 0;
+        }
+
+        /// @brief Section header index of an output section in objects.
+        std::uint16_t section_index(x86::Section s) {
+            switch (s) {
+                case x86::Section::text:
+                    return 1;
+                case x86::Section::data:
+                    return 2;
+                case x86::Section::bss:
+                    return 3;
+                default:
+                    return 0;
+            }
+        }
+    }
+
+    void elf::save(const std::string &path, const std::vector<std::uint8_t> &bytes, bool executable) {
+        {
+            std::ofstream f(path, std::ios::binary | std::ios::trunc);
+            if (!f)
+                throw std::runtime_error("Cannot open " + path);
+            f.write(reinterpret_cast<const char *>(bytes.data()), static_cast<std::streamsize>(bytes.size()));
+            f.close();
+            if (!f)
+                throw std::runtime_error("Cannot write " + path);
+        }
+        if (!executable)
+            return;
+
+        namespace fs = std::filesystem;
+        std::error_code ec;
+        fs::permissions(path, fs::perms::owner_exec | fs::perms::group_exec | fs::perms::others_exec,
+                        fs::perm_options::add, ec);
+    }
+
+    std::vector<std::uint8_t> elf::object(const x86::Module &m) {
+        // ---- string and symbol tables: locals first, as the gABI requires ----
+        Writer strtab;
+        strtab.u8(0);
+        Writer symtab;
+        symtab.pad_to(sym_size); // entry 0: undefined
+
+        std::vector<std::uint32_t> index(m.symbols.size());
+        std::uint32_t next = 1;
+        std::uint32_t first_global = 0;
+        for (const bool global: {false, true}) {
+            if (global)
+                first_global = next;
+            for (std::size_t i = 0; i < m.symbols.size(); ++i) {
+                const auto &s = m.symbols[i];
+                if (s.global != global)
+                    continue;
+                index[i] = next++;
+                symtab.u32(static_cast<std::uint32_t>(strtab.size()));
+                symtab.u8(static_cast<std::uint8_t>((global ? stb_global : stb_local) << 4)); // STT_NOTYPE
+                symtab.u8(0);
+                symtab.u16(section_index(s.section));
+                symtab.u64(s.offset);
+                symtab.u64(0);
+                for (auto c: s.name)
+                    strtab.u8(static_cast<std::uint8_t>(c));
+                strtab.u8(0);
+            }
+        }
+
+        Writer rela;
+        for (const auto &r: m.relocations) {
+            rela.u64(r.offset);
+            rela.u64((static_cast<std::uint64_t>(index[r.symbol]) << 32) | reloc_type(r.kind));
+            rela.u64(static_cast<std::uint64_t>(r.addend));
+        }
+
+        Writer shstrtab;
+        std::vector<std::uint32_t> names;
+        for (std::string_view n: {"", ".text", ".data", ".bss", ".symtab", ".strtab", ".rela.text", ".shstrtab"}) {
+            names.push_back(static_cast<std::uint32_t>(shstrtab.size()));
+            for (auto c: n)
+                shstrtab.u8(static_cast<std::uint8_t>(c));
+            shstrtab.u8(0);
+        }
+
+        // ---- layout ----
+        Writer w;
+        header(w, et_rel, 0, 0, 0, 0, 0); // patched below
+        w.pad_to(align_up(w.size(), 16));
+        const auto text_off = w.size();
+        w.raw(m.text);
+        w.pad_to(align_up(w.size(), 8));
+        const auto data_off = w.size();
+        w.raw(m.data);
+        w.pad_to(align_up(w.size(), 8));
+        const auto symtab_off = w.size();
+        w.raw(symtab.bytes);
+        const auto strtab_off = w.size();
+        w.raw(strtab.bytes);
+        w.pad_to(align_up(w.size(), 8));
+        const auto rela_off = w.size();
+        w.raw(rela.bytes);
+        const auto shstrtab_off = w.size();
+        w.raw(shstrtab.bytes);
+        w.pad_to(align_up(w.size(), 8));
+        const auto shoff = w.size();
+
+        section_header(w, 0, 0, 0, 0, 0, 0, 0, 0, 0);
+        section_header(w, names[1], sht_progbits, shf_alloc | shf_execinstr, text_off, m.text.size(), 0, 0, 16, 0);
+        section_header(w, names[2], sht_progbits, shf_alloc | shf_write, data_off, m.data.size(), 0, 0, 8, 0);
+        section_header(w, names[3], sht_nobits, shf_alloc | shf_write, data_off + m.data.size(), m.bss_size, 0, 0,
+                       8, 0);
+        section_header(w, names[4], sht_symtab, 0, symtab_off, symtab.size(), 5, first_global, 8, sym_size);
+        section_header(w, names[5], sht_strtab, 0, strtab_off, strtab.size(), 0, 0, 1, 0);
+        section_header(w, names[6], sht_rela, shf_info_link, rela_off, rela.size(), 4, 1, 8, rela_size);
+        section_header(w, names[7], sht_strtab, 0, shstrtab_off, shstrtab.size(), 0, 0, 1, 0);
+
+        Writer h;
+        header(h, et_rel, 0, 0, shoff, 8, 7);
+        std::copy(h.bytes.begin(), h.bytes.end(), w.bytes.begin());
+
+        return std::move(w.bytes);
+    }
+
+    std::vector<std::uint8_t> elf::executable(const x86::Module &m) {
+        const auto start = m.find("_start");
+        if (start < 0)
+            throw std::runtime_error("No _start symbol");
+
+        // ---- layout: headers + .text read-execute, then .data + .bss read-write ----
+        const std::uint64_t text_off = page;
+        const std::uint64_t data_off = align_up(text_off + m.text.size(), page);
+        const std::uint64_t data_addr = image_base + data_off;
+        const x86::Layout layout{text_address, data_addr, data_addr + align_up(m.data.size(), 16)};
+        const bool writable = !m.data.empty() || m.bss_size != 0;
+
+        auto text = m.text;
+        x86::relocate(m, layout, text);
+
+        Writer w;
+        const std::uint16_t phnum = writable ? 2 : 1;
+        header(w, et_exec, layout.address(m.symbols[start]), phnum, 0, 0, 0);
+
+        w.u32(pt_load);
+        w.u32(pf_r | pf_x);
+        w.u64(0);
+        w.u64(image_base);
+        w.u64(image_base);
+        w.u64(text_off + text.size());
+        w.u64(text_off + text.size());
+        w.u64(page);
+
+        if (writable) {
+            w.u32(pt_load);
+            w.u32(pf_r | pf_w);
+            w.u64(data_off);
+            w.u64(data_addr);
+            w.u64(data_addr);
+            w.u64(m.data.size());
+            w.u64(layout.bss - data_addr + m.bss_size);
+            w.u64(page);
+        }
+
+        w.pad_to(text_off);
+        w.raw(text);
+        if (writable) {
+            w.pad_to(data_off);
+            w.raw(m.data);
+        }
+
+        return std::move(w.bytes);
+    }
+
+} // namespace pseu
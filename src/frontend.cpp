@@ -0,0 +1,126 @@
+#include "frontend.hpp"
+#include <climits>
+#include <stdexcept>
+
+#include "parser.tab.hpp"
+
+/*
+ * Reentrant Flex API (generated from scanner.l with %option reentrant).
+ * Only the entry points used below are declared here; the scanner
+ * handle and the buffer handle are opaque.
+ */
+struct yy_buffer_state;
+using YYBufferState = yy_buffer_state *;
+
+int yylex_init_extra(pseu::frontend::ParseContext *extra, yyscan_t *scanner);
+
+int yylex_destroy(yyscan_t scanner);
+
+YYBufferState yy_scan_bytes(const char *bytes, int len, yyscan_t scanner);
+
+YYBufferState yy_scan_buffer(char *base, std::size_t size, yyscan_t scanner);
+
+void yy_delete_buffer(YYBufferState b, yyscan_t scanner);
+
+pseu::parser::Parser::symbol_type yylex(yyscan_t scanner);
+
+namespace pseu::frontend {
+
+    namespace {
+
+        /**
+         * @brief RAII owner of one reentrant scanner and its input buffer.
+         *
+         * The scanner is bound to a ParseContext at construction, so the
+         * Flex actions can update the line counter and report errors
+         * through <code>yyextra</code>.
+         */
+        class Scanner final {
+        public:
+            explicit Scanner(ParseContext &ctx) {
+                if (yylex_init_extra(&ctx, &scanner_) != 0)
+                    throw std::runtime_error("Cannot initialise scanner");
+            }
+
+            Scanner(const Scanner &) = delete;
+
+            Scanner &operator=(const Scanner &) = delete;
+
+            ~Scanner() {
+                if (buf_)
+                    yy_delete_buffer(buf_, scanner_);
+                yylex_destroy(scanner_);
+            }
+
+            void scan_bytes(std::string_view source) {
+                check_size(source.size());
+                buf_ = yy_scan_bytes(source.data(), static_cast<int>(source.size()), scanner_);
+            }
+
+            void scan_in_place(char *base, std::size_t padded_size) {
+                check_size(padded_size);
+                buf_ = yy_scan_buffer(base, padded_size, scanner_);
+                if (!buf_)
+                    throw std::runtime_error("Source buffer is not NUL-padded");
+            }
+
+            [[nodiscard]] yyscan_t get() const noexcept { return scanner_; }
+
+        private:
+            /// @brief Flex counts buffer characters in an <code>int</code>; larger sources would lex a wrong prefix.
+            static void check_size(std::size_t size) {
+                if (size > static_cast<std::size_t>(INT_MAX))
+                    throw std::runtime_error("Source too large: " + std::to_string(size) +
+                                             " bytes, the scanner takes at most 2 GiB");
+            }
+
+            yyscan_t scanner_ = nullptr;
+            YYBufferState buf_ = nullptr;
+        };
+
+        ast::NodeId run(ParseContext &ctx, Scanner &scanner) {
+            if (parser::Parser(ctx, scanner.get()).parse() != 0) {
+                ctx.fail("syntax error");
+                throw std::runtime_error(ctx.error);
+            }
+            return ctx.root;
+        }
+
+    } // namespace
+
+    ast::NodeId parse(std::string_view source, ast::AstArena &arena, int first_line) {
+        ParseContext ctx{arena};
+        ctx.line = first_line;
+        Scanner scanner(ctx);
+        scanner.scan_bytes(source);
+        return run(ctx, scanner);
+    }
+
+    ast::NodeId parse_in_place(char *base, std::size_t padded_size, ast::AstArena &arena, int first_line) {
+        ParseContext ctx{arena};
+        ctx.line = first_line;
+        Scanner scanner(ctx);
+        scanner.scan_in_place(base, padded_size);
+        return run(ctx, scanner);
+    }
+
+    std::size_t tokenize(std::string_view source) {
+        using kind = parser::Parser::symbol_kind;
+
+        ast::AstArena unused;
+        ParseContext ctx{unused};
+        Scanner scanner(ctx);
+        scanner.scan_bytes(source);
+
+        std::size_t count = 0;
+        for (;;) {
+            const auto sym = yylex(scanner.get());
+            if (sym.kind() == kind::S_YYEOF)
+                return count;
+            if (sym.kind() == kind::S_YYerror)
+                throw std::runtime_error(ctx.error);
+            ++count;
+        }
+    }
+
+} // namespace pseu::frontend
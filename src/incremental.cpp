@@ -0,0 +1,129 @@
+#include "incremental.hpp"
+#include "frontend.hpp"
+#include <algorithm>
+#include <jh/meta>
+
+namespace pseu {
+
+    namespace {
+        constexpr bool is_id_cont(char c) {
+            return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') || c == '_';
+        }
+
+        /// @brief Position of the first character at or after <code>i</code> that is not whitespace or a comment.
+        std::size_t skip_blank(std::string_view s, std::size_t i) {
+            while (i < s.size()) {
+                const char c = s[i];
+                if (c == ' ' || c == '\t' || c == '\r' || c == '\f' || c == '\n')
+                    ++i;
+                else if (c == '#')
+                    while (i < s.size() && s[i] != '\n')
+                        ++i;
+                else
+                    break;
+            }
+            return i;
+        }
+
+        /// @brief Whether the keyword <code>else</code> starts at <code>i</code>.
+        bool is_else(std::string_view s, std::size_t i) {
+            return s.substr(i, 4) == "else" && (i + 4 == s.size() || !is_id_cont(s[i + 4]));
+        }
+    }
+
+    std::vector<incremental::Span> incremental::split(std::string_view s) {
+        std::vector<Span> spans;
+        std::size_t start = 0;
+        std::uint32_t line = 1;
+        std::size_t depth = 0;
+
+        const auto close = [&](std::size_t end) {
+            spans.push_back({static_cast<std::uint32_t>(end), line,
+                             jh::meta::fnv1a64(s.data() + start, end - start)});
+            start = end;
+        };
+
+        for (std::size_t i = 0; i < s.size(); ++i) {
+            switch (s[i]) {
+                case '\n':
+                    ++line;
+                    break;
+                case '#':
+                    while (i + 1 < s.size() && s[i + 1] != '\n')
+                        ++i;
+                    break;
+                case '"':
+                    for (++i; i < s.size() && s[i] != '"'; ++i) {
+                        if (s[i] == '\\' && i + 1 < s.size())
+                            ++i;
+                        if (s[i] == '\n')
+                            ++line;
+                    }
+                    if (i == s.size())
+                        return spans; // unterminated: the parser reports it
+                    break;
+                case '{':
+                    ++depth;
+                    break;
+                case '}':
+                    if (depth && --depth == 0 && !is_else(s, skip_blank(s, i + 1)))
+                        close(i + 1);
+                    break;
+                case ';':
+                    if (depth == 0)
+                        close(i + 1);
+                    break;
+                default:
+                    break;
+            }
+        }
+        return spans;
+    }
+
+    ir::GeneratedIR incremental::Session::compile(std::string_view source, char *padded, std::size_t padded_size) {
+        auto spans = split(source);
+
+        // longest unchanged prefix of top-level statements
+        std::size_t keep = 0;
+        const auto limit = std::min(spans.size(), spans_.size());
+        while (keep < limit && spans[keep].end == spans_[keep].end && spans[keep].hash == spans_[keep].hash)
+            ++keep;
+
+        const std::size_t cut = keep ? spans[keep - 1].end : 0;
+        const int line = keep ? static_cast<int>(spans[keep - 1].line) : 1;
+
+        // nothing kept refers to the symbols of earlier compilations
+        const sym::TableScope scope(symbols_);
+        if (keep == 0) {
+            reset();
+            symbols_.clear();
+        }
+
+        arena_.clear();
+        const auto root = padded
+                          ? frontend::parse_in_place(padded + cut, padded_size - cut, arena_, line)
+                          : frontend::parse(source.substr(cut), arena_, line);
+
+        gen_.rewind(keep);
+        try {
+            gen_.append(arena_, root);
+        } catch (...) {
+            reset();
+            throw;
+        }
+
+        stats_ = {gen_.statements(), keep};
+        auto ir = gen_.get();
+        if (gen_.statements() == spans.size())
+            spans_ = std::move(spans);
+        else
+            reset(); // spans do not match the statements: nothing to reuse next time
+        return ir;
+    }
+
+    void incremental::Session::reset() {
+        gen_ = ir::IntermediateCodeGen();
+        spans_.clear();
+    }
+
+} // namespace pseu
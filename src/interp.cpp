@@ -0,0 +1,272 @@
+#include "interp.hpp"
+#include <array>
+#include <charconv>
+#include <limits>
+#include <stdexcept>
+#include <string_view>
+#include <unordered_map>
+
+namespace pseu {
+
+    namespace {
+        constexpr std::uint32_t no_label = std::numeric_limits<std::uint32_t>::max();
+
+        /// @brief Builds the bytecode and the frame layout of a Program.
+        class Decoder final {
+        public:
+            Decoder(const ir::GeneratedIR &ir, std::vector<interp::Instr> &code,
+                    std::vector<std::int64_t> &frame, std::vector<std::string> &texts)
+                    : ir(ir), code(code), frame(frame), texts(texts) {
+                // [variables][temporaries T1..][text halves of string variables][immediates]
+                frame.assign(ir.variables.size() + ir.temps, 0);
+                text_slot.resize(ir.variables.size());
+                for (std::uint32_t i = 0; i < ir.variables.size(); ++i) {
+                    if (ir.variables[i].type == sym::known::kw_int)
+                        continue;
+                    text_slot[i] = static_cast<std::uint32_t>(frame.size());
+                    frame.push_back(0);
+                }
+
+                texts.reserve(ir.constants.size() + 1);
+                texts.emplace_back();
+                for (auto c: ir.constants) {
+                    auto &t = texts.emplace_back(sym::view(c));
+                    t += '\n';
+                }
+            }
+
+            void run() {
+                for (auto ins: ir.code.code) {
+                    [[maybe_unused]] auto g = ins.guard();
+                    std::visit([&](auto &i) { decode(i); }, *ins);
+                }
+                code.push_back({interp::Op::Halt});
+
+                for (auto at: jumps) {
+                    auto &target = code[at].c;
+                    if (target >= label_at.size() || label_at[target] == no_label)
+                        throw std::runtime_error("Jump to undefined label L" + std::to_string(target));
+                    target = label_at[target];
+                }
+            }
+
+        private:
+            [[nodiscard]] bool is_string(const ir::Operand &o) const noexcept {
+                return o.kind == ir::OperandKind::Str
+                       || (o.kind == ir::OperandKind::Var && ir.variables[o.index()].type != sym::known::kw_int);
+            }
+
+            std::uint32_t constant(std::int64_t v) {
+                const auto [it, fresh] = constants.try_emplace(v, static_cast<std::uint32_t>(frame.size()));
+                if (fresh)
+                    frame.push_back(v);
+                return it->second;
+            }
+
+            /// @brief Frame slot of an operand's value.
+            std::uint32_t slot(const ir::Operand &o) {
+                switch (o.kind) {
+                    case ir::OperandKind::Var:
+                        return o.index();
+                    case ir::OperandKind::Temp:
+                        return static_cast<std::uint32_t>(ir.variables.size()) + o.index() - 1;
+                    case ir::OperandKind::Imm:
+                    case ir::OperandKind::Str:
+                        // a string constant's value is its handle
+                        return constant(o.value);
+                    case ir::OperandKind::None:
+                        break;
+                }
+                return constant(0);
+            }
+
+            /// @brief Frame slot holding the text handle of an operand; handle 0 prints nothing.
+            std::uint32_t text(const ir::Operand &o) {
+                if (o.kind == ir::OperandKind::Var && is_string(o))
+                    return text_slot[o.index()];
+                return constant(o.kind == ir::OperandKind::Str ? o.value : 0);
+            }
+
+            void emit(interp::Op op, std::uint32_t a, std::uint32_t b = 0, std::uint32_t c = 0) {
+                code.push_back({op, a, b, c});
+            }
+
+            void jump(interp::Op op, std::uint32_t a, std::uint32_t b, ir::LabelId target) {
+                jumps.push_back(code.size());
+                emit(op, a, b, target);
+            }
+
+            void decode(const ir::AssignmentCode &a) {
+                if (a.op == ir::BinOp::None) {
+                    emit(interp::Op::Mov, slot(a.var), slot(a.left));
+                    if (is_string(a.var))
+                        emit(interp::Op::Mov, text(a.var), text(a.left));
+                    return;
+                }
+                static constexpr std::array<interp::Op, 5> ops{
+                        interp::Op::Mov, interp::Op::Add, interp::Op::Sub, interp::Op::Mul, interp::Op::Div
+                };
+                emit(ops[static_cast<std::uint8_t>(a.op)], slot(a.var), slot(a.left), slot(a.right));
+            }
+
+            void decode(const ir::JumpCode &j) {
+                jump(interp::Op::Jmp, 0, 0, j.dist);
+            }
+
+            void decode(const ir::LabelCode &l) {
+                if (l.label >= label_at.size())
+                    label_at.resize(l.label + 1, no_label);
+                label_at[l.label] = static_cast<std::uint32_t>(code.size());
+            }
+
+            void decode(const ir::CompareCodeIR &c) {
+                static constexpr std::array<interp::Op, 6> ops{
+                        interp::Op::Jeq, interp::Op::Jne, interp::Op::Jlt,
+                        interp::Op::Jle, interp::Op::Jgt, interp::Op::Jge
+                };
+                jump(ops[static_cast<std::uint8_t>(c.operation)], slot(c.left), slot(c.right), c.jump);
+            }
+
+            void decode(const ir::PrintCodeIR &p) {
+                if (p.type == ast::PrintType::Str)
+                    emit(interp::Op::PrintStr, text(p.value));
+                else
+                    emit(interp::Op::PrintInt, slot(p.value));
+            }
+
+            const ir::GeneratedIR &ir;
+            std::vector<interp::Instr> &code;
+            std::vector<std::int64_t> &frame;
+            std::vector<std::string> &texts;
+            std::vector<std::uint32_t> text_slot;      // by variable slot
+            std::vector<std::uint32_t> label_at;       // by label id
+            std::vector<std::size_t> jumps;            // instructions whose c is still a label
+            std::unordered_map<std::int64_t, std::uint32_t> constants;
+        };
+
+        /// @brief Output buffer of a run, drained to a stdio stream.
+        class Output final {
+        public:
+            explicit Output(std::FILE *f) : f(f) {}
+
+            void number(std::int64_t v) {
+                if (pos > buf.size() - 21)
+                    flush();
+                auto [end, ec] = std::to_chars(buf.data() + pos, buf.data() + buf.size(), v);
+                *end = '\n';
+                pos = static_cast<std::size_t>(end - buf.data()) + 1;
+            }
+
+            void text(std::string_view s) {
+                if (s.size() > buf.size() - pos) {
+                    flush();
+                    if (s.size() > buf.size()) {
+                        std::fwrite(s.data(), 1, s.size(), f);
+                        return;
+                    }
+                }
+                s.copy(buf.data() + pos, s.size());
+                pos += s.size();
+            }
+
+            void flush() {
+                std::fwrite(buf.data(), 1, pos, f);
+                pos = 0;
+            }
+
+        private:
+            std::FILE *f;
+            std::size_t pos = 0;
+            std::array<char, 65536> buf;
+        };
+
+        /// @brief Bytecode with the operation replaced by its handler address.
+        struct Threaded final {
+            const void *handler;
+            std::uint32_t a, b, c;
+        };
+    }
+
+    interp::Program::Program(const ir::GeneratedIR &ir) {
+        Decoder(ir, code_, frame_, texts_).run();
+    }
+
+    std::uint64_t interp::Program::run(std::FILE *out) const {
+        // Direct threading (GNU labels as values): each handler jumps
+        // straight to the next one, so there is no central switch.
+        static const void *const handlers[] = {
+                &&mov, &&add, &&sub, &&mul, &&div,
+                &&jmp, &&jeq, &&jne, &&jlt, &&jle, &&jgt, &&jge,
+                &&print_int, &&print_str,
+                &&halt
+        };
+
+        std::vector<Threaded> code;
+        code.reserve(code_.size());
+        for (const auto &i: code_)
+            code.push_back({handlers[static_cast<std::uint8_t>(i.op)], i.a, i.b, i.c});
+
+        auto frame = frame_;
+        auto *const f = frame.data();
+        const auto *const base = code.data();
+        const Threaded *ip = base;
+        std::uint64_t steps = 0;
+        Output o(out);
+
+        const auto wrap = [](std::uint64_t v) { return static_cast<std::int64_t>(v); };
+        const auto u = [](std::int64_t v) { return static_cast<std::uint64_t>(v); };
+
+#define PSEU_NEXT() do { ++steps; ++ip; goto *ip->handler; } while (0)
+#define PSEU_BRANCH(cond) do { ++steps; ip = (cond) ? base + ip->c : ip + 1; goto *ip->handler; } while (0)
+
+        goto *ip->handler;
+
+        mov:
+        f[ip->a] = f[ip->b];
+        PSEU_NEXT();
+        add:
+        f[ip->a] = wrap(u(f[ip->b]) + u(f[ip->c]));
+        PSEU_NEXT();
+        sub:
+        f[ip->a] = wrap(u(f[ip->b]) - u(f[ip->c]));
+        PSEU_NEXT();
+        mul:
+        f[ip->a] = wrap(u(f[ip->b]) * u(f[ip->c]));
+        PSEU_NEXT();
+        div:
+        if (f[ip->c] == 0 || (f[ip->c] == -1 && f[ip->b] == std::numeric_limits<std::int64_t>::min())) {
+            o.flush();
+            throw std::runtime_error(f[ip->c] == 0 ? "Division by zero" : "Division overflow");
+        }
+        f[ip->a] = f[ip->b] / f[ip->c];
+        PSEU_NEXT();
+        jmp:
+        PSEU_BRANCH(true);
+        jeq:
+        PSEU_BRANCH(f[ip->a] == f[ip->b]);
+        jne:
+        PSEU_BRANCH(f[ip->a] != f[ip->b]);
+        jlt:
+        PSEU_BRANCH(f[ip->a] < f[ip->b]);
+        jle:
+        PSEU_BRANCH(f[ip->a] <= f[ip->b]);
+        jgt:
+        PSEU_BRANCH(f[ip->a] > f[ip->b]);
+        jge:
+        PSEU_BRANCH(f[ip->a] >= f[ip->b]);
+        print_int:
+        o.number(f[ip->a]);
+        PSEU_NEXT();
+        print_str:
+        // text slots only ever hold handles: a constant's number or 0
+        o.text(texts_[static_cast<std::size_t>(f[ip->a])]);
+        PSEU_NEXT();
+        halt:
+        o.flush();
+        return steps;
+
+#undef PSEU_BRANCH
+#undef PSEU_NEXT
+    }
+
+} // namespace pseu
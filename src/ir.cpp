@@ -1,301 +1,538 @@
-#include "ir.hpp"
-#include <string_view>
-
-namespace pseu {
-    using namespace std::literals;
-
-    /**
-     * @brief Translation-unit–local interning pool for IR instructions.
-     *
-     * <p>
-     * In this design, all IR nodes are treated as <b>pure data objects</b>:
-     * they have value semantics, immutable identity, and are fully defined
-     * by their structural contents. This makes them suitable for
-     * hash-based deduplication.
-     * </p>
-     *
-     * <p>
-     * IR instructions are wrapped in <code>std::variant</code> and stored
-     * inside a <code>jh::conc::flat_pool</code>, forming an arena-like
-     * contiguous storage domain that reduces allocation fragmentation
-     * while enabling structural deduplication.
-     * </p>
-     *
-     * <p>
-     * The pool capacity may grow as IR complexity increases. No explicit
-     * <code>resize_pool()</code> or shrinking is performed here:
-     * </p>
-     * <ul>
-     *   <li>growth implies a legitimate workload shape,</li>
-     *   <li>there is no benefit in reclaiming memory mid-compilation,</li>
-     *   <li>the compiler typically runs once and exits.</li>
-     * </ul>
-     *
-     * <p>
-     * Reuse-friendly semantics are retained only to allow repeated
-     * compilation within the same process.
-     * </p>
-     */
-    inline ir::ir_pool_t pool{};
-
-    static ir::ir_pool_t::ptr
-    make_assign(std::string_view v,
-                std::string_view l,
-                std::string_view op,
-                std::string_view r) {
-        return pool.acquire(ir::IRInstr{
-                ir::AssignmentCode{
-                        std::string(v),
-                        std::string(l),
-                        std::string(op),
-                        std::string(r)
-                }}
-        );
-    }
-
-    static ir::ir_pool_t::ptr
-    make_jump(std::string_view d) {
-        return pool.acquire(ir::IRInstr{
-                ir::JumpCode{std::string(d)}}
-        );
-    }
-
-    static ir::ir_pool_t::ptr
-    make_label(std::string_view l) {
-        return pool.acquire(ir::IRInstr{
-                ir::LabelCode{std::string(l)}}
-        );
-    }
-
-    static ir::ir_pool_t::ptr
-    make_compare(std::string_view l,
-                 std::string_view op,
-                 std::string_view r,
-                 std::string_view j) {
-        return pool.acquire(ir::IRInstr{
-                ir::CompareCodeIR{
-                        std::string(l),
-                        std::string(op),
-                        std::string(r),
-                        std::string(j)
-                }}
-        );
-    }
-
-    static ir::ir_pool_t::ptr
-    make_print(ast::PrintType t,
-               std::string_view v) {
-        return pool.acquire(ir::IRInstr{
-                ir::PrintCodeIR{
-                        t,
-                        std::string(v)
-                }}
-        );
-    }
-
-    ir::IntermediateCodeGen::IntermediateCodeGen(const std::shared_ptr<ast::ASTNode> &root) : root(root) {
-        exec_statement(root);
-    }
-
-    ir::GeneratedIR ir::IntermediateCodeGen::get() { return GeneratedIR{arr, identifiers, constants}; }
-
-    std::string ir::IntermediateCodeGen::nextTemp() { return "T" + std::to_string(tCounter++); }
-
-    std::string ir::IntermediateCodeGen::nextLabel() { return "L" + std::to_string(lCounter++); }
-
-    [[maybe_unused]] std::string ir::IntermediateCodeGen::currentLabel() const {
-        return "L" + std::to_string(lCounter);
-    }
-
-    std::string ir::IntermediateCodeGen::nextStringSym() { return "S" + std::to_string(sCounter++); }
-
-    template<typename T>
-    std::string ir::IntermediateCodeGen::exec_expr_node(const T &) {
-        return {};
-    }
-
-    std::string ir::IntermediateCodeGen::exec_expr_node(const ast::IdentifierNode &id) {
-        return id.getValue();
-    }
-
-    std::string ir::IntermediateCodeGen::exec_expr_node(const ast::NumberNode &num) {
-        return num.getValue();
-    }
-
-    std::string ir::IntermediateCodeGen::exec_expr_node(const ast::StringLiteralNode &str) {
-        auto sym = nextStringSym();
-        constants[sym] = str.getValue();
-        return sym;
-    }
-
-    std::string ir::IntermediateCodeGen::exec_expr_node(const ast::BinOpNode &bin) {
-        auto left = exec_expr(bin.left);
-        auto right = exec_expr(bin.right);
-
-        auto t = nextTemp();
-        identifiers[t] = "int";
-        arr.append(make_assign(t, left, bin.op_tok.value, right));
-        return t;
-    }
-
-    std::string ir::IntermediateCodeGen::exec_expr(const std::shared_ptr<ast::ASTNode> &n) {
-        return std::visit(
-                [&](const auto &node) -> std::string {
-                    return exec_expr_node(node);
-                },
-                *n
-        );
-    }
-
-    void ir::IntermediateCodeGen::exec_assignment(const ast::Assignment *a) {
-        if (!identifiers.count(a->identifier.value)) {
-            identifiers[a->identifier.value] = "string";
-        }
-        auto right = exec_expr(a->expression);
-        arr.append(make_assign(a->identifier.value, right, "", ""));
-    }
-
-    std::string ir::IntermediateCodeGen::exec_condition(const ast::Condition *c) {
-        auto left = exec_expr(c->left_expression);
-        auto right = exec_expr(c->right_expression);
-
-        // TRUE label should be allocated here
-        auto trueLabel = nextLabel();
-
-        arr.append(make_compare(left, c->comparison.value, right, trueLabel));
-
-        return trueLabel;
-    }
-
-    void ir::IntermediateCodeGen::exec_if(const ast::IfStatement *i) {
-        auto *if_condition = std::get_if<ast::Condition>((i->if_condition).get());
-        auto thenLabel = exec_condition(if_condition);
-        auto elseLabel = nextLabel();
-        auto endLabel = nextLabel();
-
-        // FALSE branch
-        arr.append(make_jump(elseLabel));
-
-        // TRUE branch
-        arr.append(make_label(thenLabel));
-        exec_statement(i->if_body);
-        arr.append(make_jump(endLabel));
-
-        // ELSE branch
-        arr.append(make_label(elseLabel));
-        if (i->else_body)
-            exec_statement(i->else_body);
-
-        // END
-        arr.append(make_label(endLabel));
-    }
-
-    void ir::IntermediateCodeGen::exec_while(const ast::WhileStatement *w) {
-        auto startLabel = nextLabel();
-        auto bodyLabel = nextLabel();
-        auto endLabel = nextLabel();
-
-        arr.append(make_label(startLabel));
-
-        auto *w_condition = std::get_if<ast::Condition>((w->condition).get());
-        // generate condition — true jumps to bodyLabel
-        auto trueLabel = exec_condition(w_condition);
-
-        // false → end
-        arr.append(make_jump(endLabel));
-
-        // true branch = body
-        arr.append(make_label(trueLabel));
-        exec_statement(w->body);
-
-        // loop back
-        arr.append(make_jump(startLabel));
-
-        // end of while
-        arr.append(make_label(endLabel));
-    }
-
-
-    void ir::IntermediateCodeGen::exec_print(const ast::PrintStatement *p) {
-        if (p->type == ast::PrintType::Str) {
-            if (auto str = std::get_if<std::string>(&p->value)) {
-                auto sym = nextStringSym();
-                constants[sym] = *str;
-                arr.code.push_back(make_print(ast::PrintType::Str, sym));
-                return;
-            } else {
-                // variable
-                if (auto *expr = std::get_if<std::shared_ptr<ast::ASTNode>>(&p->value)) {
-                    auto name = exec_expr(*expr);
-                    arr.code.push_back(make_print(ast::PrintType::Str, name));
-                }
-            }
-        } else {
-            // int print
-            if (auto *expr = std::get_if<std::shared_ptr<ast::ASTNode>>(&p->value)) {
-                auto name = exec_expr(*expr);
-                arr.append(make_print(ast::PrintType::Int, name));
-            }
-        }
-    }
-
-    void ir::IntermediateCodeGen::exec_declaration(const ast::Declaration *d) {
-        for (const auto &i: d->identifiers)
-            identifiers[i.value] = d->declaration_type.value;
-
-        // Handle initialization for single-variable declaration
-        if (d->init_expr) {
-            if (d->identifiers.size() != 1)
-                throw std::runtime_error("Init only allowed for single variable declaration");
-
-            auto varname = d->identifiers[0].value;
-            auto right = exec_expr(d->init_expr);
-            arr.append(make_assign(varname, right, "", ""));
-
-        }
-    }
-
-    template<typename T>
-    void ir::IntermediateCodeGen::exec_statement_node(const T &) {
-        // no-op
-    }
-
-    void ir::IntermediateCodeGen::exec_statement_node(const ast::Statement &st) {
-        exec_statement(st.left);
-        exec_statement(st.right);
-    }
-
-    void ir::IntermediateCodeGen::exec_statement_node(const ast::IfStatement &is) {
-        exec_if(&is);
-    }
-
-    void ir::IntermediateCodeGen::exec_statement_node(const ast::WhileStatement &wh) {
-        exec_while(&wh);
-    }
-
-    void ir::IntermediateCodeGen::exec_statement_node(const ast::PrintStatement &pr) {
-        exec_print(&pr);
-    }
-
-    void ir::IntermediateCodeGen::exec_statement_node(const ast::Declaration &de) {
-        exec_declaration(&de);
-    }
-
-    void ir::IntermediateCodeGen::exec_statement_node(const ast::Assignment &asg) {
-        exec_assignment(&asg);
-    }
-
-    void ir::IntermediateCodeGen::exec_statement(const std::shared_ptr<ast::ASTNode> &n) {
-        if (!n) {
-            return;
-        }
-
-        std::visit(
-                [&](const auto &node) {
-                    exec_statement_node(node);
-                },
-                *n
-        );
-    }
-
-} // namespace pseu
+#include "ir.hpp"
+#include "session.hpp"
+#include <chrono>
+#include <stdexcept>
+#include <string_view>
+
+namespace pseu {
+    using namespace std::literals;
+
+    /**
+     * @brief Per-thread interning pool for IR instructions.
+     *
+     * <p>
+     * In this design, all IR nodes are treated as <b>pure data objects</b>:
+     * they have value semantics, immutable identity, and are fully defined
+     * by their structural contents. This makes them suitable for
+     * hash-based deduplication.
+     * </p>
+     *
+     * <p>
+     * IR instructions are wrapped in <code>std::variant</code> and stored
+     * inside a <code>jh::conc::flat_pool</code>, forming an arena-like
+     * contiguous storage domain that reduces allocation fragmentation
+     * while enabling structural deduplication.
+     * </p>
+     *
+     * <p>
+     * The pool capacity may grow as IR complexity increases. No explicit
+     * <code>resize_pool()</code> or shrinking is performed here:
+     * </p>
+     * <ul>
+     *   <li>growth implies a legitimate workload shape,</li>
+     *   <li>there is no benefit in reclaiming memory mid-compilation,</li>
+     *   <li>a one-shot compilation runs once and exits.</li>
+     * </ul>
+     *
+     * <p>
+     * Long-running drivers (the interactive loop, <code>--watch</code>,
+     * batch workers and the compile server) compile in a
+     * session::CompilationSession instead, whose pool is bound with
+     * PoolScope and trimmed to a budget between compilations.
+     * </p>
+     *
+     * <p>
+     * Each thread has its own pool, so parallel compilations (<code>-j</code>)
+     * never contend on it. A compilation runs on one thread from IR
+     * generation to code generation, so instructions never cross pools.
+     * </p>
+     */
+    thread_local ir::ir_pool_t pool{};
+
+    namespace {
+        /// @brief Pool of the innermost PoolScope of this thread, if any.
+        thread_local ir::ir_pool_t *scoped = nullptr;
+
+        ir::ir_pool_t &current() noexcept {
+            return scoped ? *scoped : pool;
+        }
+
+        /// @brief Per-thread counters of count_pool().
+        struct Counting final {
+            bool on = false;
+            ir::PoolStats stats;
+            std::uint64_t sink = 0; // keeps the extra hash alive
+        };
+
+        thread_local Counting counting;
+
+        ir::ir_pool_t::ptr intern_counted(ir::IRInstr instr) {
+            using clock = std::chrono::steady_clock;
+            auto &s = counting.stats;
+
+            const auto t0 = clock::now();
+            if constexpr (!PSEU_IR_ARENA)
+                counting.sink ^= ir::IRInstrHash{}(instr);
+            const auto t1 = clock::now();
+            auto &target = current();
+            const auto before = target.size();
+            auto p = target.acquire(std::move(instr));
+            const auto t2 = clock::now();
+
+            ++s.interned;
+            if (target.size() == before)
+                ++s.dedup_hits;
+            s.hash_seconds += std::chrono::duration<double>(t1 - t0).count();
+            s.intern_seconds += std::chrono::duration<double>(t2 - t1).count();
+            return p;
+        }
+    }
+
+    ir::ir_pool_t::ptr ir::intern(IRInstr instr) {
+        if (counting.on) [[unlikely]]
+            return intern_counted(std::move(instr));
+        return current().acquire(std::move(instr));
+    }
+
+    ir::PoolScope::PoolScope(ir_pool_t &pool) noexcept: previous_(scoped) {
+        scoped = &pool;
+    }
+
+    ir::PoolScope::~PoolScope() {
+        scoped = previous_;
+    }
+
+    void ir::count_pool(bool on) noexcept {
+        if (on)
+            counting.stats = {};
+        counting.on = on;
+    }
+
+    ir::PoolStats ir::pool_stats() noexcept {
+        auto s = counting.stats;
+        s.capacity = current().capacity();
+        s.live = current().size();
+        return s;
+    }
+
+    ir::InstrArena::ptr ir::InstrArena::acquire(IRInstr instr) {
+        if (used_ == capacity())
+            chunks_.push_back(std::make_unique_for_overwrite<Slot[]>(chunk_size));
+        auto &slot = chunks_[used_ / chunk_size][used_ % chunk_size];
+        const auto *p = std::construct_at(reinterpret_cast<IRInstr *>(slot.bytes), std::move(instr));
+        ++used_;
+        return {this, p};
+    }
+
+    void ir::InstrArena::resize_pool() {
+        const auto needed = (used_ + chunk_size - 1) / chunk_size;
+        chunks_.resize(live_ ? needed : 0);
+        chunks_.shrink_to_fit();
+    }
+
+    static ir::ir_pool_t::ptr
+    make_assign(ir::Operand v,
+                ir::Operand l,
+                ir::BinOp op,
+                ir::Operand r) {
+        return ir::intern(ir::IRInstr{
+                ir::AssignmentCode{v, l, op, r}}
+        );
+    }
+
+    static ir::ir_pool_t::ptr
+    make_jump(ir::LabelId d) {
+        return ir::intern(ir::IRInstr{
+                ir::JumpCode{d}}
+        );
+    }
+
+    static ir::ir_pool_t::ptr
+    make_label(ir::LabelId l) {
+        return ir::intern(ir::IRInstr{
+                ir::LabelCode{l}}
+        );
+    }
+
+    static ir::ir_pool_t::ptr
+    make_compare(ir::Operand l,
+                 ir::CmpOp op,
+                 ir::Operand r,
+                 ir::LabelId j) {
+        return ir::intern(ir::IRInstr{
+                ir::CompareCodeIR{l, op, r, j}}
+        );
+    }
+
+    static ir::ir_pool_t::ptr
+    make_print(ast::PrintType t,
+               ir::Operand v) {
+        return ir::intern(ir::IRInstr{
+                ir::PrintCodeIR{t, v}}
+        );
+    }
+
+    /// @brief Map an interned arithmetic operator to its opcode.
+    static ir::BinOp to_bin_op(sym::SymbolId op) {
+        switch (op) {
+            case sym::known::plus:
+                return ir::BinOp::Add;
+            case sym::known::minus:
+                return ir::BinOp::Sub;
+            case sym::known::star:
+                return ir::BinOp::Mul;
+            case sym::known::slash:
+                return ir::BinOp::Div;
+            default:
+                throw std::runtime_error("Unknown arithmetic operator: " + std::string(sym::view(op)));
+        }
+    }
+
+    /// @brief Map an interned comparison operator to its opcode.
+    static ir::CmpOp to_cmp_op(sym::SymbolId op) {
+        switch (op) {
+            case sym::known::eq:
+                return ir::CmpOp::Eq;
+            case sym::known::ne:
+                return ir::CmpOp::Ne;
+            case sym::known::lt:
+                return ir::CmpOp::Lt;
+            case sym::known::le:
+                return ir::CmpOp::Le;
+            case sym::known::gt:
+                return ir::CmpOp::Gt;
+            case sym::known::ge:
+                return ir::CmpOp::Ge;
+            default:
+                throw std::runtime_error("Unknown comparison operator: " + std::string(sym::view(op)));
+        }
+    }
+
+    std::string_view ir::spelling(BinOp op) noexcept {
+        constexpr std::string_view names[] = {"", "+", "-", "*", "/"};
+        return names[static_cast<std::uint8_t>(op)];
+    }
+
+    std::string_view ir::spelling(CmpOp op) noexcept {
+        constexpr std::string_view names[] = {"==", "!=", "<", "<=", ">", ">="};
+        return names[static_cast<std::uint8_t>(op)];
+    }
+
+    std::string ir::to_string(const Operand &o, const GeneratedIR &ir) {
+        switch (o.kind) {
+            case OperandKind::Var:
+                return std::string(sym::view(ir.variables[o.index()].name));
+            case OperandKind::Temp:
+                return "T" + std::to_string(o.value);
+            case OperandKind::Imm:
+                return std::to_string(o.value);
+            case OperandKind::Str:
+                return "S" + std::to_string(o.value);
+            case OperandKind::None:
+                break;
+        }
+        return {};
+    }
+
+    std::string ir::to_string(const IRInstr &instr, const GeneratedIR &ir) {
+        const auto str = [&](const Operand &o) { return to_string(o, ir); };
+
+        return std::visit([&](const auto &in) -> std::string {
+            using T = std::decay_t<decltype(in)>;
+
+            if constexpr (std::is_same_v<T, AssignmentCode>) {
+                auto s = str(in.var) + " = " + str(in.left);
+                if (in.op != BinOp::None)
+                    s += " " + std::string(spelling(in.op)) + " " + str(in.right);
+                return s;
+            } else if constexpr (std::is_same_v<T, JumpCode>) {
+                return "jump L" + std::to_string(in.dist);
+            } else if constexpr (std::is_same_v<T, LabelCode>) {
+                return "L" + std::to_string(in.label) + ":";
+            } else if constexpr (std::is_same_v<T, CompareCodeIR>) {
+                return "if " + str(in.left) + " " + std::string(spelling(in.operation)) + " "
+                       + str(in.right) + " goto L" + std::to_string(in.jump);
+            } else {
+                return std::string("print(") + (in.type == ast::PrintType::Int ? "int" : "string")
+                       + ", " + str(in.value) + ")";
+            }
+        }, instr);
+    }
+
+    ir::IntermediateCodeGen::IntermediateCodeGen(const ast::AstArena &tree, ast::NodeId root)
+            : tree(&tree) {
+        exec_statement(root);
+    }
+
+    ir::IntermediateCodeGen::IntermediateCodeGen(session::CompilationSession &session, ast::NodeId root)
+            : tree(&session.ast()) {
+        // generate in the session's vectors, keeping their capacity
+        auto &out = session.ir();
+        arr.code.swap(out.code.code);
+        variables.swap(out.variables);
+        constants.swap(out.constants);
+        arr.code.clear();
+        variables.clear();
+        constants.clear();
+
+        const PoolScope scope(session.pool());
+        exec_statement(root);
+
+        out.code.code.swap(arr.code);
+        out.variables.swap(variables);
+        out.constants.swap(constants);
+        out.temps = tCounter - 1;
+        tree = nullptr;
+    }
+
+    ir::GeneratedIR ir::IntermediateCodeGen::get() {
+        return GeneratedIR{arr, variables, constants, tCounter - 1};
+    }
+
+    void ir::IntermediateCodeGen::append(const ast::AstArena &t, ast::NodeId root) {
+        resumable = true;
+        tree = &t;
+        for (const auto s: t.children(t.get<ast::StatementList>(root).statements)) {
+            exec_statement(s);
+            checkpoints.push_back({arr.code.size(), variables.size(), constants.size(), retyped.size(),
+                                   tCounter, lCounter});
+        }
+        tree = nullptr;
+    }
+
+    void ir::IntermediateCodeGen::rewind(std::size_t statements) {
+        if (statements >= checkpoints.size())
+            return;
+        const auto c = statements ? checkpoints[statements - 1] : Checkpoint{};
+
+        // undo retyping of the variables that stay, newest first
+        for (auto i = retyped.size(); i-- > c.retyped;)
+            if (retyped[i].first < c.variables)
+                variables[retyped[i].first].type = retyped[i].second;
+        retyped.resize(c.retyped);
+
+        for (auto i = c.variables; i < variables.size(); ++i)
+            slots.erase(variables[i].name);
+        variables.resize(c.variables);
+        arr.code.erase(arr.code.begin() + static_cast<std::ptrdiff_t>(c.code), arr.code.end());
+        constants.resize(c.constants);
+        tCounter = c.tCounter;
+        lCounter = c.lCounter;
+        checkpoints.resize(statements);
+    }
+
+    void ir::IntermediateCodeGen::setType(std::uint32_t slot, sym::SymbolId type) {
+        if (resumable && variables[slot].type != type)
+            retyped.emplace_back(slot, variables[slot].type);
+        variables[slot].type = type;
+    }
+
+    ir::Operand ir::IntermediateCodeGen::nextTemp() { return Operand::temp(tCounter++); }
+
+    ir::LabelId ir::IntermediateCodeGen::nextLabel() { return lCounter++; }
+
+    [[maybe_unused]] ir::LabelId ir::IntermediateCodeGen::currentLabel() const { return lCounter; }
+
+    ir::Operand ir::IntermediateCodeGen::addString(sym::SymbolId text) {
+        constants.push_back(text);
+        return Operand::str(static_cast<std::uint32_t>(constants.size()));
+    }
+
+    std::uint32_t ir::IntermediateCodeGen::slotOf(sym::SymbolId name) {
+        auto [it, inserted] = slots.try_emplace(name, static_cast<std::uint32_t>(variables.size()));
+        if (inserted)
+            variables.push_back(Variable{name, sym::known::empty});
+        return it->second;
+    }
+
+    template<typename T>
+    ir::Operand ir::IntermediateCodeGen::exec_expr_node(const T &) {
+        return {};
+    }
+
+    ir::Operand ir::IntermediateCodeGen::exec_expr_node(const ast::IdentifierNode &id) {
+        return Operand::var(slotOf(id.getValue()));
+    }
+
+    ir::Operand ir::IntermediateCodeGen::exec_expr_node(const ast::NumberNode &num) {
+        return Operand::imm(num.getNumber());
+    }
+
+    ir::Operand ir::IntermediateCodeGen::exec_expr_node(const ast::StringLiteralNode &str) {
+        return addString(str.getValue());
+    }
+
+    ir::Operand ir::IntermediateCodeGen::exec_expr_node(const ast::BinOpNode &bin) {
+        auto left = exec_expr(bin.left);
+        auto right = exec_expr(bin.right);
+
+        auto t = nextTemp();
+        arr.append(make_assign(t, left, to_bin_op(bin.op_tok.value), right));
+        return t;
+    }
+
+    ir::Operand ir::IntermediateCodeGen::exec_expr(ast::NodeId n) {
+        return std::visit(
+                [&](const auto &node) -> Operand {
+                    return exec_expr_node(node);
+                },
+                (*tree)[n]
+        );
+    }
+
+    void ir::IntermediateCodeGen::exec_assignment(const ast::Assignment *a) {
+        const auto slot = slotOf(a->identifier.value);
+        if (variables[slot].type == sym::known::empty) {
+            setType(slot, sym::known::kw_string);
+        }
+        auto right = exec_expr(a->expression);
+        arr.append(make_assign(Operand::var(slot), right, BinOp::None, {}));
+    }
+
+    ir::LabelId ir::IntermediateCodeGen::exec_condition(const ast::Condition *c) {
+        auto left = exec_expr(c->left_expression);
+        auto right = exec_expr(c->right_expression);
+
+        // TRUE label should be allocated here
+        auto trueLabel = nextLabel();
+
+        arr.append(make_compare(left, to_cmp_op(c->comparison.value), right, trueLabel));
+
+        return trueLabel;
+    }
+
+    void ir::IntermediateCodeGen::exec_if(const ast::IfStatement *i) {
+        auto *if_condition = std::get_if<ast::Condition>(&(*tree)[i->if_condition]);
+        auto thenLabel = exec_condition(if_condition);
+        auto elseLabel = nextLabel();
+        auto endLabel = nextLabel();
+
+        // FALSE branch
+        arr.append(make_jump(elseLabel));
+
+        // TRUE branch
+        arr.append(make_label(thenLabel));
+        exec_statement(i->if_body);
+        arr.append(make_jump(endLabel));
+
+        // ELSE branch
+        arr.append(make_label(elseLabel));
+        if (i->else_body != ast::NodeId::null)
+            exec_statement(i->else_body);
+
+        // END
+        arr.append(make_label(endLabel));
+    }
+
+    void ir::IntermediateCodeGen::exec_while(const ast::WhileStatement *w) {
+        auto startLabel = nextLabel();
+        auto bodyLabel = nextLabel();
+        auto endLabel = nextLabel();
+
+        arr.append(make_label(startLabel));
+
+        auto *w_condition = std::get_if<ast::Condition>(&(*tree)[w->condition]);
+        // generate condition — true jumps to bodyLabel
+        auto trueLabel = exec_condition(w_condition);
+
+        // false → end
+        arr.append(make_jump(endLabel));
+
+        // true branch = body
+        arr.append(make_label(trueLabel));
+        exec_statement(w->body);
+
+        // loop back
+        arr.append(make_jump(startLabel));
+
+        // end of while
+        arr.append(make_label(endLabel));
+    }
+
+
+    void ir::IntermediateCodeGen::exec_print(const ast::PrintStatement *p) {
+        if (p->type == ast::PrintType::Str) {
+            if (auto str = std::get_if<sym::SymbolId>(&p->value)) {
+                arr.code.push_back(make_print(ast::PrintType::Str, addString(*str)));
+                return;
+            } else {
+                // variable
+                if (auto *expr = std::get_if<ast::NodeId>(&p->value)) {
+                    auto name = exec_expr(*expr);
+                    // an int variable has no text to print, even if a string was copied into it
+                    if (name.kind == OperandKind::Var && variables[name.index()].type == sym::known::kw_int)
+                        throw std::runtime_error("prints of int variable: " +
+                                                 std::string(sym::view(variables[name.index()].name).substr(1)));
+                    arr.code.push_back(make_print(ast::PrintType::Str, name));
+                }
+            }
+        } else {
+            // int print
+            if (auto *expr = std::get_if<ast::NodeId>(&p->value)) {
+                auto name = exec_expr(*expr);
+                arr.append(make_print(ast::PrintType::Int, name));
+            }
+        }
+    }
+
+    void ir::IntermediateCodeGen::exec_declaration(const ast::Declaration *d) {
+        const auto ids = tree->tokens(d->identifiers);
+        for (const auto &i: ids)
+            setType(slotOf(i.value), d->declaration_type.value);
+
+        // Handle initialization for single-variable declaration
+        if (d->init_expr != ast::NodeId::null) {
+            if (ids.size() != 1)
+                throw std::runtime_error("Init only allowed for single variable declaration");
+
+            auto var = Operand::var(slotOf(ids[0].value));
+            auto right = exec_expr(d->init_expr);
+            arr.append(make_assign(var, right, BinOp::None, {}));
+
+        }
+    }
+
+    template<typename T>
+    void ir::IntermediateCodeGen::exec_statement_node(const T &) {
+        // no-op
+    }
+
+    void ir::IntermediateCodeGen::exec_statement_node(const ast::StatementList &st) {
+        for (const auto s: tree->children(st.statements))
+            exec_statement(s);
+    }
+
+    void ir::IntermediateCodeGen::exec_statement_node(const ast::IfStatement &is) {
+        exec_if(&is);
+    }
+
+    void ir::IntermediateCodeGen::exec_statement_node(const ast::WhileStatement &wh) {
+        exec_while(&wh);
+    }
+
+    void ir::IntermediateCodeGen::exec_statement_node(const ast::PrintStatement &pr) {
+        exec_print(&pr);
+    }
+
+    void ir::IntermediateCodeGen::exec_statement_node(const ast::Declaration &de) {
+        exec_declaration(&de);
+    }
+
+    void ir::IntermediateCodeGen::exec_statement_node(const ast::Assignment &asg) {
+        exec_assignment(&asg);
+    }
+
+    void ir::IntermediateCodeGen::exec_statement(ast::NodeId n) {
+        if (n == ast::NodeId::null) {
+            return;
+        }
+
+        std::visit(
+                [&](const auto &node) {
+                    exec_statement_node(node);
+                },
+                (*tree)[n]
+        );
+    }
+
+} // namespace pseu
@@ -0,0 +1,81 @@
+#include "jit.hpp"
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+#include <utility>
+
+#if defined(__linux__) && defined(__x86_64__)
+#include <sys/mman.h>
+#include <unistd.h>
+#define PSEU_HAS_JIT 1
+#else
+#define PSEU_HAS_JIT 0
+#endif
+
+namespace pseu {
+
+    jit::Program::Program(const x86::Module &m) {
+#if PSEU_HAS_JIT
+        const auto start = m.find("_start");
+        if (start < 0)
+            throw std::runtime_error("No _start symbol");
+
+        const auto page = static_cast<std::size_t>(::sysconf(_SC_PAGESIZE));
+        const auto round = [page](std::size_t n) { return (n + page - 1) / page * page; };
+
+        // [text pages][data][bss], text and data on separate pages for mprotect
+        const std::size_t text_size = round(std::max<std::size_t>(m.text.size(), 1));
+        const std::size_t data_size = (m.data.size() + 15) / 16 * 16;
+        const std::size_t size = text_size + round(data_size + m.bss_size + 1);
+
+        // the destructor does not run if the constructor throws: unmap until the program is complete
+        struct Unmapper {
+            void *p;
+            std::size_t n;
+
+            ~Unmapper() {
+                if (p)
+                    ::munmap(p, n);
+            }
+        } mapping{::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_32BIT, -1, 0),
+                  size};
+        if (mapping.p == MAP_FAILED) {
+            mapping.p = nullptr;
+            throw std::runtime_error("Cannot map memory for in-process execution");
+        }
+
+        auto *bytes = static_cast<std::uint8_t *>(mapping.p);
+        const auto address = reinterpret_cast<std::uintptr_t>(bytes);
+        const x86::Layout layout{address, address + text_size, address + text_size + data_size};
+
+        // data() of an empty vector may be null, which memcpy does not accept even for 0 bytes
+        if (!m.text.empty())
+            std::memcpy(bytes, m.text.data(), m.text.size());
+        if (!m.data.empty())
+            std::memcpy(bytes + text_size, m.data.data(), m.data.size());
+        x86::relocate(m, layout, {bytes, m.text.size()});
+
+        if (::mprotect(mapping.p, text_size, PROT_READ | PROT_EXEC) != 0)
+            throw std::runtime_error("Cannot make generated code executable");
+
+        entry_ = reinterpret_cast<void (*)()>(layout.address(m.symbols[start]));
+        size_ = size;
+        base_ = std::exchange(mapping.p, nullptr);
+#else
+        (void) m;
+        throw std::runtime_error("In-process execution is only supported on x86-64 Linux");
+#endif
+    }
+
+    jit::Program::~Program() {
+#if PSEU_HAS_JIT
+        if (base_)
+            ::munmap(base_, size_);
+#endif
+    }
+
+    void jit::Program::run() const {
+        entry_();
+    }
+
+} // namespace pseu
@@ -1,93 +1,199 @@
+#include <cctype>
+#include <cerrno>
+#include <chrono>
+#include <cstddef>
+#include <atomic>
+#include <cstdint>
+#include <cstdlib>
 #include <fstream>
 #include <iostream>
+#include <mutex>
+#include <optional>
 #include <ranges>
 #include <sstream>
+#include <thread>
+#include <unordered_set>
 #include <vector>
 #include <filesystem>
+#include <jh/meta>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define PSEU_HAS_MMAP 1
+#else
+#define PSEU_HAS_MMAP 0
+#endif
 
 #include "ast.hpp"
+#include "cache.hpp"
+#include "cfg.hpp"
 #include "ir.hpp"
 #include "codegen.hpp"
+#include "frontend.hpp"
+#include "incremental.hpp"
+#include "interp.hpp"
+#include "jit.hpp"
+#include "pipeline.hpp"
+#include "report.hpp"
+#include "server.hpp"
+#include "session.hpp"
+#include "tasks.hpp"
+#include "watch.hpp"
+
+/// @brief Counting replacement of the global allocation function, active while a <code>--time-report</code> is recorded.
+void *operator new(std::size_t size) {
+    auto &a = pseu::report::allocations();
+    if (a.enabled.load(std::memory_order_relaxed)) {
+        a.count.fetch_add(1, std::memory_order_relaxed);
+        a.bytes.fetch_add(size, std::memory_order_relaxed);
+    }
+    if (void *p = std::malloc(size ? size : 1))
+        return p;
+    throw std::bad_alloc();
+}
+
+// kept out of line: GCC flags a free() inlined next to a builtin new as a mismatch
+[[gnu::noinline]] void operator delete(void *p) noexcept {
+    std::free(p);
+}
 
-/**
- * @brief Opaque Flex buffer handle type.
- *
- * This type represents an internal Flex-managed buffer
- * created by <code>yy_scan_string</code>.
- */
-struct yy_buffer_state;
-using YYBufferState = yy_buffer_state *;
-
-/**
- * @brief Create a Flex buffer from an in-memory string.
- *
- * The returned buffer must be released using
- * <code>yy_delete_buffer</code>.
- *
- * @param str Null-terminated input string.
- * @return Newly created Flex buffer.
- */
-YYBufferState yy_scan_string(const char *str);
-
-/**
- * @brief Destroy a Flex buffer previously created by Flex.
- *
- * @param b Buffer to destroy.
- */
-void yy_delete_buffer(YYBufferState b);
-
-/**
- * @brief Invoke the Bison-generated parser.
- *
- * On success, the global AST root will be populated.
- *
- * @return 0 on success, non-zero on parse error.
- */
-int yyparse();
-
-/**
- * @brief Global AST root produced by the parser.
- *
- * This pointer is owned by the parsing phase and
- * consumed by later compilation stages.
- */
-extern std::shared_ptr<pseu::ast::ASTNode> g_ast_root;
+[[gnu::noinline]] void operator delete(void *p, std::size_t) noexcept {
+    std::free(p);
+}
 
 namespace detail {
 
     /**
-     * @brief RAII wrapper for Flex string buffers.
+     * @brief Private, writable copy-on-write mapping of a source file,
+     *        lexed in place.
      *
-     * This class ensures that a Flex buffer created by
-     * <code>yy_scan_string</code> is always released via
-     * <code>yy_delete_buffer</code>, even in the presence
-     * of exceptions.
+     * The file is mapped privately over an anonymous reservation that is
+     * at least two bytes longer than the file, so the bytes following the
+     * contents are guaranteed to read as <code>'&bsol;0'</code> even when
+     * the file size is a multiple of the page size. This satisfies the
+     * padding contract of <code>pseu::frontend::parse_in_place</code> and lets Flex lex
+     * straight out of the page cache, without the stream, string and
+     * <code>yy_scan_string</code> copies of the default path.
      *
-     * Copy is disabled to preserve single ownership.
-     * Move is allowed to support scoped transfer.
+     * The mapping is writable (<code>PROT_WRITE</code>, <code>MAP_PRIVATE</code>)
+     * because Flex temporarily patches NULs into the buffer; a written
+     * page becomes a private copy, so the file itself is never modified.
      */
-    class FlexBuffer {
+    class MappedSource {
     public:
-        explicit FlexBuffer(const std::string &input)
-                : buf_(yy_scan_string(input.c_str())) {}
+        explicit MappedSource(const std::string &path) {
+#if PSEU_HAS_MMAP
+            const int fd = ::open(path.c_str(), O_RDONLY);
+            if (fd < 0)
+                throw std::runtime_error("Cannot open " + path);
+
+            struct stat st{};
+            if (::fstat(fd, &st) != 0) {
+                ::close(fd);
+                throw std::runtime_error("Cannot stat " + path);
+            }
 
-        FlexBuffer(const FlexBuffer &) = delete;
+            size_ = static_cast<std::size_t>(st.st_size);
+            const auto page = static_cast<std::size_t>(::sysconf(_SC_PAGESIZE));
+            mapped_ = (size_ + 2 + page - 1) / page * page;
 
-        FlexBuffer &operator=(const FlexBuffer &) = delete;
+            void *base = ::mmap(nullptr, mapped_, PROT_READ | PROT_WRITE,
+                                MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+            if (base == MAP_FAILED) {
+                ::close(fd);
+                throw std::runtime_error("Cannot reserve mapping for " + path);
+            }
+
+            if (size_ != 0 &&
+                ::mmap(base, size_, PROT_READ | PROT_WRITE,
+                       MAP_PRIVATE | MAP_FIXED, fd, 0) == MAP_FAILED) {
+                ::munmap(base, mapped_);
+                ::close(fd);
+                throw std::runtime_error("Cannot map " + path);
+            }
 
-        FlexBuffer(FlexBuffer &&other) noexcept: buf_(other.buf_) {
-            other.buf_ = nullptr;
+            ::close(fd);
+            base_ = static_cast<char *>(base);
+#else
+            throw std::runtime_error("Mapped input is not supported on this platform: " + path);
+#endif
         }
 
-        ~FlexBuffer() {
-            if (buf_)
-                yy_delete_buffer(buf_);
+        MappedSource(const MappedSource &) = delete;
+
+        MappedSource &operator=(const MappedSource &) = delete;
+
+        ~MappedSource() {
+#if PSEU_HAS_MMAP
+            if (base_)
+                ::munmap(base_, mapped_);
+#endif
         }
 
+        /// @brief Start of the padded region handed to Flex.
+        [[nodiscard]] char *data() const noexcept { return base_; }
+
+        /// @brief Source size in bytes, excluding padding.
+        [[nodiscard]] std::size_t size() const noexcept { return size_; }
+
+        /// @brief Size of the region handed to Flex (source + two NULs).
+        [[nodiscard]] std::size_t padded_size() const noexcept { return size_ + 2; }
+
     private:
-        YYBufferState buf_;
+        char *base_ = nullptr;
+        std::size_t size_ = 0;
+        std::size_t mapped_ = 0;
     };
 
+    /**
+     * @brief Print load-phase throughput to <code>stderr</code>.
+     *
+     * For mapped input this measures only the mapping itself; page
+     * faults are paid lazily while lexing.
+     */
+    static void report_load(std::string_view mode, std::size_t bytes,
+                            std::chrono::steady_clock::duration elapsed) {
+        const double secs = std::chrono::duration<double>(elapsed).count();
+        const double rate = secs > 0 ? static_cast<double>(bytes) / secs : 0.0;
+        std::cerr << "load (" << mode << "): " << bytes << " bytes in "
+                  << std::chrono::duration_cast<std::chrono::microseconds>(elapsed).count()
+                  << " us, " << static_cast<std::uint64_t>(rate) << " bytes/sec\n";
+    }
+
+    /**
+     * @brief Report <code>--run</code> timings on stderr.
+     *
+     * @param ready   From the start of loading the source to the jump into
+     *                the generated code: the latency before the program can
+     *                produce its first output.
+     * @param elapsed Run time of the generated code.
+     */
+    static void report_run(std::chrono::steady_clock::duration ready,
+                           std::chrono::steady_clock::duration elapsed) {
+        using std::chrono::microseconds, std::chrono::duration_cast;
+        std::cerr << "run: compile-to-entry " << duration_cast<microseconds>(ready).count()
+                  << " us, run " << duration_cast<microseconds>(elapsed).count() << " us\n";
+    }
+
+    /// @brief Report the statements regenerated by an <code>--incremental</code> compilation on stderr.
+    static void report_incremental(const pseu::incremental::Stats &s) {
+        std::cerr << "incremental: reused " << s.reused << " of " << s.statements << " statements\n";
+    }
+
+    /// @brief Report <code>--ir-stats</code> of one IR generation on stderr.
+    static void report_ir_stats(const pseu::ir::PoolStats &s) {
+        const auto hit_rate = s.interned
+                              ? 100.0 * static_cast<double>(s.dedup_hits) / static_cast<double>(s.interned)
+                              : 0.0;
+        std::cerr << "ir-stats: backend " << pseu::ir::pool_backend << ", capacity " << s.capacity
+                  << ", live " << s.live << ", interned " << s.interned << ", dedup hits " << s.dedup_hits
+                  << " (" << hit_rate << "%), hash " << s.hash_seconds * 1e6 << " us, intern "
+                  << s.intern_seconds * 1e6 << " us\n";
+    }
+
     /**
      * @brief Stack entry used for non-recursive AST printing.
      *
@@ -95,7 +201,7 @@ namespace detail {
      * textual representation of the AST.
      */
     struct AstStackItem {
-        std::shared_ptr<pseu::ast::ASTNode> node;
+        pseu::ast::NodeId node;
         std::string prefix;
         bool isLast;
     };
@@ -112,23 +218,23 @@ namespace detail {
     }
 
     static void print_ast_node(const pseu::ast::NumberNode &n, std::string_view) {
-        std::cout << "Number: " << n.tok.value << "\n";
+        std::cout << "Number: " << n.getNumber() << "\n";
     }
 
     static void print_ast_node(const pseu::ast::IdentifierNode &n, std::string_view) {
-        std::cout << "Identifier: " << n.tok.value << "\n";
+        std::cout << "Identifier: " << n.tok.text() << "\n";
     }
 
     static void print_ast_node(const pseu::ast::StringLiteralNode &n, std::string_view) {
-        std::cout << "StringLiteral: \"" << n.tok.value << "\"\n";
+        std::cout << "StringLiteral: \"" << n.tok.text() << "\"\n";
     }
 
     static void print_ast_node(const pseu::ast::BinOpNode &n, std::string_view) {
-        std::cout << "BinOp (" << n.op_tok.value << ")\n";
+        std::cout << "BinOp (" << n.op_tok.text() << ")\n";
     }
 
     static void print_ast_node(const pseu::ast::Condition &n, std::string_view) {
-        std::cout << "Condition (" << n.comparison.value << ")\n";
+        std::cout << "Condition (" << n.comparison.text() << ")\n";
     }
 
     static void print_ast_node(const pseu::ast::IfStatement &, std::string_view) {
@@ -146,15 +252,15 @@ namespace detail {
     }
 
     static void print_ast_node(const pseu::ast::Declaration &d, std::string_view) {
-        std::cout << "Declaration (" << d.declaration_type.value << ")\n";
+        std::cout << "Declaration (" << d.declaration_type.text() << ")\n";
     }
 
     static void print_ast_node(const pseu::ast::Assignment &, std::string_view) {
         std::cout << "Assignment\n";
     }
 
-    static void print_ast_node(const pseu::ast::Statement &, std::string_view) {
-        std::cout << "Statement\n";
+    static void print_ast_node(const pseu::ast::StatementList &n, std::string_view) {
+        std::cout << "Statements (" << n.statements.count << ")\n";
     }
 
     /**
@@ -165,60 +271,63 @@ namespace detail {
      *
      * Default implementation collects no children.
      */
+    using NodeIds = std::vector<pseu::ast::NodeId>;
+
     template<typename T>
-    static void collect_children(const T &, std::vector<std::shared_ptr<pseu::ast::ASTNode>> &) {
+    static void collect_children(const T &, const pseu::ast::AstArena &, NodeIds &) {
     }
 
-    static void collect_children(const pseu::ast::BinOpNode &n,
-                                 std::vector<std::shared_ptr<pseu::ast::ASTNode>> &out) {
+    static void collect_children(const pseu::ast::BinOpNode &n, const pseu::ast::AstArena &,
+                                 NodeIds &out) {
         out.emplace_back(n.left);
         out.emplace_back(n.right);
     }
 
-    static void collect_children(const pseu::ast::Condition &n,
-                                 std::vector<std::shared_ptr<pseu::ast::ASTNode>> &out) {
+    static void collect_children(const pseu::ast::Condition &n, const pseu::ast::AstArena &,
+                                 NodeIds &out) {
         out.emplace_back(n.left_expression);
         out.emplace_back(n.right_expression);
     }
 
-    static void collect_children(const pseu::ast::IfStatement &n,
-                                 std::vector<std::shared_ptr<pseu::ast::ASTNode>> &out) {
+    static void collect_children(const pseu::ast::IfStatement &n, const pseu::ast::AstArena &,
+                                 NodeIds &out) {
         out.emplace_back(n.if_condition);
         out.emplace_back(n.if_body);
-        if (n.else_body)
+        if (n.else_body != pseu::ast::NodeId::null)
             out.emplace_back(n.else_body);
     }
 
-    static void collect_children(const pseu::ast::WhileStatement &n,
-                                 std::vector<std::shared_ptr<pseu::ast::ASTNode>> &out) {
+    static void collect_children(const pseu::ast::WhileStatement &n, const pseu::ast::AstArena &,
+                                 NodeIds &out) {
         out.emplace_back(n.condition);
         out.emplace_back(n.body);
     }
 
     static void collect_children(
             const pseu::ast::PrintStatement &n,
-            std::vector<std::shared_ptr<pseu::ast::ASTNode>> &out
+            const pseu::ast::AstArena &,
+            NodeIds &out
     ) {
-        if (auto expr = std::get_if<std::shared_ptr<pseu::ast::ASTNode>>(&n.value)) {
+        if (auto expr = std::get_if<pseu::ast::NodeId>(&n.value)) {
             out.emplace_back(*expr);
         }
     }
 
-    static void collect_children(const pseu::ast::Declaration &n,
-                                 std::vector<std::shared_ptr<pseu::ast::ASTNode>> &out) {
-        if (n.init_expr)
+    static void collect_children(const pseu::ast::Declaration &n, const pseu::ast::AstArena &,
+                                 NodeIds &out) {
+        if (n.init_expr != pseu::ast::NodeId::null)
             out.emplace_back(n.init_expr);
     }
 
-    static void collect_children(const pseu::ast::Assignment &n,
-                                 std::vector<std::shared_ptr<pseu::ast::ASTNode>> &out) {
+    static void collect_children(const pseu::ast::Assignment &n, const pseu::ast::AstArena &,
+                                 NodeIds &out) {
         out.emplace_back(n.expression);
     }
 
-    static void collect_children(const pseu::ast::Statement &n,
-                                 std::vector<std::shared_ptr<pseu::ast::ASTNode>> &out) {
-        if (n.left) out.emplace_back(n.left);
-        if (n.right) out.emplace_back(n.right);
+    static void collect_children(const pseu::ast::StatementList &n, const pseu::ast::AstArena &arena,
+                                 NodeIds &out) {
+        const auto items = arena.children(n.statements);
+        out.insert(out.end(), items.begin(), items.end());
     }
 
     /**
@@ -227,11 +336,12 @@ namespace detail {
      * Traverses the AST without recursion and emits a
      * structured, human-readable tree to <code>stdout</code>.
      *
+     * @param arena Arena holding the AST.
      * @param root Root AST node.
      * @param prefix Optional initial indentation prefix.
      */
-    static void print_ast(const std::shared_ptr<pseu::ast::ASTNode> &root, std::string_view prefix = "") {
-        if (!root)
+    static void print_ast(const pseu::ast::AstArena &arena, pseu::ast::NodeId root, std::string_view prefix = "") {
+        if (root == pseu::ast::NodeId::null)
             return;
 
         std::vector<AstStackItem> stack;
@@ -248,18 +358,18 @@ namespace detail {
                     [&](const auto &n) {
                         print_ast_node(n, cur.prefix);
                     },
-                    *cur.node
+                    arena[cur.node]
             );
 
             std::string child_prefix =
                     cur.prefix + (cur.isLast ? "    " : "│   ");
 
-            std::vector<std::shared_ptr<pseu::ast::ASTNode>> children;
+            NodeIds children;
             std::visit(
                     [&](const auto &n) {
-                        collect_children(n, children);
+                        collect_children(n, arena, children);
                     },
-                    *cur.node
+                    arena[cur.node]
             );
 
             bool first = true;
@@ -275,8 +385,55 @@ namespace detail {
         }
     }
 
+    /**
+     * @brief Print the control-flow graph: blocks with their edges,
+     *        dominator and loop depth, followed by the natural loops.
+     */
+    void print_cfg(const pseu::cfg::CFG &graph, const pseu::ir::GeneratedIR &gen) {
+        const auto block = [](pseu::cfg::BlockId b) {
+            return b == pseu::cfg::no_block ? std::string("-") : "B" + std::to_string(b);
+        };
+        const auto list = [&](const std::vector<pseu::cfg::BlockId> &bs) {
+            std::string s;
+            for (auto b: bs)
+                s += (s.empty() ? "" : " ") + block(b);
+            return "[" + s + "]";
+        };
+
+        for (pseu::cfg::BlockId b = 0; b < graph.size(); ++b) {
+            const auto &blk = graph[b];
+            std::cout << block(b) << ": preds " << list(blk.preds)
+                      << " succs " << list(blk.succs)
+                      << " idom " << block(blk.idom)
+                      << " loop depth " << blk.loop_depth
+                      << (blk.reachable ? "" : " (unreachable)") << "\n";
+            for (auto ins: blk.code) {
+                [[maybe_unused]] auto g = ins.guard();
+                std::cout << "    " << pseu::ir::to_string(*ins, gen) << "\n";
+            }
+        }
+
+        for (std::size_t i = 0; i < graph.loops().size(); ++i) {
+            const auto &l = graph.loops()[i];
+            std::cout << "loop " << i << ": header " << block(l.header)
+                      << " depth " << l.depth
+                      << " parent " << (l.parent == pseu::cfg::no_loop ? std::string("-") : std::to_string(l.parent))
+                      << " blocks " << list(l.blocks) << "\n";
+        }
+    }
+
     namespace fs = std::filesystem;
 
+    /// @brief Output format selected with <code>--emit</code>.
+    using pseu::pipeline::Emit;
+
+    /// @brief Format of the <code>--time-report</code>.
+    enum class ReportFormat : std::uint8_t {
+        None, ///< no report
+        Text, ///< aligned table
+        Json  ///< one JSON object per compilation
+    };
+
     /**
      * @brief Command-line configuration for the compiler frontend.
      *
@@ -288,6 +445,27 @@ namespace detail {
         std::string target_path = "out.asm";
         bool print_ast = false;
         bool print_ir = false;
+        bool print_cfg = false;
+        int opt_level = 0;
+        Emit emit = Emit::Asm;
+        bool run = false;
+        bool interpret = false;
+        bool mmap_input = false;
+        bool load_stats = false;
+        bool ir_stats = false;
+        bool incremental = false;          ///< reuse the IR of unchanged leading statements between runs
+        bool watch = false;                ///< recompile when the source is saved instead of on Enter
+        unsigned watch_debounce = 10;      ///< ms without writes that end a burst of saves
+        std::uint64_t session_budget = 64; ///< MiB a compilation session keeps between compilations
+        std::string cache_dir;             ///< empty: no cache
+        std::uint64_t cache_size = 256;    ///< MiB
+        std::vector<std::string> inputs;   ///< batch mode when not empty
+        std::string out_dir = ".";
+        unsigned jobs = 0;                 ///< 0: one per hardware thread
+        std::string server_socket;         ///< --server: serve compile requests here
+        std::string client_socket;         ///< --client: compile through the server here
+        ReportFormat time_report = ReportFormat::None;
+        std::string time_report_path;      ///< empty: stderr
     };
 
     /**
@@ -320,6 +498,75 @@ namespace detail {
                 cfg.print_ast = true;
             } else if (arg == "--ir") {
                 cfg.print_ir = true;
+            } else if (arg == "--cfg") {
+                cfg.print_cfg = true;
+            } else if (arg.size() == 3 && arg.starts_with("-O") && std::isdigit(static_cast<unsigned char>(arg[2]))) {
+                cfg.opt_level = arg[2] - '0';
+            } else if (arg.starts_with("--emit=")) {
+                const auto kind = arg.substr(7);
+                if (kind == "asm")
+                    cfg.emit = Emit::Asm;
+                else if (kind == "obj")
+                    cfg.emit = Emit::Obj;
+                else if (kind == "exe")
+                    cfg.emit = Emit::Exe;
+                else
+                    throw std::runtime_error("Unknown output format: " + kind);
+            } else if (arg == "--run") {
+                cfg.run = true;
+            } else if (arg == "--interpret") {
+                cfg.interpret = true;
+            } else if (arg == "--mmap") {
+                cfg.mmap_input = true;
+            } else if (arg == "--load-stats") {
+                cfg.load_stats = true;
+            } else if (arg == "--ir-stats") {
+                cfg.ir_stats = true;
+            } else if (arg == "--incremental") {
+                cfg.incremental = true;
+            } else if (arg == "--watch") {
+                cfg.watch = true;
+            } else if (arg.starts_with("--watch=")) {
+                cfg.watch = true;
+                cfg.watch_debounce = static_cast<unsigned>(std::stoul(arg.substr(8)));
+            } else if (arg == "--cache-dir") {
+                if (i + 1 >= argc)
+                    throw std::runtime_error("Missing value for --cache-dir");
+                cfg.cache_dir = argv[++i];
+            } else if (arg == "--session-budget") {
+                if (i + 1 >= argc)
+                    throw std::runtime_error("Missing value for --session-budget");
+                cfg.session_budget = std::stoull(argv[++i]);
+            } else if (arg == "--cache-size") {
+                if (i + 1 >= argc)
+                    throw std::runtime_error("Missing value for --cache-size");
+                cfg.cache_size = std::stoull(argv[++i]);
+            } else if (arg == "-j") {
+                if (i + 1 >= argc)
+                    throw std::runtime_error("Missing value for -j");
+                cfg.jobs = static_cast<unsigned>(std::stoul(argv[++i]));
+            } else if (arg == "-o") {
+                if (i + 1 >= argc)
+                    throw std::runtime_error("Missing value for -o");
+                cfg.out_dir = argv[++i];
+            } else if (arg == "--server") {
+                if (i + 1 >= argc)
+                    throw std::runtime_error("Missing value for --server");
+                cfg.server_socket = argv[++i];
+            } else if (arg == "--client") {
+                if (i + 1 >= argc)
+                    throw std::runtime_error("Missing value for --client");
+                cfg.client_socket = argv[++i];
+            } else if (arg == "--time-report" || arg == "--time-report=text") {
+                cfg.time_report = ReportFormat::Text;
+            } else if (arg == "--time-report=json") {
+                cfg.time_report = ReportFormat::Json;
+            } else if (arg == "--time-report-file") {
+                if (i + 1 >= argc)
+                    throw std::runtime_error("Missing value for --time-report-file");
+                cfg.time_report_path = argv[++i];
+            } else if (!arg.starts_with("-")) {
+                cfg.inputs.push_back(fs::absolute(fs::path(arg)).lexically_normal().string());
             } else {
                 throw std::runtime_error("Unknown argument: " + arg);
             }
@@ -327,10 +574,528 @@ namespace detail {
 
         cfg.src_path = fs::absolute(fs::path(cfg.src_path)).lexically_normal().string();
         cfg.target_path = fs::absolute(fs::path(cfg.target_path)).lexically_normal().string();
+        cfg.out_dir = fs::absolute(fs::path(cfg.out_dir)).lexically_normal().string();
+
+        if (!cfg.time_report_path.empty() && cfg.time_report == ReportFormat::None)
+            cfg.time_report = ReportFormat::Text;
+
+        // everything compile() prints: batch workers would interleave it on stdout and stderr
+        const bool dumps = cfg.print_ast || cfg.print_ir || cfg.print_cfg || cfg.ir_stats ||
+                           cfg.time_report != ReportFormat::None;
+        const bool single = cfg.print_ast || cfg.print_ir || cfg.print_cfg || cfg.run || cfg.interpret;
+        if (!cfg.inputs.empty() && (dumps || single))
+            throw std::runtime_error("--ast, --ir, --cfg, --ir-stats, --time-report, --run and --interpret "
+                                     "take a single -src");
+        if (!cfg.client_socket.empty() && (single || !cfg.inputs.empty()))
+            throw std::runtime_error("--client sends a single -src and only writes the target");
+
+        if ((cfg.time_report != ReportFormat::None || cfg.ir_stats) &&
+            (!cfg.server_socket.empty() || !cfg.client_socket.empty()))
+            throw std::runtime_error("--time-report and --ir-stats measure a single -src compiled in this process");
+        if (cfg.incremental && (cfg.print_ast || (!cfg.inputs.empty() && !cfg.watch) ||
+                                !cfg.server_socket.empty() || !cfg.client_socket.empty()))
+            throw std::runtime_error("--incremental recompiles -src, or the inputs of --watch, in this process, "
+                                     "without --ast");
+        // the kept handles would stop the arena from ever rewinding, so it would grow without bound
+        if (cfg.incremental && PSEU_IR_ARENA)
+            throw std::runtime_error("--incremental needs the pool IR backend: the arena is only reclaimed "
+                                     "when no IR is kept between compilations");
+        if (cfg.watch && (!cfg.server_socket.empty() || !cfg.client_socket.empty()))
+            throw std::runtime_error("--watch recompiles in this process");
 
         return cfg;
     }
 
+    /**
+     * @brief Load a source file with the configured method (<code>--mmap</code> or a stream).
+     *
+     * @throws std::runtime_error if the file cannot be read.
+     */
+    void load(const Config &cfg, const std::string &path, std::optional<MappedSource> &mapped, std::string &input) {
+        if (cfg.mmap_input) {
+            mapped.emplace(path);
+            return;
+        }
+        std::ifstream fin(path);
+        if (!fin)
+            throw std::runtime_error("Cannot open " + path);
+
+        std::stringstream buffer;
+        buffer << fin.rdbuf();
+        input = buffer.str();
+    }
+
+    /**
+     * @brief Whether a compilation only produces the target file, so that a
+     *        cached copy of the file can stand in for it.
+     */
+    bool cacheable(const Config &cfg) {
+        return !cfg.print_ast && !cfg.print_ir && !cfg.print_cfg && !cfg.run && !cfg.interpret;
+    }
+
+    /// @brief Flags that change the target file, as part of the cache key.
+    std::string output_flags(const Config &cfg) {
+        static constexpr std::string_view emit[] = {"asm", "obj", "exe"};
+        return "-O" + std::to_string(cfg.opt_level) + " --emit=" +
+               std::string(emit[static_cast<std::uint8_t>(cfg.emit)]);
+    }
+
+    /// @brief Print the outcome of a cache lookup and the running totals to <code>stderr</code>.
+    void report_cache(const pseu::cache::Cache &cache, bool hit) {
+        const auto s = cache.stats();
+        std::cerr << "cache: " << (hit ? "hit" : "miss") << " (" << s.hits << " hits, " << s.misses
+                  << " misses, " << s.evictions << " evicted)\n";
+    }
+
+    /**
+     * @brief Compile one loaded source as configured: print the requested
+     *        dumps, then write the target or execute the program.
+     *
+     * @param cfg        Configuration.
+     * @param mapped     Mapped source (<code>--mmap</code>), or <code>nullptr</code> to parse <code>input</code>.
+     * @param input      Source text read through a stream.
+     * @param compilation Storage the compilation is done in; reset first.
+     * @param load_begin Start of the load phase, for <code>--run</code> timings.
+     * @param session    State of the previous compilation (<code>--incremental</code>), or <code>nullptr</code>.
+     * @param report     Per-phase measurements (<code>--time-report</code>), or <code>nullptr</code>.
+     *
+     * @throws std::exception on any compile or output error.
+     */
+    void compile(const Config &cfg, pseu::session::CompilationSession &compilation, const MappedSource *mapped,
+                 const std::string &input, std::chrono::steady_clock::time_point load_begin,
+                 pseu::incremental::Session *session = nullptr, pseu::report::TimeReport *report = nullptr) {
+        using pseu::report::timed;
+
+        // instructions of every pass go to the session's pool, symbols to its table
+        // (or, with --incremental, to the table the kept IR refers to)
+        pseu::pipeline::Compilation c(compilation,
+                                      {.opt_level = cfg.interpret ? 0 : cfg.opt_level,
+                                       .runtime = cfg.run ? pseu::codegen::Runtime::Hosted
+                                                          : pseu::codegen::Runtime::Process,
+                                       .cfg = cfg.print_cfg || cfg.opt_level >= 1},
+                                      report, session ? &session->symbols() : nullptr);
+
+        // The scanner is driven by yyparse, so parse includes scanning;
+        // lex is a separate token-counting pass, run only for the report.
+        if (report)
+            report->measure("lex", "tokens", [&] {
+                return pseu::frontend::tokenize(mapped ? std::string_view(mapped->data(), mapped->size()) : input);
+            });
+
+        auto &gen = c.ir();
+        pseu::ir::count_pool(cfg.ir_stats);
+        if (session) {
+            // --incremental: parse and generate from the first changed top-level statement
+            timed(report, "reparse", "statements", [&] {
+                gen = mapped ? session->compile(std::string_view(mapped->data(), mapped->size()), mapped->data(),
+                                                mapped->padded_size())
+                             : session->compile(input);
+                return session->stats().statements - session->stats().reused;
+            });
+            report_incremental(session->stats());
+        } else {
+            const auto ast_root = mapped ? c.parse_in_place(mapped->data(), mapped->padded_size()) : c.parse(input);
+
+            if (cfg.print_ast) {
+                std::cout << "===== AST =====\n";
+                print_ast(compilation.ast(), ast_root);
+            }
+
+            c.generate(ast_root);
+        }
+        if (cfg.ir_stats) {
+            pseu::ir::count_pool(false);
+            report_ir_stats(pseu::ir::pool_stats());
+        }
+
+        if (cfg.print_ir) {
+            std::cout << "\n===== IR =====\n";
+
+            for (auto instr: gen.code.code) {
+                [[maybe_unused]] auto g = instr.guard();
+                std::cout << pseu::ir::to_string(*instr, gen) << "\n";
+            }
+        }
+
+        // CFG, and registers at -O1 and above
+        const auto *graph = c.analyze();
+        if (cfg.print_cfg) {
+            std::cout << "\n===== CFG =====\n";
+            print_cfg(*graph, gen);
+        }
+
+        // --interpret: execute the IR directly, no code generation;
+        // --run: execute in this process, no files written;
+        // --emit=obj|exe: encode and link in process instead of running nasm and ld
+        if (cfg.interpret) {
+            std::optional<pseu::interp::Program> program;
+            timed(report, "decode", "instructions", [&] { return program.emplace(gen).code().size(); });
+            std::cout.flush();
+            timed(report, "execute", "steps", [&] { return program->run(); });
+            return;
+        }
+
+        if (cfg.run) {
+            const auto module = c.encode();
+            std::optional<pseu::jit::Program> program;
+            timed(report, "link", "bytes", [&] {
+                program.emplace(module);
+                return module.text.size() + module.data.size() + module.bss_size;
+            });
+            std::cout.flush();
+            const auto entry = std::chrono::steady_clock::now();
+            timed(report, "execute", "runs", [&] { return (program->run(), 1); });
+            report_run(entry - load_begin, std::chrono::steady_clock::now() - entry);
+        } else {
+            c.write(cfg.emit, cfg.target_path);
+        }
+    }
+
+    /// @brief Write a <code>--time-report</code> to <code>stderr</code>, or append it to <code>--time-report-file</code>.
+    void write_report(const Config &cfg, const pseu::report::TimeReport &report) {
+        const auto write = [&](std::ostream &os) {
+            if (cfg.time_report == ReportFormat::Json)
+                report.write_json(os);
+            else
+                report.write_text(os);
+        };
+        if (cfg.time_report_path.empty())
+            return write(std::cerr);
+
+        std::ofstream f(cfg.time_report_path, std::ios::app);
+        write(f);
+        if (!f)
+            std::cerr << "Cannot write " << cfg.time_report_path << "\n";
+    }
+
+    /**
+     * @brief compile(), or a copy of the target from <code>cache</code> when
+     *        the compilation is cacheable and was seen before.
+     *
+     * @param cache Cache, or <code>nullptr</code>.
+     * @return Whether the target came from the cache.
+     * @throws std::exception as compile().
+     */
+    bool compile_cached(const Config &cfg, pseu::cache::Cache *cache, pseu::session::CompilationSession &compilation,
+                        const MappedSource *mapped, const std::string &input,
+                        std::chrono::steady_clock::time_point load_begin, pseu::incremental::Session *session = nullptr,
+                        pseu::report::TimeReport *report = nullptr) {
+        if (!cache || !cacheable(cfg)) {
+            compile(cfg, compilation, mapped, input, load_begin, session, report);
+            return false;
+        }
+        const auto key = pseu::cache::Cache::key(mapped ? std::string_view(mapped->data(), mapped->size()) : input,
+                                                 output_flags(cfg));
+        bool hit = false;
+        pseu::report::timed(report, "cache", "hits", [&] { return hit = cache->fetch(key, cfg.target_path); });
+        if (hit)
+            return true;
+        compile(cfg, compilation, mapped, input, load_begin, session, report);
+        cache->store(key, cfg.target_path);
+        return false;
+    }
+
+    /**
+     * @brief compile_cached() a loaded source and print its cache and time
+     *        reports, as each run of the interactive loop does.
+     *
+     * Compile errors are printed on <code>stderr</code>. The session is
+     * then reset and trimmed to <code>--session-budget</code>, so that an
+     * idle process holds no more than that.
+     *
+     * @return Whether the source compiled.
+     */
+    bool rebuild(const Config &cfg, pseu::cache::Cache *cache, pseu::session::CompilationSession &compilation,
+                 pseu::incremental::Session *session, pseu::report::TimeReport *report, const MappedSource *mapped,
+                 const std::string &input, std::chrono::steady_clock::time_point load_begin) {
+        // --cache-dir: a hit skips the whole pipeline
+        bool hit = false;
+        bool ok = false;
+        try {
+            hit = compile_cached(cfg, cache, compilation, mapped, input, load_begin, session, report);
+            ok = true;
+        }
+        catch (const std::exception &e) {
+            std::cerr << e.what() << "\n";
+        }
+        compilation.reset();
+        compilation.shrink_to(cfg.session_budget << 20);
+        if (cache && cacheable(cfg))
+            report_cache(*cache, hit);
+        if (report)
+            write_report(cfg, *report);
+        return ok;
+    }
+
+    /// @brief A line of stdin without surrounding blanks, for the <code>q;</code> command.
+    std::string trim(std::string s) {
+        s.erase(0, s.find_first_not_of(" \t\r\n"));
+        s.erase(s.find_last_not_of(" \t\r\n") + 1);
+        return s;
+    }
+
+    /// @brief Worker threads for <code>-j</code>: as given, or one per hardware thread.
+    unsigned job_count(const Config &cfg) {
+        return cfg.jobs ? cfg.jobs : std::max(1u, std::thread::hardware_concurrency());
+    }
+
+    /// @brief Output file of a batch input: its stem in the output directory, with the format's extension.
+    std::string batch_target(const Config &cfg, const std::string &input) {
+        static constexpr std::string_view ext[] = {".asm", ".o", ""};
+        auto name = fs::path(input).stem();
+        name += ext[static_cast<std::uint8_t>(cfg.emit)];
+        return (fs::path(cfg.out_dir) / name).string();
+    }
+
+    /**
+     * @brief Compile every input of <code>cfg.inputs</code> in parallel (<code>-j</code>).
+     *
+     * Each task loads, compiles and writes one file on a worker of a
+     * work-stealing pool; the parser state is per call, and each worker
+     * compiles in its own session::CompilationSession. Errors are reported per file on
+     * <code>stderr</code> under one lock and do not stop the other files; parse_args()
+     * rejects the dumps and reports compile() would print unsynchronized. stdin is never read.
+     *
+     * @return Process exit status: 0 if every file compiled.
+     */
+    int run_batch(const Config &cfg) {
+        const unsigned jobs = job_count(cfg);
+
+        // per-file configuration, without the input list
+        Config base = cfg;
+        base.inputs.clear();
+
+        std::vector<std::string> targets;
+        targets.reserve(cfg.inputs.size());
+        std::unordered_set<std::string> seen;
+        for (const auto &in: cfg.inputs) {
+            targets.push_back(batch_target(cfg, in));
+            if (!seen.insert(targets.back()).second) {
+                std::cerr << "Two inputs write " << targets.back() << "\n";
+                return 1;
+            }
+        }
+
+        // one cache for all workers: one total against the cap, one set of stats
+        std::optional<pseu::cache::Cache> cache;
+        std::vector<pseu::session::CompilationSession> sessions(jobs);
+        try {
+            fs::create_directories(cfg.out_dir);
+            if (!cfg.cache_dir.empty())
+                cache.emplace(cfg.cache_dir, cfg.cache_size << 20);
+        } catch (const std::exception &e) {
+            std::cerr << e.what() << "\n";
+            return 1;
+        }
+
+        std::atomic<std::size_t> failed{0};
+        std::mutex err_mtx;
+        const auto begin = std::chrono::steady_clock::now();
+
+        pseu::tasks::run(cfg.inputs.size(), jobs, [&](std::size_t i, unsigned worker) {
+            Config file = base;
+            file.src_path = cfg.inputs[i];
+            file.target_path = targets[i];
+            try {
+                std::optional<MappedSource> mapped;
+                std::string input;
+                const auto load_begin = std::chrono::steady_clock::now();
+                load(file, file.src_path, mapped, input);
+                compile_cached(file, cache ? &*cache : nullptr, sessions[worker],
+                               mapped ? &*mapped : nullptr, input, load_begin);
+            } catch (const std::exception &e) {
+                failed.fetch_add(1, std::memory_order_relaxed);
+                std::lock_guard lock(err_mtx);
+                std::cerr << file.src_path << ": " << e.what() << "\n";
+            }
+            sessions[worker].reset();
+            sessions[worker].shrink_to(cfg.session_budget << 20);
+        });
+
+        const auto elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+        std::cerr << "batch: " << cfg.inputs.size() << " files, " << failed.load() << " failed, " << jobs
+                  << " jobs, " << static_cast<std::uint64_t>(elapsed * 1e3) << " ms\n";
+        if (cache) {
+            const auto s = cache->stats();
+            std::cerr << "cache: " << s.hits << " hits, " << s.misses << " misses, "
+                      << s.evictions << " evicted\n";
+        }
+        return failed.load() ? 1 : 0;
+    }
+
+    /**
+     * @brief Recompile <code>-src</code>, or each batch input, whenever it is saved (<code>--watch</code>).
+     *
+     * Every file is compiled once, then again each time it is written and
+     * its contents differ from its last build. All compilations run on
+     * the calling thread in one session::CompilationSession, so the IR
+     * pool, the buffers and the cache stay warm between rebuilds; each
+     * file has its own <code>--incremental</code> session, which keeps
+     * the IR of that file's previous build. The
+     * latency of each rebuild, from the load to the written target, goes
+     * to <code>stderr</code>. <code>q;</code> on stdin ends the loop; at end
+     * of input the files are watched until the process is stopped.
+     *
+     * @return Process exit status.
+     */
+    int run_watch(const Config &cfg) {
+        // per-file configuration: -src, or the batch inputs with their targets
+        std::vector<Config> files;
+        if (cfg.inputs.empty()) {
+            files.push_back(cfg);
+        } else {
+            std::unordered_set<std::string> seen;
+            for (const auto &in: cfg.inputs) {
+                auto &file = files.emplace_back(cfg);
+                file.inputs.clear();
+                file.src_path = in;
+                file.target_path = batch_target(cfg, in);
+                if (!seen.insert(file.target_path).second) {
+                    std::cerr << "Two inputs write " << file.target_path << "\n";
+                    return 1;
+                }
+            }
+        }
+
+        std::optional<pseu::cache::Cache> cache;
+        std::optional<pseu::watch::Watcher> watcher;
+        try {
+            if (!cfg.inputs.empty())
+                fs::create_directories(cfg.out_dir);
+            if (!cfg.cache_dir.empty())
+                cache.emplace(cfg.cache_dir, cfg.cache_size << 20);
+            std::vector<std::string> paths;
+            for (const auto &file: files)
+                paths.push_back(file.src_path);
+            watcher.emplace(std::move(paths));
+        } catch (const std::exception &e) {
+            std::cerr << e.what() << "\n";
+            return 1;
+        }
+
+        // declared first: the --incremental sessions keep IR in its pool
+        pseu::session::CompilationSession compilation;
+        // one per file, or each build would rewind the IR of the file built before it
+        std::vector<std::optional<pseu::incremental::Session>> sessions(files.size());
+        if (cfg.incremental)
+            for (auto &session: sessions)
+                session.emplace();
+
+        // FNV-1a of each file at its last build: a save without a change is not rebuilt
+        std::vector<std::uint64_t> built(files.size());
+
+        const auto build = [&](std::size_t i) {
+            const auto &file = files[i];
+            auto &session = sessions[i];
+            std::optional<MappedSource> mapped;
+            std::string input;
+
+            std::optional<pseu::report::TimeReport> report;
+            if (cfg.time_report != ReportFormat::None)
+                report.emplace();
+
+            const auto load_begin = std::chrono::steady_clock::now();
+            try {
+                pseu::report::timed(report ? &*report : nullptr, "load", "bytes", [&] {
+                    load(file, file.src_path, mapped, input);
+                    return mapped ? mapped->size() : input.size();
+                });
+            } catch (const std::exception &e) {
+                // e.g. removed again right after the write
+                std::cerr << e.what() << "\n";
+                return;
+            }
+            const std::string_view source = mapped ? std::string_view(mapped->data(), mapped->size()) : input;
+            const auto hash = jh::meta::fnv1a64(source.data(), source.size());
+            if (hash == built[i])
+                return;
+            built[i] = hash;
+
+            if (cfg.load_stats)
+                report_load(mapped ? "mmap" : "stream", source.size(), std::chrono::steady_clock::now() - load_begin);
+            const bool ok = rebuild(file, cache ? &*cache : nullptr, compilation, session ? &*session : nullptr,
+                                    report ? &*report : nullptr, mapped ? &*mapped : nullptr, input, load_begin);
+            const auto elapsed = std::chrono::steady_clock::now() - load_begin;
+            std::cerr << "watch: " << file.src_path << (ok ? " rebuilt in " : " failed after ")
+                      << std::chrono::duration_cast<std::chrono::microseconds>(elapsed).count() << " us\n";
+            std::cout << "------------------------------" << std::endl;
+        };
+
+        for (std::size_t i = 0; i < files.size(); ++i)
+            build(i);
+
+        // stdin is read with ::read, not std::cin: a buffered stream can take
+        // several lines in one read, and wait() would not wake for the rest
+        int input_fd = 0; // stdin
+        std::string pending;
+        while (true) {
+            const auto wake = watcher->wait(std::chrono::milliseconds(cfg.watch_debounce), input_fd);
+            for (const auto i: wake.changed)
+                build(i);
+            if (!wake.input)
+                continue;
+
+            char chunk[4096];
+            const auto n = ::read(input_fd, chunk, sizeof chunk);
+            if (n < 0 && errno == EINTR)
+                continue;
+            if (n <= 0) {
+                if (trim(pending) == "q;")
+                    return 0;
+                input_fd = -1; // end of input: keep watching
+                continue;
+            }
+            pending.append(chunk, static_cast<std::size_t>(n));
+            for (auto eol = pending.find('\n'); eol != std::string::npos; eol = pending.find('\n')) {
+                if (trim(pending.substr(0, eol)) == "q;")
+                    return 0;
+                pending.erase(0, eol + 1);
+            }
+        }
+    }
+
+    /**
+     * @brief Compile <code>cfg.src_path</code> on a running <code>--server</code>
+     *        and write the returned bytes to the target.
+     *
+     * The round trip is reported on <code>stderr</code>; a compile error is
+     * printed there instead and gives exit status 1.
+     */
+    int run_client(const Config &cfg) {
+        try {
+            std::optional<MappedSource> mapped;
+            std::string input;
+            load(cfg, cfg.src_path, mapped, input);
+
+            const auto begin = std::chrono::steady_clock::now();
+            const auto r = pseu::server::request(
+                    cfg.client_socket, mapped ? std::string_view(mapped->data(), mapped->size()) : input,
+                    cfg.opt_level, static_cast<pseu::server::Format>(cfg.emit));
+            const auto elapsed = std::chrono::steady_clock::now() - begin;
+
+            if (!r.ok) {
+                std::cerr << std::string_view(r.payload.data(), r.payload.size()) << "\n";
+                return 1;
+            }
+            std::ofstream f(cfg.target_path, std::ios::binary | std::ios::trunc);
+            f.write(r.payload.data(), static_cast<std::streamsize>(r.payload.size()));
+            f.close();
+            if (!f)
+                throw std::runtime_error("Cannot write " + cfg.target_path);
+            if (cfg.emit == Emit::Exe)
+                fs::permissions(cfg.target_path,
+                                fs::perms::owner_exec | fs::perms::group_exec | fs::perms::others_exec,
+                                fs::perm_options::add);
+
+            std::cerr << "client: " << r.payload.size() << " bytes in "
+                      << std::chrono::duration_cast<std::chrono::microseconds>(elapsed).count() << " us\n";
+        } catch (const std::exception &e) {
+            std::cerr << e.what() << "\n";
+            return 1;
+        }
+        return 0;
+    }
+
 } // namespace detail
 
 int main(int argc, char **argv) {
@@ -342,87 +1107,70 @@ int main(int argc, char **argv) {
         std::cerr << "Argument error: " << e.what() << "\n";
         return 1;
     }
-    while (true) {
-        std::ifstream fin(cfg.src_path);
-        if (!fin) {
-            std::cerr << "Cannot open " << cfg.src_path << "\n";
+
+    if (!cfg.server_socket.empty()) {
+        try {
+            pseu::server::serve(cfg.server_socket, detail::job_count(cfg));
+        } catch (const std::exception &e) {
+            std::cerr << e.what() << "\n";
             return 1;
         }
-
-        std::stringstream buffer;
-        buffer << fin.rdbuf();
-        std::string input = buffer.str();
-
+    }
+    if (!cfg.client_socket.empty())
+        return detail::run_client(cfg);
+    if (cfg.watch)
+        return detail::run_watch(cfg);
+    if (!cfg.inputs.empty())
+        return detail::run_batch(cfg);
+
+    std::optional<pseu::cache::Cache> cache;
+    if (!cfg.cache_dir.empty()) {
         try {
-            detail::FlexBuffer f_buffer(input);
+            cache.emplace(cfg.cache_dir, cfg.cache_size << 20);
+        } catch (const std::exception &e) {
+            std::cerr << e.what() << "\n";
+            return 1;
+        }
+    }
 
-            if (const int parse_result = yyparse(); parse_result == 0) {
-                if (cfg.print_ast) {
-                    std::cout << "===== AST =====\n";
-                    detail::print_ast(g_ast_root);
-                }
+    // kept across the runs of the loop; the --incremental session keeps IR in the pool of the first
+    pseu::session::CompilationSession compilation;
+    std::optional<pseu::incremental::Session> session;
+    if (cfg.incremental)
+        session.emplace();
 
-                pseu::ir::IntermediateCodeGen irgen(g_ast_root);
-                auto gen = irgen.get();
-
-                if (cfg.print_ir) {
-                    std::cout << "\n===== IR =====\n";
-
-                    for (auto instr: gen.code.code) {
-                        [[maybe_unused]] auto g = instr.guard();
-                        std::visit([&](auto &ir) {
-                            using T = std::decay_t<decltype(ir)>;
-
-                            if constexpr (std::is_same_v<T, pseu::ir::AssignmentCode>) {
-                                std::cout << ir.var << " = " << ir.left;
-                                if (!ir.op.empty())
-                                    std::cout << " " << ir.op << " " << ir.right;
-                                std::cout << "\n";
-                            } else if constexpr (std::is_same_v<T, pseu::ir::JumpCode>) {
-                                std::cout << "jump " << ir.dist << "\n";
-                            } else if constexpr (std::is_same_v<T, pseu::ir::LabelCode>) {
-                                std::cout << ir.label << ":\n";
-                            } else if constexpr (std::is_same_v<T, pseu::ir::CompareCodeIR>) {
-                                std::cout << "if " << ir.left << " "
-                                          << ir.operation << " "
-                                          << ir.right << " goto "
-                                          << ir.jump << "\n";
-                            } else if constexpr (std::is_same_v<T, pseu::ir::PrintCodeIR>) {
-                                std::cout << "print("
-                                          << ((ir.type == pseu::ast::PrintType::Int) ? "int" : "string")
-                                          << ", "
-                                          << ir.value << ")\n";
-                            }
-                        }, *instr);
-                    }
-                }
+    while (true) {
+        std::optional<detail::MappedSource> mapped;
+        std::string input;
 
-                pseu::codegen::CodeGenerator codegen(
-                        gen.code,
-                        gen.identifiers,
-                        gen.constants
-                );
+        // --time-report: one report per compilation
+        std::optional<pseu::report::TimeReport> report;
+        if (cfg.time_report != detail::ReportFormat::None)
+            report.emplace();
 
-                codegen.writeAsm(cfg.target_path);
-            } else {
-                std::cerr << "Parsing failed.\n";
-            }
-        }
-        catch (const std::exception &e) {
+        const auto load_begin = std::chrono::steady_clock::now();
+        try {
+            pseu::report::timed(report ? &*report : nullptr, "load", "bytes", [&] {
+                detail::load(cfg, cfg.src_path, mapped, input);
+                return mapped ? mapped->size() : input.size();
+            });
+        } catch (const std::exception &e) {
             std::cerr << e.what() << "\n";
+            return 1;
         }
+        if (cfg.load_stats)
+            detail::report_load(mapped ? "mmap" : "stream",
+                                mapped ? mapped->size() : input.size(),
+                                std::chrono::steady_clock::now() - load_begin);
+
+        detail::rebuild(cfg, cache ? &*cache : nullptr, compilation, session ? &*session : nullptr,
+                        report ? &*report : nullptr, mapped ? &*mapped : nullptr, input, load_begin);
 
         std::cout << "------------------------------\n";
         std::string dummy;
         std::getline(std::cin, dummy);
 
-        const auto trim = [](std::string s) {
-            s.erase(0, s.find_first_not_of(" \t\r\n"));
-            s.erase(s.find_last_not_of(" \t\r\n") + 1);
-            return s;
-        };
-
-        if (trim(dummy) == "q;")
+        if (detail::trim(dummy) == "q;")
             break;
     }
 }
@@ -7,54 +7,44 @@
 #include "ast.hpp"
 #include "tokens.hpp"
 
-// Forward declare the scanner function (defined in Flex)
-extern int yylex();
-extern int yylineno;
-
-// Forward declare the error function
-void yyerror(const char *s);
-
-// This will hold the final, complete AST
-std::shared_ptr<pseu::ast::ASTNode> g_ast_root;
-
 // default
 template <typename T>
-static int node_line_impl(const T&)
+static int node_line_impl(const T&, int current)
 {
-    return yylineno;
+    return current;
 }
 
-static int node_line_impl(const pseu::ast::NumberNode& num)
+static int node_line_impl(const pseu::ast::NumberNode& num, int)
 {
     return num.tok.line;
 }
 
-static int node_line_impl(const pseu::ast::IdentifierNode& id)
+static int node_line_impl(const pseu::ast::IdentifierNode& id, int)
 {
     return id.tok.line;
 }
 
-static int node_line_impl(const pseu::ast::BinOpNode& bin)
+static int node_line_impl(const pseu::ast::BinOpNode& bin, int)
 {
     return bin.op_tok.line;
 }
 
-static int node_line_impl(const pseu::ast::Assignment& assign)
+static int node_line_impl(const pseu::ast::Assignment& assign, int)
 {
     return assign.identifier.line;
 }
 
 
-static int node_line(const std::shared_ptr<pseu::ast::ASTNode>& node)
+static int node_line(const pseu::ast::AstArena& arena, pseu::ast::NodeId node, int current)
 {
-    if (!node)
-        return yylineno;
+    if (node == pseu::ast::NodeId::null)
+        return current;
 
     return std::visit(
         [&](const auto& n) -> int {
-            return node_line_impl(n);
+            return node_line_impl(n, current);
         },
-        *node
+        arena[node]
     );
 }
 
@@ -63,35 +53,61 @@ static int node_line(const std::shared_ptr<pseu::ast::ASTNode>& node)
 
 /* 2. BISON DECLARATIONS */
 
-// The %union defines all possible data types that can be
-// associated with a token (terminal) or a grammar rule (non-terminal).
+// C++ LALR(1) parser with typed, move-only semantic values.
+// Each symbol carries exactly its own value type inside a variant,
+// so shifts and reductions move values instead of copying a fat
+// struct, and list-building rules can append in place.
+%require "3.2"
+%language "c++"
+%skeleton "lalr1.cc"
+
+%define api.namespace {pseu::parser}
+%define api.parser.class {Parser}
+%define api.value.type variant
+%define api.token.constructor
+
 %code requires {
-    #include <memory>
+    #include <cstddef>
     #include <vector>
     #include "ast.hpp"
+    #include "frontend.hpp"
     #include "tokens.hpp"
 
-    struct SemanticValue {
-        std::shared_ptr<pseu::ast::ASTNode> node;
-        std::vector<pseu::lexer::Token> token_list;
-        pseu::lexer::Token token;
-    };
+    #ifndef YY_TYPEDEF_YY_SCANNER_T
+    #define YY_TYPEDEF_YY_SCANNER_T
+    typedef void *yyscan_t;
+    #endif
 }
 
-%define api.value.type {SemanticValue}
+%code {
+    // Forward declare the reentrant scanner function (defined in Flex via YY_DECL)
+    pseu::parser::Parser::symbol_type yylex(yyscan_t scanner);
+}
+
+// Reentrant parser: all parse state lives in ParseContext and
+// the Flex scanner handle, so independent parses can run concurrently.
+%parse-param {pseu::frontend::ParseContext &ctx}
+%param {yyscan_t scanner}
 
-// Tokens that carry additional data use yylval.token from the scanner.
-%token T_INTLIT T_VAR T_COMPARISON T_STRING
+// Tokens that carry additional data receive a Token from the scanner.
+%token <pseu::lexer::Token> T_INTLIT T_VAR T_COMPARISON T_STRING
 
 // Define simple tokens (keywords, punctuation) that don't carry data
 %token T_IF T_ELSE T_WHILE T_INT T_STRINGKW T_PRINT T_PRINTS
 %token T_ASSIGN
 %token T_LPAREN T_RPAREN T_LBRACE T_RBRACE T_SEMICOLON T_END
+%token T_PLUS "+" T_MINUS "-" T_STAR "*" T_SLASH "/" T_COMMA ","
+
+// Semantic value of each nonterminal.
+%type <std::size_t> statements   // open statement list handle (AstArena::open_list)
+%type <pseu::ast::NodeId> statement expr term factor assignment if_statement condition
+%type <pseu::ast::NodeId> while_statement printing declarations
+%type <std::vector<pseu::lexer::Token>> identifier_list
 
 // Define operator precedence (lowest to highest) and associativity.
 %left T_COMPARISON
-%left '+' '-'
-%left '*' '/'
+%left "+" "-"
+%left "*" "/"
 
 // The top-level rule to start parsing
 %start program
@@ -104,39 +120,39 @@ static int node_line(const std::shared_ptr<pseu::ast::ASTNode>& node)
 program
     : statements T_END
     {
-        g_ast_root = $1.node; // Save the completed AST
+        ctx.root = ctx.arena.close_list($1); // Save the completed AST
     }
     | statements
     {
-        g_ast_root = $1.node; // Save the completed AST (EOF case)
+        ctx.root = ctx.arena.close_list($1); // Save the completed AST (EOF case)
     }
     ;
 
 // This rule translates your `statements()` logic [cite: 2]
 statements
-    : /* empty */
+    : %empty
     {
-        $$.node = nullptr; // Base case: no statements
+        // Base case: open an empty list that later statements are appended to.
+        // It is committed to the arena by the rule that encloses the block.
+        $$ = ctx.arena.open_list();
     }
     | statements statement
     {
-        auto st = std::make_shared<pseu::ast::ASTNode>(pseu::ast::Statement{});
-        auto& stmt = std::get<pseu::ast::Statement>(*st);
-        stmt.left  = $1.node; // The previous statements
-        stmt.right = $2.node; // The new statement
-        $$.node = st;        // Pass the combined list up
+        // Append in place: the list stays flat however long the program is
+        ctx.arena.append($1, $2);
+        $$ = $1;
     }
     ;
 
 statement
-    : if_statement    { $$.node = $1.node; }
-    | while_statement { $$.node = $1.node; }
-    | declarations    { $$.node = $1.node; }
-    | assignment      { $$.node = $1.node; }
-    | printing        { $$.node = $1.node; }
+    : if_statement    { $$ = $1; }
+    | while_statement { $$ = $1; }
+    | declarations    { $$ = $1; }
+    | assignment      { $$ = $1; }
+    | printing        { $$ = $1; }
     | T_LBRACE statements T_RBRACE // For nested blocks
     {
-        $$.node = $2.node;
+        $$ = ctx.arena.close_list($2);
     }
     ;
 
@@ -146,53 +162,47 @@ statement
 expr
     : term
     {
-        $$.node = $1.node;
+        $$ = $1;
     }
-    | expr '+' term  // $1 is 'expr', $2 is '+', $3 is 'term'
+    | expr "+" term  // $1 is 'expr', $2 is '+', $3 is 'term'
     {
-        auto bin = std::make_shared<pseu::ast::ASTNode>(pseu::ast::BinOpNode{});
-
-        auto& b = std::get<pseu::ast::BinOpNode>(*bin);
-        b.left  = $1.node;
-        b.op_tok = pseu::lexer::Token{pseu::lexer::TokenType::Arth, "+", node_line($1.node)};
-        b.right = $3.node;
-
-        $$.node = bin;
+        pseu::ast::BinOpNode b;
+        b.left  = $1;
+        b.op_tok = pseu::lexer::Token{pseu::lexer::TokenType::Arth, pseu::sym::known::plus, 0, node_line(ctx.arena, $1, ctx.line)};
+        b.right = $3;
+        $$ = ctx.arena.make(b);
     }
-    | expr '-' term
+    | expr "-" term
     {
-        auto bin = std::make_shared<pseu::ast::ASTNode>(pseu::ast::BinOpNode{});
-        auto& b = std::get<pseu::ast::BinOpNode>(*bin);
-        b.left = $1.node;
-        b.op_tok = pseu::lexer::Token{pseu::lexer::TokenType::Arth, "-", node_line($1.node)};
-        b.right = $3.node;
-        $$.node = bin;
+        pseu::ast::BinOpNode b;
+        b.left = $1;
+        b.op_tok = pseu::lexer::Token{pseu::lexer::TokenType::Arth, pseu::sym::known::minus, 0, node_line(ctx.arena, $1, ctx.line)};
+        b.right = $3;
+        $$ = ctx.arena.make(b);
     }
     ;
 
 term
     : factor
     {
-        $$.node = $1.node;
+        $$ = $1;
     }
-    | term '*' factor
+    | term "*" factor
     {
-        auto bin = std::make_shared<pseu::ast::ASTNode>(pseu::ast::BinOpNode{});
-        auto& b = std::get<pseu::ast::BinOpNode>(*bin);
-        b.left = $1.node;
-        b.op_tok = pseu::lexer::Token{pseu::lexer::TokenType::Arth, "*", node_line($1.node)};
-        b.right = $3.node;
-        $$.node = bin;
+        pseu::ast::BinOpNode b;
+        b.left = $1;
+        b.op_tok = pseu::lexer::Token{pseu::lexer::TokenType::Arth, pseu::sym::known::star, 0, node_line(ctx.arena, $1, ctx.line)};
+        b.right = $3;
+        $$ = ctx.arena.make(b);
     }
 
-    | term '/' factor
+    | term "/" factor
     {
-        auto bin = std::make_shared<pseu::ast::ASTNode>(pseu::ast::BinOpNode{});
-        auto& b = std::get<pseu::ast::BinOpNode>(*bin);
-        b.left = $1.node;
-        b.op_tok = pseu::lexer::Token{pseu::lexer::TokenType::Arth, "/", node_line($1.node)};
-        b.right = $3.node;
-        $$.node = bin;
+        pseu::ast::BinOpNode b;
+        b.left = $1;
+        b.op_tok = pseu::lexer::Token{pseu::lexer::TokenType::Arth, pseu::sym::known::slash, 0, node_line(ctx.arena, $1, ctx.line)};
+        b.right = $3;
+        $$ = ctx.arena.make(b);
     }
 
     ;
@@ -200,20 +210,20 @@ term
 factor
     : T_INTLIT
     {
-        // $1 is the Token from the scanner (via %union.token)
-        $$.node = std::make_shared<pseu::ast::ASTNode>(pseu::ast::NumberNode{$1.token});
+        // $1 is the Token from the scanner
+        $$ = ctx.arena.make(pseu::ast::NumberNode{$1});
     }
     | T_VAR
     {
-        $$.node = std::make_shared<pseu::ast::ASTNode>(pseu::ast::IdentifierNode{$1.token});
+        $$ = ctx.arena.make(pseu::ast::IdentifierNode{$1});
     }
     | T_LPAREN expr T_RPAREN
     {
-        $$.node = $2.node; // Pass the inner expression's node up
+        $$ = $2; // Pass the inner expression's node up
     }
     | T_STRING
     {
-        $$.node = std::make_shared<pseu::ast::ASTNode>(pseu::ast::StringLiteralNode{$1.token});
+        $$ = ctx.arena.make(pseu::ast::StringLiteralNode{$1});
     }
     ;
 
@@ -222,11 +232,10 @@ factor
 assignment
     : T_VAR T_ASSIGN expr T_SEMICOLON
     {
-        auto a = std::make_shared<pseu::ast::ASTNode>(pseu::ast::Assignment{});
-        auto& as = std::get<pseu::ast::Assignment>(*a);
-        as.identifier = $1.token;
-        as.expression = $3.node;
-        $$.node = a;
+        pseu::ast::Assignment as;
+        as.identifier = $1;
+        as.expression = $3;
+        $$ = ctx.arena.make(as);
     }
 
     ;
@@ -234,22 +243,21 @@ assignment
 if_statement
     : T_IF T_LPAREN condition T_RPAREN T_LBRACE statements T_RBRACE
     {
-        auto ifs = std::make_shared<pseu::ast::ASTNode>(pseu::ast::IfStatement{});
-        auto& if_stmt = std::get<pseu::ast::IfStatement>(*ifs);
-        if_stmt.if_condition = $3.node;
-        if_stmt.if_body = $6.node;
-        if_stmt.else_body = nullptr;
-        $$.node = ifs;
+        pseu::ast::IfStatement if_stmt;
+        if_stmt.if_condition = $3;
+        if_stmt.if_body = ctx.arena.close_list($6);
+        if_stmt.else_body = pseu::ast::NodeId::null;
+        $$ = ctx.arena.make(if_stmt);
     }
     | T_IF T_LPAREN condition T_RPAREN T_LBRACE statements T_RBRACE
       T_ELSE T_LBRACE statements T_RBRACE
     {
-        auto ifs = std::make_shared<pseu::ast::ASTNode>(pseu::ast::IfStatement{});
-        auto& if_stmt = std::get<pseu::ast::IfStatement>(*ifs);
-        if_stmt.if_condition = $3.node;
-        if_stmt.if_body = $6.node;
-        if_stmt.else_body = $10.node;
-        $$.node = ifs;
+        // Both bodies are still open here: close the inner (else) list first
+        pseu::ast::IfStatement if_stmt;
+        if_stmt.if_condition = $3;
+        if_stmt.else_body = ctx.arena.close_list($10);
+        if_stmt.if_body = ctx.arena.close_list($6);
+        $$ = ctx.arena.make(if_stmt);
     }
 
     ;
@@ -257,10 +265,10 @@ if_statement
 condition
     : expr T_COMPARISON expr
     {
-        $$.node = std::make_shared<pseu::ast::ASTNode>(pseu::ast::Condition{
-            $1.node,
-            $2.token,
-            $3.node
+        $$ = ctx.arena.make(pseu::ast::Condition{
+            $1,
+            $2,
+            $3
             }
         );
     }
@@ -270,94 +278,86 @@ condition
 while_statement
     : T_WHILE T_LPAREN condition T_RPAREN T_LBRACE statements T_RBRACE
     {
-        auto w = std::make_shared<pseu::ast::ASTNode>(pseu::ast::WhileStatement{});
-        auto& w_stmt = std::get<pseu::ast::WhileStatement>(*w);
-        w_stmt.condition = $3.node;
-        w_stmt.body = $6.node;
-        $$.node = w;
+        pseu::ast::WhileStatement w_stmt;
+        w_stmt.condition = $3;
+        w_stmt.body = ctx.arena.close_list($6);
+        $$ = ctx.arena.make(w_stmt);
     }
     ;
 
 printing
     : T_PRINT T_LPAREN expr T_RPAREN T_SEMICOLON
     {
-        auto p = std::make_shared<pseu::ast::ASTNode>(pseu::ast::PrintStatement{});
-        auto& p_stmt = std::get<pseu::ast::PrintStatement>(*p);
+        pseu::ast::PrintStatement p_stmt;
         p_stmt.type = pseu::ast::PrintType::Int;
-        p_stmt.value = $3.node;
-        $$.node = p;
+        p_stmt.value = $3;
+        $$ = ctx.arena.make(p_stmt);
     }
     | T_PRINTS T_LPAREN T_STRING T_RPAREN T_SEMICOLON
     {
-        auto p = std::make_shared<pseu::ast::ASTNode>(pseu::ast::PrintStatement{});
-        auto& p_stmt = std::get<pseu::ast::PrintStatement>(*p);
+        pseu::ast::PrintStatement p_stmt;
         p_stmt.type = pseu::ast::PrintType::Str;
-        p_stmt.value = $3.token.value;
-        $$.node = p;
+        p_stmt.value = $3.value;
+        $$ = ctx.arena.make(p_stmt);
     }
     | T_PRINTS T_LPAREN T_VAR T_RPAREN T_SEMICOLON
     {
-        auto p = std::make_shared<pseu::ast::ASTNode>(pseu::ast::PrintStatement{});
-        auto& p_stmt = std::get<pseu::ast::PrintStatement>(*p);
+        pseu::ast::PrintStatement p_stmt;
         p_stmt.type = pseu::ast::PrintType::Str;
 
-        p_stmt.value = std::make_shared<pseu::ast::ASTNode>(pseu::ast::IdentifierNode{$3.token});
+        p_stmt.value = ctx.arena.make(pseu::ast::IdentifierNode{$3});
 
-        $$.node = p;
+        $$ = ctx.arena.make(p_stmt);
     }
     ;
 
 declarations
     : T_INT identifier_list T_SEMICOLON
     {
-        auto decl = std::make_shared<pseu::ast::ASTNode>(pseu::ast::Declaration{});
-        auto& d = std::get<pseu::ast::Declaration>(*decl);
-        d.declaration_type = pseu::lexer::Token{pseu::lexer::TokenType::Int, "int", yylineno};
-        d.identifiers = $2.token_list;
-        $$.node = decl;
+        pseu::ast::Declaration d;
+        d.declaration_type = pseu::lexer::Token{pseu::lexer::TokenType::Int, pseu::sym::known::kw_int, 0, ctx.line};
+        d.identifiers = ctx.arena.store_tokens($2);
+        $$ = ctx.arena.make(d);
     }
     | T_INT T_VAR T_ASSIGN expr T_SEMICOLON
     {
-        auto decl = std::make_shared<pseu::ast::ASTNode>(pseu::ast::Declaration{});
-        auto& d = std::get<pseu::ast::Declaration>(*decl);
-        d.declaration_type = pseu::lexer::Token{pseu::lexer::TokenType::Int, "int", yylineno};
-        d.identifiers = { $2.token };
-        d.init_expr = $4.node;
-        $$.node = decl;
+        pseu::ast::Declaration d;
+        d.declaration_type = pseu::lexer::Token{pseu::lexer::TokenType::Int, pseu::sym::known::kw_int, 0, ctx.line};
+        d.identifiers = ctx.arena.store_tokens(std::span(&$2, 1));
+        d.init_expr = $4;
+        $$ = ctx.arena.make(d);
     }
     | T_STRINGKW identifier_list T_SEMICOLON
     {
-        auto decl = std::make_shared<pseu::ast::ASTNode>(pseu::ast::Declaration{});
-        auto& d = std::get<pseu::ast::Declaration>(*decl);
-        d.declaration_type = pseu::lexer::Token{pseu::lexer::TokenType::StringKw, "string", yylineno};
-        d.identifiers = $2.token_list;
-        $$.node = decl;
+        pseu::ast::Declaration d;
+        d.declaration_type = pseu::lexer::Token{pseu::lexer::TokenType::StringKw, pseu::sym::known::kw_string, 0, ctx.line};
+        d.identifiers = ctx.arena.store_tokens($2);
+        $$ = ctx.arena.make(d);
     }
     | T_STRINGKW T_VAR T_ASSIGN T_STRING T_SEMICOLON
     {
         // Build string literal node
-        auto lit = std::make_shared<pseu::ast::ASTNode>(pseu::ast::StringLiteralNode{$4.token});
+        auto lit = ctx.arena.make(pseu::ast::StringLiteralNode{$4});
 
         // Assignment node
-        auto assign = std::make_shared<pseu::ast::ASTNode>(pseu::ast::Assignment{});
-        auto& ass = std::get<pseu::ast::Assignment>(*assign);
-        ass.identifier = $2.token;
+        pseu::ast::Assignment ass;
+        ass.identifier = $2;
         ass.expression = lit;
 
-        $$.node = assign;
+        $$ = ctx.arena.make(ass);
     }
     ;
 
 identifier_list
     : T_VAR
     {
-        $$.token_list = std::vector<pseu::lexer::Token>{ $1.token };
+        $$.push_back($1);
     }
-    | identifier_list ',' T_VAR
+    | identifier_list "," T_VAR
     {
-        auto list = $1.token_list;
-        list.push_back($3.token);
-        $$.token_list = list;
+        // Move the list up and append in place: linear in the list length
+        $$ = std::move($1);
+        $$.push_back($3);
     }
     ;
 
@@ -365,7 +365,7 @@ identifier_list
 /* 4. EPILOGUE */
 
 // Bison calls this function on a syntax error.
-void yyerror(const char *s) {
-    std::string error_msg = std::string(s) + " at line " + std::to_string(yylineno);
-    throw std::runtime_error(error_msg);
+// The message is recorded in the context; parse() then returns non-zero.
+void pseu::parser::Parser::error(const std::string &msg) {
+    ctx.fail(msg);
 }
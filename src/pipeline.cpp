@@ -0,0 +1,125 @@
+#include "pipeline.hpp"
+#include <fstream>
+#include <stdexcept>
+#include "elf.hpp"
+#include "frontend.hpp"
+
+namespace pseu {
+
+    using report::timed;
+
+    pipeline::Compilation::Compilation(session::CompilationSession &session, const Options &options,
+                                       report::TimeReport *report, sym::SymbolTable *symbols)
+        : session_(session), options_(options), report_(report), pool_(session.pool()),
+          symbols_(symbols ? *symbols : session.symbols()) {
+        session_.reset();
+    }
+
+    ast::NodeId pipeline::Compilation::parse(std::string_view source) {
+        ast::NodeId root{};
+        timed(report_, "parse", "nodes", [&] {
+            root = frontend::parse(source, session_.ast());
+            return session_.ast().size();
+        });
+        return root;
+    }
+
+    ast::NodeId pipeline::Compilation::parse_in_place(char *base, std::size_t padded_size) {
+        ast::NodeId root{};
+        timed(report_, "parse", "nodes", [&] {
+            root = frontend::parse_in_place(base, padded_size, session_.ast());
+            return session_.ast().size();
+        });
+        return root;
+    }
+
+    const ir::GeneratedIR &pipeline::Compilation::generate(ast::NodeId root) {
+        timed(report_, "irgen", "instructions", [&] {
+            ir::IntermediateCodeGen(session_, root);
+            return session_.ir().code.code.size();
+        });
+        return session_.ir();
+    }
+
+    const cfg::CFG *pipeline::Compilation::analyze() {
+        if (analyzed_)
+            return graph_ ? &*graph_ : nullptr;
+        analyzed_ = true;
+
+        const auto &gen = session_.ir();
+        if (options_.cfg || options_.opt_level >= 1)
+            timed(report_, "cfg", "blocks", [&] { return graph_.emplace(gen.code).size(); });
+
+        // -O1 and above: keep int variables and temporaries in registers
+        if (options_.opt_level >= 1)
+            timed(report_, "regalloc", "values", [&] {
+                allocation_ = regalloc::allocate(gen, *graph_);
+                return gen.variables.size() + gen.temps;
+            });
+        return graph_ ? &*graph_ : nullptr;
+    }
+
+    codegen::CodeGenerator &pipeline::Compilation::generator() {
+        if (!codegen_) {
+            analyze();
+            codegen_.emplace(session_, allocation_ ? &*allocation_ : nullptr, options_.runtime);
+        }
+        return *codegen_;
+    }
+
+    std::string_view pipeline::Compilation::assembly() {
+        auto &codegen = generator();
+        std::string_view text;
+        timed(report_, "codegen", "bytes", [&] { return (text = codegen.generate()).size(); });
+        return text;
+    }
+
+    x86::Module pipeline::Compilation::encode() {
+        auto &codegen = generator();
+        x86::Module module;
+        timed(report_, "codegen", "bytes", [&] {
+            module = codegen.encode();
+            return module.text.size() + module.data.size();
+        });
+        return module;
+    }
+
+    void pipeline::Compilation::output(Emit emit, std::vector<std::uint8_t> &bytes) {
+        if (emit == Emit::Asm) {
+            const auto text = assembly();
+            bytes.assign(text.begin(), text.end());
+            return;
+        }
+        // machine code straight from the IR, no assembly text
+        const auto module = encode();
+        timed(report_, "link", "bytes", [&] {
+            bytes = emit == Emit::Obj ? elf::object(module) : elf::executable(module);
+            return bytes.size();
+        });
+    }
+
+    void pipeline::Compilation::write(Emit emit, const std::string &path) {
+        if (emit == Emit::Asm) {
+            const auto text = assembly();
+            timed(report_, "write", "bytes", [&] {
+                std::ofstream f(path, std::ios::binary | std::ios::trunc);
+                if (!f)
+                    throw std::runtime_error("Cannot open " + path);
+                f.write(text.data(), static_cast<std::streamsize>(text.size()));
+                // a full disk may only show when the buffer is flushed
+                f.close();
+                if (!f)
+                    throw std::runtime_error("Cannot write " + path);
+                return text.size();
+            });
+            return;
+        }
+        std::vector<std::uint8_t> bytes;
+        output(emit, bytes);
+        timed(report_, "write", "bytes", [&] {
+            elf::save(path, bytes, emit == Emit::Exe);
+            return bytes.size();
+        });
+    }
+
+} // namespace pseu
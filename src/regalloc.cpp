@@ -0,0 +1,260 @@
+#include "regalloc.hpp"
+#include <algorithm>
+#include <array>
+#include <limits>
+
+namespace pseu {
+
+    namespace {
+        using regalloc::Reg;
+
+        /// @brief Fixed-size bit set over value ids, one per block and liveness set.
+        using Bits = std::vector<std::uint64_t>;
+
+        bool test(const Bits &b, std::uint32_t v) { return (b[v >> 6] >> (v & 63)) & 1u; }
+
+        void set(Bits &b, std::uint32_t v) { b[v >> 6] |= std::uint64_t{1} << (v & 63); }
+
+        /// @brief Live range of one value, as the hull of its live positions.
+        struct Interval final {
+            std::uint32_t value;
+            std::uint32_t start = std::numeric_limits<std::uint32_t>::max();
+            std::uint32_t end = 0;
+            bool crosses_call = false;
+            bool at_div = false;
+            bool written_first = false; // the access at start is a write, not a read or a live-in value
+            Reg reg = Reg::none;
+        };
+
+        /// @brief Allocation order: registers clobbered by calls first, keeping the call-safe ones free.
+        constexpr std::array pool_order{
+                Reg::rcx, Reg::rsi, Reg::rdi, Reg::r11, Reg::rdx,
+                Reg::r8, Reg::r9, Reg::r10, Reg::r12, Reg::r13, Reg::r14, Reg::r15
+        };
+
+        /// @brief Registers overwritten by the print helpers (rcx and r11 also by <code>syscall</code>).
+        constexpr bool call_clobbered(Reg r) {
+            return r == Reg::rcx || r == Reg::rdx || r == Reg::rsi || r == Reg::rdi || r == Reg::r11;
+        }
+
+        /// @brief Invoke <code>use</code> for each operand read and <code>def</code> for the one written.
+        template<typename Use, typename Def>
+        void for_each_access(const ir::IRInstr &instr, Use &&use, Def &&def) {
+            std::visit([&](const auto &in) {
+                using T = std::decay_t<decltype(in)>;
+
+                if constexpr (std::is_same_v<T, ir::AssignmentCode>) {
+                    use(in.left);
+                    use(in.right);
+                    def(in.var);
+                } else if constexpr (std::is_same_v<T, ir::CompareCodeIR>) {
+                    use(in.left);
+                    use(in.right);
+                } else if constexpr (std::is_same_v<T, ir::PrintCodeIR>) {
+                    use(in.value);
+                }
+            }, instr);
+        }
+    }
+
+    std::string_view regalloc::name(Reg r) noexcept {
+        constexpr std::string_view names[] = {
+                "rax", "rcx", "rdx", "rbx", "rsi", "rdi", "r8", "r9",
+                "r10", "r11", "r12", "r13", "r14", "r15"
+        };
+        return r == Reg::none ? std::string_view{} : names[static_cast<std::uint8_t>(r)];
+    }
+
+    regalloc::Reg regalloc::Allocation::location(const ir::Operand &o) const noexcept {
+        switch (o.kind) {
+            case ir::OperandKind::Var:
+                return vars[o.index()];
+            case ir::OperandKind::Temp:
+                return temps[o.index()];
+            default:
+                return Reg::none;
+        }
+    }
+
+    regalloc::Allocation regalloc::allocate(const ir::GeneratedIR &ir, const cfg::CFG &graph) {
+        // values: variable slots first, then temporaries T1 .. Tn
+        const auto n_vars = static_cast<std::uint32_t>(ir.variables.size());
+        const auto n_values = n_vars + ir.temps;
+        constexpr auto no_value = std::numeric_limits<std::uint32_t>::max();
+        const auto value_of = [&](const ir::Operand &o) -> std::uint32_t {
+            if (o.kind == ir::OperandKind::Var)
+                return o.index();
+            if (o.kind == ir::OperandKind::Temp)
+                return n_vars + o.index() - 1;
+            return no_value;
+        };
+
+        // ---- local use / def sets and call / division positions ----
+        const auto n_blocks = graph.size();
+        const auto words = (n_values + 63) / 64;
+        std::vector<Bits> use(n_blocks, Bits(words)), def(n_blocks, Bits(words));
+        std::vector<std::uint32_t> block_start(n_blocks + 1);
+        std::vector<std::uint32_t> calls, divs;
+
+        std::uint32_t pos = 0;
+        for (cfg::BlockId b = 0; b < n_blocks; ++b) {
+            block_start[b] = pos;
+            for (auto ins: graph[b].code) {
+                [[maybe_unused]] auto g = ins.guard();
+                for_each_access(*ins, [&](const ir::Operand &o) {
+                    if (auto v = value_of(o); v != no_value && !test(def[b], v))
+                        set(use[b], v);
+                }, [&](const ir::Operand &o) {
+                    if (auto v = value_of(o); v != no_value)
+                        set(def[b], v);
+                });
+                if (std::holds_alternative<ir::PrintCodeIR>(*ins))
+                    calls.push_back(pos);
+                if (auto *a = std::get_if<ir::AssignmentCode>(&*ins); a && a->op == ir::BinOp::Div)
+                    divs.push_back(pos);
+                ++pos;
+            }
+        }
+        block_start[n_blocks] = pos;
+
+        // ---- global liveness, backwards to a fixed point ----
+        std::vector<Bits> live_in(n_blocks, Bits(words)), live_out(n_blocks, Bits(words));
+        const auto &rpo = graph.reverse_postorder();
+        for (bool changed = true; changed;) {
+            changed = false;
+            for (auto it = rpo.rbegin(); it != rpo.rend(); ++it) {
+                const auto b = *it;
+                auto &out = live_out[b];
+                auto &in = live_in[b];
+                for (auto s: graph[b].succs)
+                    for (std::size_t w = 0; w < words; ++w)
+                        out[w] |= live_in[s][w];
+                for (std::size_t w = 0; w < words; ++w) {
+                    const auto next = use[b][w] | (out[w] & ~def[b][w]);
+                    if (next != in[w]) {
+                        in[w] = next;
+                        changed = true;
+                    }
+                }
+            }
+        }
+
+        // ---- live intervals ----
+        std::vector<Interval> intervals(n_values);
+        for (std::uint32_t v = 0; v < n_values; ++v)
+            intervals[v].value = v;
+        const auto extend = [&](std::uint32_t v, std::uint32_t p, bool write) {
+            auto &iv = intervals[v];
+            if (p < iv.start) {
+                iv.start = p;
+                iv.written_first = write;
+            }
+            iv.end = std::max(iv.end, p);
+        };
+
+        pos = 0;
+        for (cfg::BlockId b = 0; b < n_blocks; ++b) {
+            if (block_start[b] == block_start[b + 1])
+                continue;
+            for (std::uint32_t v = 0; v < n_values; ++v)
+                if (test(live_in[b], v))
+                    extend(v, block_start[b], false);
+            // reads of an instruction are visited before its write, so a
+            // value both read and written at its start is not written first
+            for (auto ins: graph[b].code) {
+                [[maybe_unused]] auto g = ins.guard();
+                for_each_access(*ins, [&](const ir::Operand &o) {
+                    if (auto v = value_of(o); v != no_value)
+                        extend(v, pos, false);
+                }, [&](const ir::Operand &o) {
+                    if (auto v = value_of(o); v != no_value)
+                        extend(v, pos, true);
+                });
+                ++pos;
+            }
+            for (std::uint32_t v = 0; v < n_values; ++v)
+                if (test(live_out[b], v))
+                    extend(v, block_start[b + 1] - 1, false);
+        }
+
+        // ---- candidates: int variables and temporaries ----
+        std::vector<Interval *> order;
+        for (auto &iv: intervals) {
+            if (iv.start > iv.end)
+                continue; // never referenced
+            if (iv.value < n_vars && ir.variables[iv.value].type != sym::known::kw_int)
+                continue;
+
+            // a print at start reads the value and clobbers its register if it stays live
+            auto c = std::lower_bound(calls.begin(), calls.end(), iv.start);
+            iv.crosses_call = c != calls.end() && *c < iv.end;
+            auto d = std::lower_bound(divs.begin(), divs.end(), iv.start);
+            iv.at_div = d != divs.end() && *d <= iv.end;
+            order.push_back(&iv);
+        }
+        std::stable_sort(order.begin(), order.end(), [](auto *a, auto *b) { return a->start < b->start; });
+
+        // ---- linear scan ----
+        std::array<bool, 16> busy{};
+        std::vector<Interval *> active; // sorted by end
+        for (auto *cur: order) {
+            // an interval ending where the next one starts may hand over its
+            // register only if the next one is written there: operands are
+            // read before the result is written. A value read first (or
+            // zeroed at entry) needs the register to itself from its start.
+            const auto free_below = cur->written_first ? cur->start + 1 : cur->start;
+            while (!active.empty() && active.front()->end < free_below) {
+                busy[static_cast<std::uint8_t>(active.front()->reg)] = false;
+                active.erase(active.begin());
+            }
+
+            const auto allowed = [&](Reg r) {
+                return !(cur->crosses_call && call_clobbered(r)) && !(cur->at_div && r == Reg::rdx);
+            };
+            const auto insert_active = [&](Interval *iv) {
+                active.insert(std::upper_bound(active.begin(), active.end(), iv,
+                                               [](auto *a, auto *b) { return a->end < b->end; }), iv);
+            };
+
+            for (auto r: pool_order) {
+                if (!busy[static_cast<std::uint8_t>(r)] && allowed(r)) {
+                    cur->reg = r;
+                    busy[static_cast<std::uint8_t>(r)] = true;
+                    insert_active(cur);
+                    break;
+                }
+            }
+            if (cur->reg != Reg::none)
+                continue;
+
+            // spill whichever of cur and a compatible active interval ends last
+            auto victim = active.end();
+            for (auto it = active.begin(); it != active.end(); ++it)
+                if (allowed((*it)->reg))
+                    victim = it;
+            if (victim != active.end() && (*victim)->end > cur->end) {
+                cur->reg = (*victim)->reg;
+                (*victim)->reg = Reg::none;
+                active.erase(victim);
+                insert_active(cur);
+            }
+        }
+
+        // ---- result ----
+        Allocation out;
+        out.vars.assign(n_vars, Reg::none);
+        out.temps.assign(ir.temps + 1, Reg::none);
+        for (const auto &iv: intervals) {
+            if (iv.value < n_vars)
+                out.vars[iv.value] = iv.reg;
+            else
+                out.temps[iv.value - n_vars + 1] = iv.reg;
+        }
+        if (n_blocks)
+            for (std::uint32_t v = 0; v < n_values; ++v)
+                if (test(live_in[0], v) && intervals[v].reg != Reg::none)
+                    out.zeroed.push_back(intervals[v].reg);
+        return out;
+    }
+
+} // namespace pseu
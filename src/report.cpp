@@ -0,0 +1,81 @@
+#include "report.hpp"
+#include <iomanip>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <sys/resource.h>
+#define PSEU_HAS_RUSAGE 1
+#else
+#define PSEU_HAS_RUSAGE 0
+#endif
+
+namespace pseu {
+
+    report::Allocations &report::allocations() noexcept {
+        static Allocations a;
+        return a;
+    }
+
+    std::uint64_t report::peak_rss_kib() noexcept {
+#if PSEU_HAS_RUSAGE
+        rusage u{};
+        if (::getrusage(RUSAGE_SELF, &u) != 0)
+            return 0;
+#if defined(__APPLE__)
+        return static_cast<std::uint64_t>(u.ru_maxrss) / 1024; // bytes
+#else
+        return static_cast<std::uint64_t>(u.ru_maxrss);        // KiB
+#endif
+#else
+        return 0;
+#endif
+    }
+
+    report::TimeReport::TimeReport() noexcept {
+        allocations().enabled.store(true, std::memory_order_relaxed);
+    }
+
+    report::TimeReport::~TimeReport() {
+        allocations().enabled.store(false, std::memory_order_relaxed);
+    }
+
+    void report::TimeReport::write_text(std::ostream &os) const {
+        const auto flags = os.flags();
+        double total = 0;
+        std::uint64_t allocs = 0, bytes = 0;
+
+        os << "===== Time Report =====\n"
+           << std::left << std::setw(10) << "phase" << std::right
+           << std::setw(12) << "ms" << std::setw(10) << "allocs" << std::setw(12) << "alloc KiB"
+           << std::setw(14) << "peak RSS KiB" << "  items\n";
+        for (const auto &p: phases_) {
+            os << std::left << std::setw(10) << p.name << std::right << std::fixed << std::setprecision(3)
+               << std::setw(12) << p.seconds * 1e3 << std::setw(10) << p.allocations
+               << std::setw(12) << p.allocated_bytes / 1024 << std::setw(14) << p.peak_rss_kib
+               << "  " << p.items << " " << p.unit << "\n";
+            total += p.seconds;
+            allocs += p.allocations;
+            bytes += p.allocated_bytes;
+        }
+        os << std::left << std::setw(10) << "total" << std::right << std::setw(12) << total * 1e3
+           << std::setw(10) << allocs << std::setw(12) << bytes / 1024 << std::setw(14) << peak_rss_kib() << "\n";
+        os.flags(flags);
+    }
+
+    void report::TimeReport::write_json(std::ostream &os) const {
+        double total = 0;
+        os << "{\"phases\": [";
+        for (std::size_t i = 0; i < phases_.size(); ++i) {
+            const auto &p = phases_[i];
+            os << (i ? ", " : "") << "{\"name\": \"" << p.name << "\""
+               << ", \"seconds\": " << p.seconds
+               << ", \"allocations\": " << p.allocations
+               << ", \"allocated_bytes\": " << p.allocated_bytes
+               << ", \"peak_rss_kib\": " << p.peak_rss_kib
+               << ", \"items\": " << p.items
+               << ", \"unit\": \"" << p.unit << "\"}";
+            total += p.seconds;
+        }
+        os << "], \"total_seconds\": " << total << ", \"peak_rss_kib\": " << peak_rss_kib() << "}\n";
+    }
+
+} // namespace pseu
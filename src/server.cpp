@@ -0,0 +1,268 @@
+#include "server.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <stdexcept>
+#include <thread>
+
+#include "pipeline.hpp"
+#include "session.hpp"
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <cerrno>
+#include <csignal>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+#include <sys/un.h>
+#include <unistd.h>
+#define PSEU_HAS_UNIX_SOCKETS 1
+#else
+#define PSEU_HAS_UNIX_SOCKETS 0
+#endif
+
+namespace pseu {
+
+#if PSEU_HAS_UNIX_SOCKETS
+    namespace {
+        constexpr char magic[4] = {'P', 'S', 'E', 'U'};
+
+        /// @brief Largest accepted source; anything bigger is refused.
+        constexpr std::uint64_t max_source = std::uint64_t{256} << 20;
+
+        /// @brief A connection idle this long, or stalled mid-message, is closed so its worker can take another.
+        constexpr timeval io_timeout{5, 0};
+
+        /// @brief Wait after running out of descriptors before accepting again.
+        constexpr auto accept_backoff = std::chrono::milliseconds(100);
+
+        /// @brief Buffers above this capacity are released after a request, as is a session holding more.
+        constexpr std::size_t keep_capacity = std::size_t{1} << 20;
+
+        struct RequestHeader final {
+            char magic[4];
+            std::uint8_t opt_level;
+            server::Format format;
+            std::uint8_t reserved[2];
+            std::uint64_t length;
+        };
+
+        struct ResponseHeader final {
+            std::uint8_t status;
+            std::uint8_t reserved[7];
+            std::uint64_t length;
+        };
+
+        static_assert(sizeof(RequestHeader) == 16 && sizeof(ResponseHeader) == 16);
+        static_assert(static_cast<int>(server::Format::Asm) == static_cast<int>(pipeline::Emit::Asm) &&
+                      static_cast<int>(server::Format::Obj) == static_cast<int>(pipeline::Emit::Obj) &&
+                      static_cast<int>(server::Format::Exe) == static_cast<int>(pipeline::Emit::Exe));
+
+        /// @brief Read exactly n bytes. @return false on end of stream before the first byte.
+        bool read_full(int fd, void *buf, std::size_t n) {
+            auto *p = static_cast<char *>(buf);
+            std::size_t done = 0;
+            while (done < n) {
+                const auto r = ::read(fd, p + done, n - done);
+                if (r > 0) {
+                    done += static_cast<std::size_t>(r);
+                } else if (r == 0) {
+                    if (done == 0)
+                        return false;
+                    throw std::runtime_error("Connection closed mid-message");
+                } else if (errno != EINTR) {
+                    throw std::runtime_error(std::string("read: ") + std::strerror(errno));
+                }
+            }
+            return true;
+        }
+
+        void write_full(int fd, const void *buf, std::size_t n) {
+            const auto *p = static_cast<const char *>(buf);
+            while (n) {
+                const auto w = ::write(fd, p, n);
+                if (w >= 0) {
+                    p += w;
+                    n -= static_cast<std::size_t>(w);
+                } else if (errno != EINTR) {
+                    throw std::runtime_error(std::string("write: ") + std::strerror(errno));
+                }
+            }
+        }
+
+        void respond(int fd, bool ok, const void *data, std::size_t size) {
+            ResponseHeader h{};
+            h.status = ok ? 0 : 1;
+            h.length = size;
+            write_full(fd, &h, sizeof h);
+            write_full(fd, data, size);
+        }
+
+        sockaddr_un address(const std::string &path) {
+            sockaddr_un a{};
+            a.sun_family = AF_UNIX;
+            if (path.size() >= sizeof a.sun_path)
+                throw std::runtime_error("Socket path too long: " + path);
+            std::memcpy(a.sun_path, path.c_str(), path.size() + 1);
+            return a;
+        }
+
+        /**
+         * @brief Remove a socket left at <code>path</code> by a server that is gone.
+         *
+         * @throws std::runtime_error if <code>path</code> is not a socket,
+         *         or if a server still answers on it.
+         */
+        void remove_stale(const std::string &path, const sockaddr_un &addr) {
+            struct stat st{};
+            if (::lstat(path.c_str(), &st) != 0) {
+                if (errno == ENOENT)
+                    return;
+                throw std::runtime_error("Cannot listen on " + path + ": " + std::strerror(errno));
+            }
+            if (!S_ISSOCK(st.st_mode))
+                throw std::runtime_error("Cannot listen on " + path + ": path exists and is not a socket");
+
+            const int probe = ::socket(AF_UNIX, SOCK_STREAM, 0);
+            if (probe < 0)
+                throw std::runtime_error(std::string("socket: ") + std::strerror(errno));
+            const bool live = ::connect(probe, reinterpret_cast<const sockaddr *>(&addr), sizeof addr) == 0;
+            ::close(probe);
+            if (live)
+                throw std::runtime_error("Cannot listen on " + path + ": another server is running");
+            ::unlink(path.c_str());
+        }
+
+        /// @brief Compile one request in the thread's session and send the response.
+        void compile(int fd, const RequestHeader &h, const std::string &source, std::vector<std::uint8_t> &binary,
+                     session::CompilationSession &session) {
+            try {
+                pipeline::Compilation c(session, {.opt_level = h.opt_level});
+                c.generate(c.parse(source));
+                c.output(static_cast<pipeline::Emit>(h.format), binary);
+            } catch (const std::exception &e) {
+                const std::string_view what = e.what();
+                respond(fd, false, what.data(), what.size());
+                return;
+            }
+            respond(fd, true, binary.data(), binary.size());
+        }
+
+        void serve_connection(int fd, std::string &source, std::vector<std::uint8_t> &binary,
+                              session::CompilationSession &session) {
+            RequestHeader h{};
+            while (read_full(fd, &h, sizeof h)) {
+                if (std::memcmp(h.magic, magic, sizeof magic) != 0 || h.length > max_source
+                    || h.format > server::Format::Exe) {
+                    constexpr std::string_view bad = "Malformed request";
+                    respond(fd, false, bad.data(), bad.size());
+                    return;
+                }
+                source.resize(h.length);
+                if (h.length && !read_full(fd, source.data(), h.length))
+                    return;
+                compile(fd, h, source, binary, session);
+
+                // keep the warm buffers, unless a large request grew them
+                if (source.capacity() > keep_capacity)
+                    std::string().swap(source);
+                if (binary.capacity() > keep_capacity)
+                    std::vector<std::uint8_t>().swap(binary);
+                session.reset();
+                session.shrink_to(keep_capacity);
+            }
+        }
+
+        void accept_loop(int listener) {
+            std::string source;
+            std::vector<std::uint8_t> binary;
+            session::CompilationSession session;
+            for (;;) {
+                const int fd = ::accept(listener, nullptr, nullptr);
+                if (fd < 0) {
+                    // out of descriptors or memory: retrying at once would spin until one is closed
+                    if (errno == EMFILE || errno == ENFILE || errno == ENOBUFS || errno == ENOMEM)
+                        std::this_thread::sleep_for(accept_backoff);
+                    continue; // EINTR, ECONNABORTED: try again
+                }
+                // a worker serves one connection at a time: an idle or stalled client must not keep it
+                ::setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &io_timeout, sizeof io_timeout);
+                ::setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &io_timeout, sizeof io_timeout);
+                try {
+                    serve_connection(fd, source, binary, session);
+                } catch (const std::exception &) {
+                    // the client went away; nothing to report to
+                }
+                ::close(fd);
+            }
+        }
+    }
+
+    void server::serve(const std::string &path, unsigned workers) {
+        // a client closing early must not kill the server
+        std::signal(SIGPIPE, SIG_IGN);
+
+        const auto addr = address(path);
+        remove_stale(path, addr);
+        const int listener = ::socket(AF_UNIX, SOCK_STREAM, 0);
+        if (listener < 0)
+            throw std::runtime_error(std::string("socket: ") + std::strerror(errno));
+        if (::bind(listener, reinterpret_cast<const sockaddr *>(&addr), sizeof addr) != 0 ||
+            ::listen(listener, 128) != 0) {
+            const auto err = std::string(std::strerror(errno));
+            ::close(listener);
+            throw std::runtime_error("Cannot listen on " + path + ": " + err);
+        }
+
+        std::vector<std::jthread> threads;
+        for (unsigned w = 1; w < std::max(workers, 1u); ++w)
+            threads.emplace_back(accept_loop, listener);
+        accept_loop(listener);
+        std::abort(); // not reached
+    }
+
+    server::Response server::request(const std::string &path, std::string_view source, int opt_level,
+                                     Format format) {
+        const auto addr = address(path);
+        const int fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+        if (fd < 0)
+            throw std::runtime_error(std::string("socket: ") + std::strerror(errno));
+        struct Closer {
+            int fd;
+
+            ~Closer() { ::close(fd); }
+        } closer{fd};
+
+        if (::connect(fd, reinterpret_cast<const sockaddr *>(&addr), sizeof addr) != 0)
+            throw std::runtime_error("Cannot connect to " + path + ": " + std::strerror(errno));
+
+        RequestHeader h{};
+        std::memcpy(h.magic, magic, sizeof magic);
+        h.opt_level = static_cast<std::uint8_t>(opt_level);
+        h.format = format;
+        h.length = source.size();
+        write_full(fd, &h, sizeof h);
+        write_full(fd, source.data(), source.size());
+
+        ResponseHeader rh{};
+        if (!read_full(fd, &rh, sizeof rh))
+            throw std::runtime_error("Server closed the connection");
+        Response r;
+        r.ok = rh.status == 0;
+        r.payload.resize(rh.length);
+        if (rh.length && !read_full(fd, r.payload.data(), rh.length))
+            throw std::runtime_error("Server closed the connection");
+        return r;
+    }
+#else
+    void server::serve(const std::string &path, unsigned) {
+        throw std::runtime_error("Compile server is not supported on this platform: " + path);
+    }
+
+    server::Response server::request(const std::string &path, std::string_view, int, Format) {
+        throw std::runtime_error("Compile server is not supported on this platform: " + path);
+    }
+#endif
+
+} // namespace pseu
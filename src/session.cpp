@@ -0,0 +1,36 @@
+#include "session.hpp"
+
+namespace pseu {
+
+    void session::CompilationSession::reset() noexcept {
+        ast_.clear();
+        symbols_.clear();
+        ir_.code.code.clear();
+        ir_.variables.clear();
+        ir_.constants.clear();
+        ir_.temps = 0;
+        text_.clear();
+    }
+
+    void session::CompilationSession::shrink_to(std::size_t bytes) {
+        if (retained_bytes() <= bytes)
+            return;
+
+        text_.shrink_to_fit();
+        pool_.resize_pool();
+        symbols_.shrink_to_fit();
+        ast_.shrink_to_fit();
+        ir_.code.code.shrink_to_fit();
+        ir_.variables.shrink_to_fit();
+        ir_.constants.shrink_to_fit();
+    }
+
+    std::size_t session::CompilationSession::retained_bytes() const noexcept {
+        return pool_.capacity() * sizeof(ir::IRInstr) + ast_.capacity_bytes() + symbols_.capacity_bytes() +
+               text_.capacity() +
+               ir_.code.code.capacity() * sizeof(ir::ir_pool_t::ptr) +
+               ir_.variables.capacity() * sizeof(ir::Variable) +
+               ir_.constants.capacity() * sizeof(sym::SymbolId);
+    }
+
+} // namespace pseu
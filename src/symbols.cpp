@@ -0,0 +1,103 @@
+#include "symbols.hpp"
+#include <mutex>
+
+namespace pseu {
+
+    sym::SymbolTable::SymbolTable() {
+        for (auto s: known::spellings)
+            insert_locked(s);
+    }
+
+    sym::SymbolId sym::SymbolTable::insert_locked(std::string_view text) {
+        const auto &stored = storage_.emplace_back(text);
+        const auto id = static_cast<SymbolId>(count_++);
+        const auto [c, i] = slot(id);
+        auto &chunk = by_id_[c];
+        if (!chunk)
+            chunk = std::make_unique<std::string_view[]>(first_chunk << c);
+        chunk[i] = stored;
+        index_.emplace(std::string_view(stored), id);
+        return id;
+    }
+
+    sym::SymbolId sym::SymbolTable::intern(std::string_view text) {
+        {
+            std::shared_lock lock(mtx_);
+            if (auto it = index_.find(text); it != index_.end())
+                return it->second;
+        }
+
+        std::unique_lock lock(mtx_);
+        // another thread may have inserted it in between
+        if (auto it = index_.find(text); it != index_.end())
+            return it->second;
+        return insert_locked(text);
+    }
+
+    sym::SymbolId sym::SymbolTable::intern_prefixed(char prefix, std::string_view text) {
+        // per-thread scratch keeps its capacity, so steady-state interning
+        // of mangled names does not allocate
+        thread_local std::string scratch;
+        scratch.assign(1, prefix);
+        scratch.append(text);
+        return intern(scratch);
+    }
+
+    std::string_view sym::SymbolTable::view(SymbolId id) const {
+        const auto [c, i] = slot(id);
+        return by_id_[c][i];
+    }
+
+    std::size_t sym::SymbolTable::size() const {
+        std::shared_lock lock(mtx_);
+        return count_;
+    }
+
+    void sym::SymbolTable::clear() {
+        constexpr auto known_count = known::spellings.size();
+        std::unique_lock lock(mtx_);
+        std::erase_if(index_, [](const auto &e) { return e.second >= known_count; });
+        storage_.resize(known_count);
+        count_ = known_count;
+    }
+
+    void sym::SymbolTable::shrink_to_fit() {
+        std::unique_lock lock(mtx_);
+        // not storage_.shrink_to_fit(): it may move the texts the views point to,
+        // and clear() already freed the blocks of the erased ones
+        // count_ covers at least the known symbols
+        for (auto c = slot(static_cast<SymbolId>(count_ - 1)).chunk + 1; c < chunk_count && by_id_[c]; ++c)
+            by_id_[c].reset();
+        index_.rehash(0);
+    }
+
+    std::size_t sym::SymbolTable::capacity_bytes() const {
+        std::shared_lock lock(mtx_);
+        std::size_t views = 0;
+        for (unsigned c = 0; c < chunk_count && by_id_[c]; ++c)
+            views += first_chunk << c;
+        // short texts live inside the std::string; a node per entry, a pointer per bucket
+        return views * sizeof(std::string_view) + storage_.size() * sizeof(std::string) +
+               index_.size() * (sizeof(std::pair<std::string_view, SymbolId>) + 2 * sizeof(void *)) +
+               index_.bucket_count() * sizeof(void *);
+    }
+
+    namespace {
+        /// @brief Table of the innermost TableScope of this thread, if any.
+        thread_local sym::SymbolTable *scoped = nullptr;
+    }
+
+    sym::SymbolTable &sym::table() {
+        static SymbolTable t;
+        return scoped ? *scoped : t;
+    }
+
+    sym::TableScope::TableScope(SymbolTable &table) noexcept: previous_(scoped) {
+        scoped = &table;
+    }
+
+    sym::TableScope::~TableScope() {
+        scoped = previous_;
+    }
+
+} // namespace pseu
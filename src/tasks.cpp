@@ -0,0 +1,64 @@
+#include "tasks.hpp"
+#include <algorithm>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <vector>
+
+namespace pseu {
+
+    namespace {
+        /// @brief Task indices of one worker, open to thieves.
+        struct Queue final {
+            std::mutex mtx;
+            std::deque<std::size_t> items;
+
+            std::optional<std::size_t> pop_front() {
+                std::lock_guard lock(mtx);
+                if (items.empty())
+                    return std::nullopt;
+                const auto i = items.front();
+                items.pop_front();
+                return i;
+            }
+
+            std::optional<std::size_t> steal_back() {
+                std::lock_guard lock(mtx);
+                if (items.empty())
+                    return std::nullopt;
+                const auto i = items.back();
+                items.pop_back();
+                return i;
+            }
+        };
+    }
+
+    void tasks::run(std::size_t count, unsigned workers, const std::function<void(std::size_t, unsigned)> &fn) {
+        workers = static_cast<unsigned>(std::clamp<std::size_t>(workers, 1, std::max<std::size_t>(count, 1)));
+
+        const auto queues = std::make_unique<Queue[]>(workers);
+        const auto block = (count + workers - 1) / workers;
+        for (std::size_t i = 0; i < count; ++i)
+            queues[i / block].items.push_back(i);
+
+        const auto work = [&](unsigned self) {
+            for (;;) {
+                auto next = queues[self].pop_front();
+                for (unsigned k = 1; !next && k < workers; ++k)
+                    next = queues[(self + k) % workers].steal_back();
+                if (!next)
+                    return;
+                fn(*next, self);
+            }
+        };
+
+        std::vector<std::jthread> threads;
+        threads.reserve(workers - 1);
+        for (unsigned w = 1; w < workers; ++w)
+            threads.emplace_back(work, w);
+        work(0);
+    }
+
+} // namespace pseu
@@ -0,0 +1,115 @@
+#include "watch.hpp"
+#include <cstring>
+#include <filesystem>
+#include <stdexcept>
+
+#if defined(__linux__)
+#include <cerrno>
+#include <poll.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#define PSEU_HAS_INOTIFY 1
+#else
+#define PSEU_HAS_INOTIFY 0
+#endif
+
+namespace pseu {
+
+#if PSEU_HAS_INOTIFY
+    watch::Watcher::Watcher(std::vector<std::string> paths) {
+        fd_ = ::inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+        if (fd_ < 0)
+            throw std::runtime_error(std::string("inotify: ") + std::strerror(errno));
+
+        entries_.reserve(paths.size());
+        for (const auto &p: paths) {
+            const std::filesystem::path path(p);
+            const auto dir = path.parent_path().string();
+            // the same directory gives the same descriptor
+            const int wd = ::inotify_add_watch(fd_, dir.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO);
+            if (wd < 0) {
+                const auto err = std::string(std::strerror(errno));
+                ::close(fd_);
+                throw std::runtime_error("Cannot watch " + dir + ": " + err);
+            }
+            entries_.push_back({wd, path.filename().string()});
+        }
+    }
+
+    watch::Watcher::~Watcher() {
+        ::close(fd_);
+    }
+
+    void watch::Watcher::drain(std::vector<bool> &written) {
+        alignas(inotify_event) char buf[4096];
+        while (true) {
+            const auto n = ::read(fd_, buf, sizeof buf);
+            if (n < 0) {
+                if (errno == EAGAIN)
+                    return;
+                if (errno == EINTR)
+                    continue;
+                throw std::runtime_error(std::string("inotify: ") + std::strerror(errno));
+            }
+            for (ssize_t off = 0; off < n;) {
+                const auto *e = reinterpret_cast<const inotify_event *>(buf + off);
+                off += static_cast<ssize_t>(sizeof(inotify_event) + e->len);
+                if (!e->len)
+                    continue;
+                const std::string_view name(e->name); // NUL-padded
+                for (std::size_t i = 0; i < entries_.size(); ++i)
+                    if (entries_[i].wd == e->wd && entries_[i].name == name)
+                        written[i] = true;
+            }
+        }
+    }
+
+    watch::Wake watch::Watcher::wait(std::chrono::milliseconds debounce, int input_fd) {
+        Wake wake;
+        std::vector<bool> written(entries_.size());
+        bool any = false;
+
+        while (true) {
+            pollfd fds[2] = {{fd_, POLLIN, 0}, {input_fd, POLLIN, 0}};
+            // nothing written yet: wait indefinitely; otherwise until the burst is over
+            const int r = ::poll(fds, input_fd >= 0 ? 2 : 1, any ? static_cast<int>(debounce.count()) : -1);
+            if (r < 0) {
+                if (errno == EINTR)
+                    continue;
+                throw std::runtime_error(std::string("poll: ") + std::strerror(errno));
+            }
+            if (r == 0)
+                break; // quiet for a whole debounce period
+            if (fds[0].revents & POLLIN) {
+                drain(written);
+                for (const bool w: written)
+                    any = any || w;
+            }
+            if (input_fd >= 0 && (fds[1].revents & (POLLIN | POLLHUP))) {
+                wake.input = true;
+                break;
+            }
+        }
+
+        for (std::size_t i = 0; i < written.size(); ++i)
+            if (written[i])
+                wake.changed.push_back(i);
+        return wake;
+    }
+#else
+    watch::Watcher::Watcher(std::vector<std::string> paths) {
+        throw std::runtime_error("--watch is not supported on this platform" +
+                                 (paths.empty() ? std::string() : ": " + paths.front()));
+    }
+
+    watch::Watcher::~Watcher() = default;
+
+    void watch::Watcher::drain(std::vector<bool> &) {
+    }
+
+    watch::Wake watch::Watcher::wait(std::chrono::milliseconds, int) {
+        return {};
+    }
+#endif
+
+} // namespace pseu
@@ -0,0 +1,741 @@
+#include "x86.hpp"
+#include <algorithm>
+#include <array>
+#include <charconv>
+#include <limits>
+#include <optional>
+#include <stdexcept>
+
+namespace pseu {
+
+    namespace {
+        using namespace std::string_view_literals;
+
+        constexpr std::array<std::string_view, 16> reg64{
+                "rax", "rcx", "rdx", "rbx", "rsp", "rbp", "rsi", "rdi",
+                "r8", "r9", "r10", "r11", "r12", "r13", "r14", "r15"
+        };
+        constexpr std::array<std::string_view, 16> reg32{
+                "eax", "ecx", "edx", "ebx", "esp", "ebp", "esi", "edi",
+                "r8d", "r9d", "r10d", "r11d", "r12d", "r13d", "r14d", "r15d"
+        };
+        constexpr std::array<std::string_view, 16> reg16{
+                "ax", "cx", "dx", "bx", "sp", "bp", "si", "di",
+                "r8w", "r9w", "r10w", "r11w", "r12w", "r13w", "r14w", "r15w"
+        };
+        constexpr std::array<std::string_view, 16> reg8{
+                "al", "cl", "dl", "bl", "spl", "bpl", "sil", "dil",
+                "r8b", "r9b", "r10b", "r11b", "r12b", "r13b", "r14b", "r15b"
+        };
+
+        /// @brief NASM mnemonic of each x86::Op; the conditional ones without their suffix.
+        constexpr std::array<std::string_view, 42> mnemonics{
+                "add", "or", "adc", "sbb", "and", "sub", "xor", "cmp",
+                "not", "neg", "mul", "div", "idiv", "inc", "dec",
+                "rol", "ror", "shl", "shr", "sar",
+                "mov", "movzx", "movsx", "lea", "test", "xchg", "imul",
+                "push", "pop", "jmp", "call", "j", "set", "cmov",
+                "ret", "syscall", "cqo", "cdq", "nop", "movsb", "rep movsb", "rep stosb"
+        };
+
+        /// @brief Suffix of each x86::Cond.
+        constexpr std::array<std::string_view, 16> cond_names{
+                "o", "no", "b", "ae", "e", "ne", "be", "a", "s", "ns", "p", "np", "l", "ge", "le", "g"
+        };
+
+        static_assert(mnemonics.size() == static_cast<std::size_t>(x86::Op::rep_stosb) + 1);
+
+        constexpr std::uint8_t num(x86::Gpr r) { return static_cast<std::uint8_t>(r); }
+
+        std::string mnemonic(x86::Op op, x86::Cond cc) {
+            std::string s(mnemonics[static_cast<std::uint8_t>(op)]);
+            if (op == x86::Op::jcc || op == x86::Op::setcc || op == x86::Op::cmovcc)
+                s += cond_names[static_cast<std::uint8_t>(cc)];
+            return s;
+        }
+
+        [[noreturn]] void fail(const std::string &what) {
+            throw std::runtime_error(what);
+        }
+
+        bool fits8(std::int64_t v) { return v >= -128 && v <= 127; }
+
+        bool fits32(std::int64_t v) {
+            return v >= std::numeric_limits<std::int32_t>::min() && v <= std::numeric_limits<std::int32_t>::max();
+        }
+    }
+
+    // ---- Encoder ----
+
+    std::uint32_t x86::Encoder::symbol(std::string_view name) {
+        m_.symbols.push_back(Symbol{std::string(name)});
+        return static_cast<std::uint32_t>(m_.symbols.size() - 1);
+    }
+
+    void x86::Encoder::label(std::uint32_t symbol) {
+        auto &s = m_.symbols[symbol];
+        if (s.section != Section::none || is_constant(Expr{0, symbol}))
+            fail("symbol '" + s.name + "' redefined");
+        s.section = section_;
+        s.offset = here();
+    }
+
+    void x86::Encoder::constant(std::uint32_t symbol, std::int64_t value) {
+        if (m_.symbols[symbol].section != Section::none || is_constant(Expr{0, symbol}))
+            fail("symbol '" + m_.symbols[symbol].name + "' redefined");
+        if (constants_.size() <= symbol)
+            constants_.resize(symbol + 1);
+        constants_[symbol] = value;
+    }
+
+    bool x86::Encoder::is_constant(const Expr &e) const noexcept {
+        return e.symbol >= 0 && static_cast<std::uint64_t>(e.symbol) < constants_.size() && constants_[e.symbol];
+    }
+
+    void x86::Encoder::data(std::span<const std::uint8_t> bytes) {
+        if (section_ != Section::data)
+            fail("data outside .data");
+        m_.data.insert(m_.data.end(), bytes.begin(), bytes.end());
+    }
+
+    void x86::Encoder::reserve(std::uint64_t bytes) {
+        if (section_ != Section::bss)
+            fail("reservation outside .bss");
+        m_.bss_size += bytes;
+    }
+
+    std::uint64_t x86::Encoder::here() const noexcept {
+        switch (section_) {
+            case Section::text:
+                return m_.text.size();
+            case Section::data:
+                return m_.data.size();
+            default:
+                return m_.bss_size;
+        }
+    }
+
+    void x86::Encoder::bytes(std::uint64_t v, int n) {
+        for (int i = 0; i < n; ++i)
+            m_.text.push_back(static_cast<std::uint8_t>(v >> (8 * i)));
+    }
+
+    void x86::Encoder::field(const Expr &e, int n, RelocKind kind, std::int64_t addend_bias) {
+        if (e.symbol >= 0) {
+            m_.relocations.push_back(Relocation{
+                    m_.text.size(), static_cast<std::uint32_t>(e.symbol), kind, e.value + addend_bias});
+            bytes(0, n);
+        } else {
+            bytes(static_cast<std::uint64_t>(e.value), n);
+        }
+    }
+
+    /**
+     * @brief Emit prefixes, opcode, ModRM/SIB and displacement.
+     *
+     * @param reg       Register number or <code>/digit</code> for the ModRM reg field.
+     * @param imm_bytes Size of an immediate that follows, for RIP-relative addends.
+     */
+    void x86::Encoder::encode(std::initializer_list<std::uint8_t> opcode, std::uint8_t size, std::uint8_t reg,
+                              const Operand &rm, int imm_bytes, bool force_rex) {
+        if (size == 2)
+            byte(0x66);
+
+        std::uint8_t rex = 0;
+        if (size == 8)
+            rex |= 0x08;
+        if (reg & 8)
+            rex |= 0x04;
+        if (rm.kind == Operand::Kind::reg) {
+            if (num(rm.reg) & 8)
+                rex |= 0x01;
+            force_rex |= rm.needs_rex;
+        } else {
+            if (rm.index != Gpr::none && (num(rm.index) & 8))
+                rex |= 0x02;
+            if (rm.base != Gpr::none && (num(rm.base) & 8))
+                rex |= 0x01;
+        }
+        if (rex || force_rex)
+            byte(0x40 | rex);
+
+        for (auto b: opcode)
+            byte(b);
+
+        const auto r = static_cast<std::uint8_t>((reg & 7) << 3);
+        if (rm.kind == Operand::Kind::reg) {
+            byte(0xC0 | r | (num(rm.reg) & 7));
+            return;
+        }
+
+        const auto &d = rm.expr;
+        if (rm.base == Gpr::none && rm.index == Gpr::none) {
+            if (d.symbol >= 0) {
+                // [label]: RIP-relative, position independent
+                byte(0x05 | r);
+                field(d, 4, RelocKind::pc32, -4 - imm_bytes);
+            } else {
+                byte(0x04 | r);
+                byte(0x25);
+                field(d, 4, RelocKind::abs32s);
+            }
+            return;
+        }
+
+        if (d.symbol < 0 && !fits32(d.value))
+            fail("displacement out of range");
+
+        const auto base = num(rm.base);
+        std::uint8_t mod;
+        if (rm.base == Gpr::none)
+            mod = 0x00; // SIB without base always carries disp32
+        else if (d.symbol < 0 && d.value == 0 && (base & 7) != 5)
+            mod = 0x00;
+        else if (d.symbol < 0 && fits8(d.value))
+            mod = 0x40;
+        else
+            mod = 0x80;
+
+        if (rm.index == Gpr::none && (base & 7) != 4) {
+            byte(mod | r | (base & 7));
+        } else {
+            static constexpr std::uint8_t scale_bits[9] = {0, 0, 1, 0, 2, 0, 0, 0, 3};
+            byte(mod | r | 0x04);
+            byte(static_cast<std::uint8_t>(
+                         (scale_bits[rm.scale] << 6)
+                         | ((rm.index == Gpr::none ? 4 : num(rm.index) & 7) << 3)
+                         | (rm.base == Gpr::none ? 5 : base & 7)));
+        }
+
+        if (mod == 0x40)
+            bytes(static_cast<std::uint64_t>(d.value), 1);
+        else if (mod == 0x80 || rm.base == Gpr::none)
+            field(d, 4, RelocKind::abs32s);
+    }
+
+    /// @param widened Whether the CPU sign-extends the field to 64 bits.
+    void x86::Encoder::immediate(const Expr &e, int n, bool widened) {
+        if (e.symbol < 0 && n < 8) {
+            const std::int64_t lo = n == 1 ? -128 : n == 2 ? -32768 : std::numeric_limits<std::int32_t>::min();
+            const std::int64_t hi = widened ? std::numeric_limits<std::int32_t>::max()
+                                            : n == 1 ? 255 : n == 2 ? 65535
+                                                                    : std::numeric_limits<std::uint32_t>::max();
+            if (e.value < lo || e.value > hi)
+                fail("immediate out of range");
+        }
+        field(e, n, n == 8 ? RelocKind::abs64 : RelocKind::abs32s);
+    }
+
+    void x86::Encoder::branch(std::initializer_list<std::uint8_t> opcode, const Operand &target) {
+        if (target.kind != Operand::Kind::imm || target.expr.symbol < 0)
+            fail("branch target must be a label");
+        for (auto b: opcode)
+            byte(b);
+        field(target.expr, 4, RelocKind::pc32, -4);
+    }
+
+    std::uint8_t x86::Encoder::operand_size(Op op, const Operand &a, const Operand &b) const {
+        if (a.kind == Operand::Kind::reg)
+            return a.size;
+        if (b.kind == Operand::Kind::reg)
+            return b.size;
+        if (a.size)
+            return a.size;
+        fail("'" + mnemonic(op, Cond::o) + "': operation size not specified");
+    }
+
+    void x86::Encoder::expect(Op op, std::span<const Operand> ops, std::size_t n) const {
+        if (ops.size() != n)
+            fail("'" + mnemonic(op, Cond::o) + "' expects " + std::to_string(n) + " operand(s)");
+    }
+
+    void x86::Encoder::instruction(Op op, std::span<const Operand> ops, Cond cc) {
+        using K = Operand::Kind;
+
+        if (section_ != Section::text)
+            fail("instruction outside .text");
+
+        // a constant is its value, not a relocation
+        if (std::ranges::any_of(ops, [&](const Operand &o) { return is_constant(o.expr); })) {
+            std::array<Operand, 3> folded{};
+            if (ops.size() > folded.size())
+                fail("'" + mnemonic(op, cc) + "': too many operands");
+            for (std::size_t i = 0; i < ops.size(); ++i) {
+                folded[i] = ops[i];
+                if (is_constant(ops[i].expr)) {
+                    folded[i].expr.value += *constants_[ops[i].expr.symbol];
+                    folded[i].expr.symbol = -1;
+                }
+            }
+            return instruction(op, std::span<const Operand>{folded.data(), ops.size()}, cc);
+        }
+        const auto c = static_cast<std::uint8_t>(cc);
+
+        switch (op) {
+            // ---- no operands ----
+            case Op::ret: return expect(op, ops, 0), byte(0xC3);
+            case Op::syscall: return expect(op, ops, 0), byte(0x0F), byte(0x05);
+            case Op::cqo: return expect(op, ops, 0), byte(0x48), byte(0x99);
+            case Op::cdq: return expect(op, ops, 0), byte(0x99);
+            case Op::nop: return expect(op, ops, 0), byte(0x90);
+            case Op::movsb: return expect(op, ops, 0), byte(0xA4);
+            case Op::rep_movsb: return expect(op, ops, 0), byte(0xF3), byte(0xA4);
+            case Op::rep_stosb: return expect(op, ops, 0), byte(0xF3), byte(0xAA);
+
+            // ---- control flow ----
+            case Op::jmp: return expect(op, ops, 1), branch({0xE9}, ops[0]);
+            case Op::call: return expect(op, ops, 1), branch({0xE8}, ops[0]);
+            case Op::jcc: return expect(op, ops, 1), branch({0x0F, static_cast<std::uint8_t>(0x80 + c)}, ops[0]);
+
+            case Op::push:
+            case Op::pop:
+                expect(op, ops, 1);
+                if (ops[0].kind != K::reg || ops[0].size != 8)
+                    fail("'" + mnemonic(op, cc) + "' expects a 64-bit register");
+                if (num(ops[0].reg) & 8)
+                    byte(0x41);
+                return byte(static_cast<std::uint8_t>((op == Op::push ? 0x50 : 0x58) + (num(ops[0].reg) & 7)));
+
+            // ---- one operand ----
+            case Op::not_:
+            case Op::neg:
+            case Op::mul:
+            case Op::div:
+            case Op::idiv: {
+                // group 3: F6/F7 /digit
+                static constexpr std::uint8_t ext[] = {2, 3, 4, 6, 7};
+                expect(op, ops, 1);
+                const auto size = operand_size(op, ops[0], ops[0]);
+                return encode({static_cast<std::uint8_t>(size == 1 ? 0xF6 : 0xF7)}, size,
+                              ext[static_cast<std::uint8_t>(op) - static_cast<std::uint8_t>(Op::not_)], ops[0]);
+            }
+            case Op::inc:
+            case Op::dec: {
+                expect(op, ops, 1);
+                const auto size = operand_size(op, ops[0], ops[0]);
+                return encode({static_cast<std::uint8_t>(size == 1 ? 0xFE : 0xFF)}, size,
+                              op == Op::inc ? 0 : 1, ops[0]);
+            }
+            case Op::setcc:
+                expect(op, ops, 1);
+                if (operand_size(op, ops[0], ops[0]) != 1)
+                    fail("'" + mnemonic(op, cc) + "' expects a byte operand");
+                return encode({0x0F, static_cast<std::uint8_t>(0x90 + c)}, 1, 0, ops[0]);
+
+            default:
+                break;
+        }
+
+        // ---- two operands ----
+        if (ops.size() < 2)
+            fail("'" + mnemonic(op, cc) + "' expects 2 operand(s)");
+        const auto &dst = ops[0];
+        const auto &src = ops[1];
+
+        if (op == Op::imul) {
+            if (dst.kind != K::reg || dst.size == 1)
+                fail("'imul' expects a register destination");
+            if (ops.size() == 2 && src.kind != K::imm)
+                return encode({0x0F, 0xAF}, dst.size, num(dst.reg), src);
+            // imul r, imm is imul r, r, imm
+            const auto &rm = ops.size() == 3 ? src : dst;
+            const auto &imm = ops.back();
+            if (ops.size() > 3 || imm.kind != K::imm)
+                fail("'imul' expects an immediate");
+            if (imm.expr.symbol < 0 && fits8(imm.expr.value)) {
+                encode({0x6B}, dst.size, num(dst.reg), rm, 1);
+                return immediate(imm.expr, 1);
+            }
+            const auto width = dst.size == 2 ? 2 : 4;
+            encode({0x69}, dst.size, num(dst.reg), rm, width);
+            return immediate(imm.expr, width, dst.size == 8);
+        }
+
+        expect(op, ops, 2);
+        const auto imm_size = [](std::uint8_t size) { return size == 1 ? 1 : size == 2 ? 2 : 4; };
+
+        switch (op) {
+            case Op::add:
+            case Op::or_:
+            case Op::adc:
+            case Op::sbb:
+            case Op::and_:
+            case Op::sub:
+            case Op::xor_:
+            case Op::cmp: {
+                const auto ext = static_cast<std::uint8_t>(op);
+                const auto size = operand_size(op, dst, src);
+                const auto base = static_cast<std::uint8_t>(ext << 3);
+                if (src.kind == K::imm) {
+                    if (dst.kind == K::imm)
+                        fail("immediate destination");
+                    if (size == 1) {
+                        encode({0x80}, size, ext, dst, 1);
+                        return immediate(src.expr, 1);
+                    }
+                    if (src.expr.symbol < 0 && fits8(src.expr.value)) {
+                        encode({0x83}, size, ext, dst, 1);
+                        return immediate(src.expr, 1);
+                    }
+                    encode({0x81}, size, ext, dst, imm_size(size));
+                    return immediate(src.expr, imm_size(size), size == 8);
+                }
+                if (src.kind == K::reg)
+                    return encode({static_cast<std::uint8_t>(base + (size == 1 ? 0 : 1))}, size,
+                                  num(src.reg), dst, 0, src.needs_rex);
+                if (dst.kind != K::reg)
+                    fail("two memory operands");
+                return encode({static_cast<std::uint8_t>(base + (size == 1 ? 2 : 3))}, size,
+                              num(dst.reg), src, 0, dst.needs_rex);
+            }
+
+            case Op::mov: {
+                const auto size = operand_size(op, dst, src);
+                if (src.kind == K::imm) {
+                    if (dst.kind == K::reg) {
+                        const auto r = num(dst.reg);
+                        const bool small = src.expr.symbol < 0 && src.expr.value >= 0
+                                           && src.expr.value <= std::numeric_limits<std::uint32_t>::max();
+                        if (size == 8 && !small) {
+                            if (src.expr.symbol >= 0 || fits32(src.expr.value)) {
+                                encode({0xC7}, 8, 0, dst, 4);
+                                return immediate(src.expr, 4, true);
+                            }
+                            byte(static_cast<std::uint8_t>(0x48 | (r >> 3)));
+                            byte(static_cast<std::uint8_t>(0xB8 + (r & 7)));
+                            return immediate(src.expr, 8);
+                        }
+                        // mov r32, imm32 zero-extends into the full register
+                        const auto width = size == 8 ? 4 : size;
+                        if (size == 2)
+                            byte(0x66);
+                        if ((r & 8) || dst.needs_rex)
+                            byte(static_cast<std::uint8_t>(0x40 | (r >> 3)));
+                        byte(static_cast<std::uint8_t>((size == 1 ? 0xB0 : 0xB8) + (r & 7)));
+                        return immediate(src.expr, width);
+                    }
+                    if (dst.kind != K::mem)
+                        fail("immediate destination");
+                    encode({static_cast<std::uint8_t>(size == 1 ? 0xC6 : 0xC7)}, size, 0, dst, imm_size(size));
+                    return immediate(src.expr, imm_size(size), size == 8);
+                }
+                if (src.kind == K::reg)
+                    return encode({static_cast<std::uint8_t>(size == 1 ? 0x88 : 0x89)}, size,
+                                  num(src.reg), dst, 0, src.needs_rex);
+                if (dst.kind != K::reg)
+                    fail("two memory operands");
+                return encode({static_cast<std::uint8_t>(size == 1 ? 0x8A : 0x8B)}, size,
+                              num(dst.reg), src, 0, dst.needs_rex);
+            }
+
+            case Op::test: {
+                const auto size = operand_size(op, dst, src);
+                if (src.kind == K::imm) {
+                    encode({static_cast<std::uint8_t>(size == 1 ? 0xF6 : 0xF7)}, size, 0, dst, imm_size(size));
+                    return immediate(src.expr, imm_size(size), size == 8);
+                }
+                if (src.kind != K::reg)
+                    fail("'test' expects a register or immediate source");
+                return encode({static_cast<std::uint8_t>(size == 1 ? 0x84 : 0x85)}, size,
+                              num(src.reg), dst, 0, src.needs_rex);
+            }
+
+            case Op::xchg: {
+                const auto &r = src.kind == K::reg ? src : dst;
+                const auto &rm = src.kind == K::reg ? dst : src;
+                if (r.kind != K::reg)
+                    fail("'xchg' expects a register");
+                return encode({static_cast<std::uint8_t>(r.size == 1 ? 0x86 : 0x87)}, r.size, num(r.reg), rm);
+            }
+
+            case Op::lea:
+                if (dst.kind != K::reg || src.kind != K::mem)
+                    fail("'lea' expects a register and an address");
+                return encode({0x8D}, dst.size, num(dst.reg), src);
+
+            case Op::movzx:
+            case Op::movsx: {
+                if (dst.kind != K::reg || src.kind == K::imm || (src.size != 1 && src.size != 2))
+                    fail("'" + mnemonic(op, cc) + "' expects a register and a byte or word source");
+                const std::uint8_t code = (op == Op::movzx ? 0xB6 : 0xBE) + (src.size == 2 ? 1 : 0);
+                return encode({0x0F, code}, dst.size, num(dst.reg), src, 0, src.kind == K::reg && src.needs_rex);
+            }
+
+            case Op::cmovcc:
+                if (dst.kind != K::reg || src.kind == K::imm)
+                    fail("'" + mnemonic(op, cc) + "' expects a register destination");
+                return encode({0x0F, static_cast<std::uint8_t>(0x40 + c)}, dst.size, num(dst.reg), src);
+
+            case Op::rol:
+            case Op::ror:
+            case Op::shl:
+            case Op::shr:
+            case Op::sar: {
+                // C0/C1 /digit ib, or D2/D3 /digit by cl
+                static constexpr std::uint8_t ext[] = {0, 1, 4, 5, 7};
+                const auto digit = ext[static_cast<std::uint8_t>(op) - static_cast<std::uint8_t>(Op::rol)];
+                const auto size = operand_size(op, dst, dst);
+                if (src.kind == K::reg && src.reg == Gpr::rcx && src.size == 1)
+                    return encode({static_cast<std::uint8_t>(size == 1 ? 0xD2 : 0xD3)}, size, digit, dst);
+                if (src.kind != K::imm || src.expr.symbol >= 0)
+                    fail("shift count must be a constant or cl");
+                encode({static_cast<std::uint8_t>(size == 1 ? 0xC0 : 0xC1)}, size, digit, dst, 1);
+                return immediate(src.expr, 1);
+            }
+
+            default:
+                fail("unsupported operands for '" + mnemonic(op, cc) + "'");
+        }
+    }
+
+    x86::Module x86::Encoder::finish() {
+        for (std::uint32_t i = 0; i < m_.symbols.size(); ++i)
+            if (m_.symbols[i].section == Section::none && !is_constant(Expr{0, i}))
+                fail("undefined symbol '" + m_.symbols[i].name + "'");
+
+        // constants were folded into the code: drop them, as the assembler does
+        if (!constants_.empty()) {
+            std::vector<std::uint32_t> index(m_.symbols.size());
+            std::uint32_t n = 0;
+            for (std::uint32_t i = 0; i < m_.symbols.size(); ++i) {
+                index[i] = n;
+                if (is_constant(Expr{0, i}))
+                    continue;
+                if (n != i)
+                    m_.symbols[n] = std::move(m_.symbols[i]);
+                ++n;
+            }
+            m_.symbols.resize(n);
+            for (auto &r: m_.relocations)
+                r.symbol = index[r.symbol];
+            constants_.clear();
+        }
+
+        // branches within .text no longer need the linker
+        std::erase_if(m_.relocations, [&](const Relocation &r) {
+            const auto &s = m_.symbols[r.symbol];
+            if (r.kind != RelocKind::pc32 || s.section != Section::text)
+                return false;
+            const auto v = static_cast<std::int64_t>(s.offset) + r.addend - static_cast<std::int64_t>(r.offset);
+            for (int i = 0; i < 4; ++i)
+                m_.text[r.offset + i] = static_cast<std::uint8_t>(static_cast<std::uint64_t>(v) >> (8 * i));
+            return true;
+        });
+        return std::move(m_);
+    }
+
+    // ---- NasmWriter ----
+
+    std::uint32_t x86::NasmWriter::symbol(std::string_view name) {
+        names_.append(name);
+        offsets_.push_back(static_cast<std::uint32_t>(names_.size()));
+        return static_cast<std::uint32_t>(offsets_.size() - 1);
+    }
+
+    void x86::NasmWriter::number(std::int64_t v) {
+        char buf[21];
+        auto [end, ec] = std::to_chars(buf, buf + sizeof(buf), v);
+        out_.insert(out_.end(), buf, end);
+    }
+
+    void x86::NasmWriter::name(std::uint32_t symbol) {
+        const auto full = [&](std::uint32_t s) {
+            const auto begin = s ? offsets_[s - 1] : 0;
+            return std::string_view(names_).substr(begin, offsets_[s] - begin);
+        };
+        auto n = full(symbol);
+        if (scope_ != no_scope) {
+            // "print_num.loop" inside print_num is ".loop"
+            const auto scope = full(scope_);
+            if (n.size() > scope.size() && n.starts_with(scope) && n[scope.size()] == '.')
+                n.remove_prefix(scope.size());
+        }
+        put(n);
+    }
+
+    void x86::NasmWriter::pending_label() {
+        put("\t"sv);
+        if (pending_ >= 0) {
+            name(static_cast<std::uint32_t>(pending_));
+            put(" "sv);
+            pending_ = -1;
+        }
+    }
+
+    void x86::NasmWriter::flush_label() {
+        if (pending_ >= 0) {
+            name(static_cast<std::uint32_t>(pending_));
+            put(":\n"sv);
+            pending_ = -1;
+        }
+    }
+
+    void x86::NasmWriter::section(Section s) {
+        flush_label();
+        if (section_ != Section::none)
+            put("\n"sv);
+        put(s == Section::text ? "section .text\n"sv : s == Section::data ? "section .data\n"sv : "section .bss\n"sv);
+        section_ = s;
+    }
+
+    void x86::NasmWriter::label(std::uint32_t symbol) {
+        if (section_ != Section::text) {
+            // "\tS1 db ..." / "\tT1 resb 8"
+            flush_label();
+            pending_ = symbol;
+            return;
+        }
+        const auto begin = symbol ? offsets_[symbol - 1] : 0;
+        if (std::string_view(names_).substr(begin, offsets_[symbol] - begin).find('.') == std::string_view::npos)
+            scope_ = symbol;
+        put("\n"sv);
+        name(symbol);
+        put(":\n"sv);
+    }
+
+    void x86::NasmWriter::global(std::uint32_t symbol) {
+        put("\tglobal "sv);
+        name(symbol);
+        put("\n"sv);
+    }
+
+    void x86::NasmWriter::constant(std::uint32_t symbol, std::int64_t value) {
+        // "\tS1_len equ 6"
+        flush_label();
+        put("\t"sv);
+        name(symbol);
+        put(" equ "sv);
+        number(value);
+        put("\n"sv);
+    }
+
+    void x86::NasmWriter::data(std::span<const std::uint8_t> bytes) {
+        constexpr std::size_t per_line = 32;
+        for (std::size_t i = 0; i < bytes.size(); i += per_line) {
+            pending_label();
+            put("db "sv);
+            for (std::size_t k = i; k < std::min(bytes.size(), i + per_line); ++k) {
+                if (k != i)
+                    put(", "sv);
+                number(bytes[k]);
+            }
+            put("\n"sv);
+        }
+    }
+
+    void x86::NasmWriter::reserve(std::uint64_t bytes) {
+        pending_label();
+        put("resb "sv);
+        number(static_cast<std::int64_t>(bytes));
+        put("\n"sv);
+    }
+
+    void x86::NasmWriter::operand(const Operand &o, bool sized) {
+        switch (o.kind) {
+            case Operand::Kind::reg: {
+                const auto &names = o.size == 8 ? reg64 : o.size == 4 ? reg32 : o.size == 2 ? reg16 : reg8;
+                put(names[num(o.reg)]);
+                return;
+            }
+            case Operand::Kind::imm:
+                if (o.expr.symbol < 0)
+                    return number(o.expr.value);
+                name(static_cast<std::uint32_t>(o.expr.symbol));
+                if (o.expr.value)
+                    put(" + "sv), number(o.expr.value);
+                return;
+            case Operand::Kind::mem:
+                break;
+        }
+
+        if (sized && o.size)
+            put(o.size == 8 ? "qword "sv : o.size == 4 ? "dword "sv : o.size == 2 ? "word "sv : "byte "sv);
+        put("["sv);
+        bool first = true;
+        const auto term = [&](std::string_view s) {
+            if (!first)
+                put(" + "sv);
+            put(s);
+            first = false;
+        };
+        if (o.expr.symbol >= 0) {
+            if (o.base == Gpr::none && o.index == Gpr::none)
+                put("rel "sv);
+            name(static_cast<std::uint32_t>(o.expr.symbol));
+            first = false;
+        }
+        if (o.base != Gpr::none)
+            term(reg64[num(o.base)]);
+        if (o.index != Gpr::none) {
+            term(reg64[num(o.index)]);
+            if (o.scale != 1)
+                put("*"sv), number(o.scale);
+        }
+        if (first) {
+            number(o.expr.value);
+        } else if (o.expr.value) {
+            put(o.expr.value < 0 ? " - "sv : " + "sv);
+            char buf[21];
+            const auto v = o.expr.value < 0 ? 0 - static_cast<std::uint64_t>(o.expr.value)
+                                            : static_cast<std::uint64_t>(o.expr.value);
+            auto [end, ec] = std::to_chars(buf, buf + sizeof(buf), v);
+            out_.insert(out_.end(), buf, end);
+        }
+        put("]"sv);
+    }
+
+    void x86::NasmWriter::instruction(Op op, std::span<const Operand> ops, Cond cc) {
+        put("\t"sv);
+        put(mnemonics[static_cast<std::uint8_t>(op)]);
+        if (op == Op::jcc || op == Op::setcc || op == Op::cmovcc)
+            put(cond_names[static_cast<std::uint8_t>(cc)]);
+
+        // a size keyword only where no register gives it
+        bool sized = op == Op::movzx || op == Op::movsx;
+        if (!sized) {
+            sized = true;
+            for (const auto &o: ops)
+                sized &= o.kind != Operand::Kind::reg;
+        }
+        for (std::size_t i = 0; i < ops.size(); ++i) {
+            put(i ? ", "sv : " "sv);
+            operand(ops[i], sized);
+        }
+        put("\n"sv);
+    }
+
+    std::int64_t x86::Module::find(std::string_view name) const noexcept {
+        for (std::size_t i = 0; i < symbols.size(); ++i)
+            if (symbols[i].name == name)
+                return static_cast<std::int64_t>(i);
+        return -1;
+    }
+
+    std::uint64_t x86::Layout::address(const Symbol &s) const noexcept {
+        switch (s.section) {
+            case Section::text:
+                return text + s.offset;
+            case Section::data:
+                return data + s.offset;
+            default:
+                return bss + s.offset;
+        }
+    }
+
+    void x86::relocate(const Module &m, const Layout &layout, std::span<std::uint8_t> text) {
+        for (const auto &r: m.relocations) {
+            const auto target = static_cast<std::int64_t>(layout.address(m.symbols[r.symbol])) + r.addend;
+            auto v = target;
+            int n = 4;
+            if (r.kind == RelocKind::pc32)
+                v = target - static_cast<std::int64_t>(layout.text + r.offset);
+            else if (r.kind == RelocKind::abs64)
+                n = 8;
+            if (n == 4 && !fits32(v))
+                throw std::runtime_error("Relocation out of range for " + m.symbols[r.symbol].name);
+            for (int i = 0; i < n; ++i)
+                text[r.offset + i] = static_cast<std::uint8_t>(static_cast<std::uint64_t>(v) >> (8 * i));
+        }
+    }
+
+} // namespace pseu